@@ -0,0 +1,224 @@
+/*
+ * Bounded Banner Grab
+ * Author: Alushi
+ * Description:
+ *   - See banner_grab.h.
+ */
+
+#include "banner_grab.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// ---------- BUFFER POOL ----------
+BufferPool::BufferPool(size_t bufferSize, size_t count)
+    : bufferSize_(bufferSize), block_(bufferSize * count) {
+    free_.reserve(count);
+    for (size_t i = 0; i < count; i++) free_.push_back(block_.data() + i * bufferSize);
+}
+
+BufferPool::Lease BufferPool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) return Lease();
+    char* data = free_.back();
+    free_.pop_back();
+    return Lease(this, data);
+}
+
+void BufferPool::release(char* data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(data);
+}
+
+BufferPool& bannerBufferPool() {
+    static BufferPool pool(1024, 64);
+    return pool;
+}
+
+// ---------- SIGNATURE TABLE ----------
+namespace {
+
+struct BannerSignature {
+    const char* service;
+    const char* prefix;         // Bytes expected at 'offset'
+    size_t prefixLen;
+    size_t offset;
+    const char* contains;       // Optional token that must also appear (case-sensitive)
+    bool (*valid)(const char* data, size_t len);    // Optional structural check of binary banners
+};
+
+// MySQL greeting: 3-byte little-endian payload length, sequence 0, protocol 10, then a
+// NUL-terminated printable server version ("8.0.36", "5.5.5-10.11.6-MariaDB")
+bool validMysqlGreeting(const char* data, size_t len) {
+    const unsigned char* d = (const unsigned char*)data;
+    if (len < 6) return false;
+    size_t payload = d[0] | (size_t)d[1] << 8 | (size_t)d[2] << 16;
+    if (d[3] != 0 || payload < 18 || payload > 1024) return false;   // Far larger than any real greeting
+    if (d[5] < '0' || d[5] > '9') return false;
+    size_t end = std::min(len, 4 + payload);
+    for (size_t i = 6; i < end; i++) {
+        if (d[i] == 0) return i - 5 <= 64;
+        if (d[i] < 0x20 || d[i] >= 0x7f) return false;
+    }
+    return false;               // Version not terminated inside what was read
+}
+
+#define SIG(name, prefix, offset, contains) { name, prefix, sizeof(prefix) - 1, offset, contains, nullptr }
+#define SIG_CHECKED(name, prefix, offset, valid) { name, prefix, sizeof(prefix) - 1, offset, nullptr, valid }
+
+// Order matters within a first-byte bucket: more specific entries first
+const BannerSignature kSignatures[] = {
+    SIG("SSH",        "SSH-",           0, nullptr),
+    SIG("SMTP",       "220",            0, "SMTP"),
+    SIG("FTP",        "220",            0, "FTP"),
+    SIG("SMTP",       "220",            0, "mail"),
+    SIG("FTP/SMTP",   "220",            0, nullptr),
+    SIG("HTTP",       "HTTP/1.",        0, nullptr),
+    SIG("HTTP",       "HTTP/2",         0, nullptr),
+    SIG("HTTP",       "<!DOCTYPE",      0, nullptr),    // HTTP/0.9-style error page for the nudge
+    SIG("HTTP",       "<html",          0, nullptr),
+    SIG("Redis",      "+PONG",          0, nullptr),
+    SIG("Redis",      "-NOAUTH",        0, nullptr),
+    SIG("Redis",      "-ERR",           0, "command"),
+    SIG("POP3",       "+OK",            0, nullptr),
+    SIG("IMAP",       "* OK",           0, nullptr),
+    SIG("VNC",        "RFB ",           0, nullptr),
+    SIG_CHECKED("MySQL", "\x0a",        4, validMysqlGreeting),     // Protocol v10 after the packet header
+    SIG("TLS",        "\x15\x03",       0, nullptr),    // Alert record in reply to plaintext
+    SIG("Telnet",     "\xff",           0, nullptr),    // IAC negotiation
+    SIG("AMQP",       "AMQP",           0, nullptr),
+};
+
+#undef SIG
+#undef SIG_CHECKED
+
+// Compiled once: offset-0 signatures bucketed by first byte (table order kept), the rest listed
+struct CompiledSignatures {
+    std::array<std::vector<unsigned char>, 256> byFirstByte;
+    std::vector<unsigned char> withOffset;
+    CompiledSignatures() {
+        for (size_t i = 0; i < sizeof(kSignatures) / sizeof(kSignatures[0]); i++) {
+            const BannerSignature& s = kSignatures[i];
+            if (s.offset == 0) byFirstByte[(unsigned char)s.prefix[0]].push_back((unsigned char)i);
+            else withOffset.push_back((unsigned char)i);
+        }
+    }
+};
+
+const CompiledSignatures& compiled() {
+    static const CompiledSignatures table;
+    return table;
+}
+
+bool matches(const BannerSignature& s, const char* data, size_t len) {
+    if (len < s.offset + s.prefixLen) return false;
+    if (std::memcmp(data + s.offset, s.prefix, s.prefixLen) != 0) return false;
+    if (s.valid && !s.valid(data, len)) return false;
+    if (!s.contains) return true;
+    size_t n = std::strlen(s.contains);
+    for (size_t i = 0; i + n <= len; i++)
+        if (std::memcmp(data + i, s.contains, n) == 0) return true;
+    return false;
+}
+
+std::string printableFirstLine(const char* data, size_t len) {
+    std::string out;
+    for (size_t i = 0; i < len && out.size() < 120; i++) {
+        unsigned char c = (unsigned char)data[i];
+        if (c == '\r' || c == '\n') {
+            if (!out.empty()) break;
+            continue;
+        }
+        if (c >= 0x20 && c < 0x7f) {
+            out += (char)c;
+        }
+        else {
+            char hex[5];
+            std::snprintf(hex, sizeof(hex), "\\x%02x", c);
+            out += hex;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+const char* matchBannerSignature(const char* data, size_t len) {
+    if (len == 0) return nullptr;
+    const CompiledSignatures& table = compiled();
+
+    for (unsigned char idx : table.byFirstByte[(unsigned char)data[0]])
+        if (matches(kSignatures[idx], data, len)) return kSignatures[idx].service;
+
+    // Binary protocols with a length header; only a handful, checked linearly
+    for (unsigned char idx : table.withOffset)
+        if (matches(kSignatures[idx], data, len)) return kSignatures[idx].service;
+    return nullptr;
+}
+
+// ---------- GRAB ----------
+BannerResult grabBannerOn(socket_t s, const BannerOptions& opts) {
+    BannerResult res;
+    res.connected = true;
+
+    // Pool exhausted (more grabs in flight than buffers): fall back to a one-off heap buffer
+    // rather than report an open port as having no banner
+    BufferPool::Lease lease = bannerBufferPool().acquire();
+    std::vector<char> overflow;
+    if (!lease.data()) overflow.resize(bannerBufferPool().bufferSize());
+    char* const data = lease.data() ? lease.data() : overflow.data();
+    const size_t size = lease.data() ? lease.size() : overflow.size();
+
+    const size_t cap = opts.maxBytes < size ? opts.maxBytes : size;
+    const auto start = std::chrono::steady_clock::now();
+    size_t used = 0;
+
+    while (used < cap) {
+        int left = opts.deadlineMs - (int)elapsedMs(start);
+        if (left <= 0) break;
+
+        // Wait for the server to speak first; nudge once if it stays quiet
+        bool canNudge = !res.nudged && used == 0 && opts.quietMs >= 0;
+        int wait = left;
+        if (canNudge) {
+            int quietLeft = opts.quietMs - (int)elapsedMs(start);
+            wait = quietLeft < left ? (quietLeft > 0 ? quietLeft : 0) : left;
+        }
+
+        if (!waitSocket(s, false, wait)) {
+            if (!canNudge) break;
+            static const char nudge[] = "PING\r\n";
+            send(s, nudge, (int)(sizeof(nudge) - 1), kSendFlags);
+            res.nudged = true;
+            continue;
+        }
+
+        int n = recv(s, data + used, (int)(cap - used), 0);
+        if (n < 0 && wouldBlock()) continue;
+        if (n <= 0) break;
+        used += n;
+
+        // One complete line is enough to identify nearly every text protocol
+        if (std::memchr(data, '\n', used)) break;
+    }
+
+    res.bytes = used;
+    res.elapsedMs = elapsedMs(start);
+    if (used > 0) {
+        const char* svc = matchBannerSignature(data, used);
+        if (svc) res.service = svc;
+        res.banner = printableFirstLine(data, used);
+    }
+    return res;
+}
+
+BannerResult grabBanner(const std::string& ip, int port, int connectTimeoutMs, const BannerOptions& opts) {
+    socket_t s = connectWithTimeout(ip, port, connectTimeoutMs);
+    if (s == kInvalidSocket) return BannerResult{};
+    BannerResult res = grabBannerOn(s, opts);
+    closeSocket(s);
+    return res;
+}
@@ -0,0 +1,85 @@
+/*
+ * Bounded Banner Grab
+ * Author: Alushi
+ * Description:
+ *   - After a successful connect, reads up to N bytes within a deadline.
+ *   - Receive buffers come from a fixed pool (one allocation up front, none per probe); grabs
+ *     beyond the pool's size use a heap buffer of the same size instead.
+ *   - The banner is identified against a signature table compiled once into a first-byte index.
+ *   - Client-speaks-first services (HTTP, Redis) are nudged with "PING\r\n" after a quiet period.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "socket_util.h"
+
+// ---------- BUFFER POOL ----------
+// Fixed number of fixed-size buffers carved from one block; acquire/release is a free-list pop/push
+class BufferPool {
+public:
+    BufferPool(size_t bufferSize, size_t count);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // RAII lease; empty (data() == nullptr) when the pool is exhausted
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(BufferPool* pool, char* data) : pool_(pool), data_(data) {}
+        Lease(Lease&& o) noexcept : pool_(o.pool_), data_(o.data_) { o.data_ = nullptr; }
+        Lease& operator=(Lease&&) = delete;
+        ~Lease() { if (data_) pool_->release(data_); }
+
+        char* data() const { return data_; }
+        size_t size() const { return pool_ ? pool_->bufferSize_ : 0; }
+
+    private:
+        BufferPool* pool_ = nullptr;
+        char* data_ = nullptr;
+    };
+
+    Lease acquire();
+    size_t bufferSize() const { return bufferSize_; }
+
+private:
+    void release(char* data);
+
+    size_t bufferSize_;
+    std::vector<char> block_;
+    std::vector<char*> free_;
+    std::mutex mutex_;
+};
+
+// ---------- BANNER GRAB ----------
+struct BannerOptions {
+    size_t maxBytes = 512;      // Read cap; clamped to the pool's buffer size
+    int deadlineMs = 1500;      // Total time allowed after connect
+    int quietMs = 500;          // Silence before sending the "PING\r\n" nudge; < 0 disables it
+};
+
+struct BannerResult {
+    bool connected = false;
+    std::string service;        // Matched signature name, empty if unknown or silent
+    std::string banner;         // First line, non-printables escaped
+    size_t bytes = 0;
+    bool nudged = false;        // Banner came back only after the nudge
+    double elapsedMs = 0.0;
+};
+
+// Identifies a banner against the compiled signature table; returns nullptr if nothing matches
+const char* matchBannerSignature(const char* data, size_t len);
+
+// Grabs from an already connected non-blocking socket (caller keeps ownership)
+BannerResult grabBannerOn(socket_t s, const BannerOptions& opts = {});
+
+// Connects, grabs and closes
+BannerResult grabBanner(const std::string& ip, int port, int connectTimeoutMs, const BannerOptions& opts = {});
+
+// Shared pool used by the grab functions (64 x 1 KiB)
+BufferPool& bannerBufferPool();
@@ -0,0 +1,247 @@
+/*
+ * Batch Probe Mode
+ * Author: Alushi
+ * Description:
+ *   - See batch_mode.h.
+ */
+
+#include "batch_mode.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "perf_counters.h"
+#include "port_map.h"
+#include "probe_engine.h"
+#include "socket_util.h"
+#include "target_spec.h"
+
+namespace {
+
+// Fixed buffer in front of a FILE*; formats records in place and writes only when full
+class NdjsonWriter {
+public:
+    explicit NdjsonWriter(FILE* out) : out_(out) {}
+    ~NdjsonWriter() { flush(); }
+
+    void write(uint32_t addr, uint16_t port, ProbeStatus status, float rttMs, int64_t unixMs) {
+        if (sizeof(buf_) - used_ < kMaxRecord) flush();
+
+        char ip[INET_ADDRSTRLEN] = "?";
+        in_addr a{};
+        a.s_addr = addr;
+        inet_ntop(AF_INET, &a, ip, sizeof(ip));
+
+        int n = std::snprintf(buf_ + used_, sizeof(buf_) - used_,
+            "{\"ip\":\"%s\",\"port\":%u,\"status\":\"%s\",\"rtt_ms\":%.3f,\"ts\":%lld}\n",
+            ip, (unsigned)port, probeStatusName(status), (double)rttMs, (long long)unixMs);
+        if (n > 0) used_ += (size_t)n;
+    }
+
+    void flush() {
+        if (used_ && std::fwrite(buf_, 1, used_, out_) != used_) failed_ = true;
+        used_ = 0;
+        std::fflush(out_);
+    }
+
+    bool failed() const { return failed_; }
+
+private:
+    static const size_t kMaxRecord = 128;   // Longest possible line is well under this
+
+    FILE* out_;
+    char buf_[64 * 1024];
+    size_t used_ = 0;
+    bool failed_ = false;
+};
+
+std::string hostOrderIp(uint32_t addr) {
+    char ip[INET_ADDRSTRLEN] = "?";
+    in_addr a{};
+    a.s_addr = htonl(addr);
+    inet_ntop(AF_INET, &a, ip, sizeof(ip));
+    return ip;
+}
+
+std::string joinPorts(const std::vector<uint16_t>& ports, const char* sep) {
+    std::string out;
+    for (size_t i = 0; i < ports.size(); i++) {
+        if (i) out += sep;
+        out += std::to_string(ports[i]);
+    }
+    return out;
+}
+
+// Diffs this run's map against the stored one, reports the changes, then stores the new map
+bool updateExposure(const std::string& path, PortMap& current, int64_t nowUnixMs) {
+    PortMap previous;
+    int64_t previousUnixMs = 0;
+    bool hadPrevious = std::ifstream(path).good();
+    if (hadPrevious && !previous.loadFile(path, &previousUnixMs)) {
+        std::cerr << "[!] " << path << " is not an open-port map; left untouched\n";
+        return false;
+    }
+
+    if (hadPrevious) {
+        PortMapDiffStats d = diffPortMaps(previous, current, [](const PortMapChange& c) {
+            std::cerr << "[Exposure] " << hostOrderIp(c.addr) << (c.newHost ? " (new host)" : "");
+            if (!c.opened.empty()) std::cerr << " opened " << joinPorts(c.opened, ",");
+            if (!c.closed.empty()) std::cerr << " closed " << joinPorts(c.closed, ",");
+            std::cerr << "\n";
+        });
+        std::cerr << "[Exposure] Since the run " << (nowUnixMs - previousUnixMs) / 1000 << " s ago: +" << d.opened
+            << " opened, -" << d.closed << " closed on " << d.hostsChanged << " of " << d.hostsCompared << " hosts, "
+            << d.hostsAdded << " new hosts, " << d.hostsMissing << " not scanned this time (diffed in " << d.ms << " ms)\n";
+    }
+
+    if (!current.saveFile(path, nowUnixMs)) {
+        std::cerr << "[!] Could not write " << path << "\n";
+        return false;
+    }
+    std::cerr << "[Exposure] Saved " << current.hosts() << " hosts, " << current.openPorts() << " open ports to " << path
+        << " (" << current.memoryBytes() / 1024 << " KB: " << current.hostsWith(PortContainerKind::Array) << " array, "
+        << current.hostsWith(PortContainerKind::Run) << " run, " << current.hostsWith(PortContainerKind::Bitmap) << " bitmap)\n";
+    return true;
+}
+
+int64_t unixMsNow() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+int runBatch(const BatchOptions& opts) {
+    std::ifstream file;
+    if (opts.input != "-") {
+        file.open(opts.input);
+        if (!file) {
+            std::cerr << "[!] Could not open target file " << opts.input << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = opts.input == "-" ? std::cin : file;
+
+    FILE* out = stdout;
+    if (opts.output != "-") {
+        out = std::fopen(opts.output.c_str(), "wb");
+        if (!out) {
+            std::cerr << "[!] Could not create " << opts.output << "\n";
+            return 1;
+        }
+    }
+
+    ResultLogWriter log;
+    if (!opts.logPath.empty() && !log.open(opts.logPath)) {
+        std::cerr << "[!] Could not open result log " << opts.logPath << "\n";
+        if (out != stdout) std::fclose(out);
+        return 1;
+    }
+
+    TargetSpecReader reader(in, opts.defaultPorts);
+#ifdef __linux__
+    ProbeEngine engine(ProbeBackend::Epoll, opts.window, opts.timeoutMs);
+#else
+    ProbeEngine engine(ProbeBackend::Select, opts.window, opts.timeoutMs);
+#endif
+    PerfAccumulator perf;
+    engine.setPerfSink(&perf);
+
+    bool exposure = !opts.exposurePath.empty();
+    PortMapBuilder openPorts;
+    uint64_t counts[4] = {};
+    uint64_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    bool writeFailed;
+    {
+        auto writer = std::unique_ptr<NdjsonWriter>(new NdjsonWriter(out));  // 64 KB, keep it off the stack
+        engine.run([&](ProbeTarget& t) { return reader.next(t); }, [&](const ProbeResult& r) {
+            int64_t now = unixMsNow();
+            writer->write(r.target.addr, r.target.port, r.status, r.rttMs, now);
+            log.append(r.target.addr, r.target.port, r.status, r.rttMs, now);
+            counts[(int)r.status]++;
+            total++;
+            if (!exposure) return;
+            // Only an answer proves the host was up; a timeout could be a host that is down
+            if (r.status == ProbeStatus::Open) openPorts.open(ntohl(r.target.addr), r.target.port);
+            else if (r.status == ProbeStatus::Closed) openPorts.scanned(ntohl(r.target.addr));
+        });
+        writer->flush();
+        writeFailed = writer->failed();
+    }
+    if (out != stdout) std::fclose(out);
+    log.close();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "[Batch] " << total << " targets from " << reader.specs() << " specs in " << secs << " s"
+        << " (open " << counts[(int)ProbeStatus::Open] << ", closed " << counts[(int)ProbeStatus::Closed]
+        << ", timeout " << counts[(int)ProbeStatus::Timeout] << ", error " << counts[(int)ProbeStatus::Error]
+        << ", " << (secs > 0 ? (uint64_t)(total / secs) : total) << "/s)\n";
+    if (perfEnabled()) std::cerr << "[PERF] batch engine: " << perf.snapshot() << "\n";
+    if (reader.badSpecs())
+        std::cerr << "[!] Skipped " << reader.badSpecs() << " malformed specs (last: " << reader.lastError() << ")\n";
+
+    if (exposure) {
+        PortMap current = openPorts.build();
+        if (!updateExposure(opts.exposurePath, current, unixMsNow())) return 1;
+    }
+
+    if (writeFailed) {
+        std::cerr << "[!] Writing results failed.\n";
+        return 1;
+    }
+    return reader.badSpecs() ? 2 : 0;
+}
+
+int runLogDump(const std::string& path, const ResultLogQuery& q) {
+    ResultLogReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "[!] " << path << " is missing or not a result log\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t matches;
+    {
+        auto writer = std::unique_ptr<NdjsonWriter>(new NdjsonWriter(stdout));
+        matches = reader.query(q, [&](const ResultLogEntry& e) {
+            writer->write(e.addr, e.port, e.status, e.rttMs, e.unixMs);
+        });
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "[Log] " << matches << " of " << reader.records() << " results, decoded "
+        << reader.blocksDecoded() << "/" << reader.blocks() << " blocks in " << ms << " ms"
+        << (reader.recovered() ? " (no footer, index rebuilt)" : "") << "\n";
+    return 0;
+}
+
+int runExposureDiff(const std::string& before, const std::string& after) {
+    PortMap maps[2];
+    const std::string* paths[2] = { &before, &after };
+    for (int i = 0; i < 2; i++) {
+        if (!maps[i].loadFile(*paths[i])) {
+            std::cerr << "[!] " << *paths[i] << " is missing or not an open-port map\n";
+            return 1;
+        }
+    }
+
+    std::string out;
+    PortMapDiffStats d = diffPortMaps(maps[0], maps[1], [&](const PortMapChange& c) {
+        out += "{\"ip\":\"" + hostOrderIp(c.addr) + "\",\"new_host\":" + (c.newHost ? "true" : "false")
+            + ",\"opened\":[" + joinPorts(c.opened, ",") + "],\"closed\":[" + joinPorts(c.closed, ",") + "]}\n";
+        if (out.size() >= 64 * 1024) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    });
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    std::fflush(stdout);
+    std::cerr << "[Exposure] +" << d.opened << " opened, -" << d.closed << " closed on " << d.hostsChanged << " of "
+        << d.hostsCompared << " hosts, " << d.hostsAdded << " new, " << d.hostsMissing << " only in " << before
+        << " (diffed in " << d.ms << " ms)\n";
+    return 0;
+}
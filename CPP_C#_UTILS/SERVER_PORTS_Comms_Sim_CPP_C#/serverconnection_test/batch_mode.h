@@ -0,0 +1,46 @@
+/*
+ * Batch Probe Mode
+ * Author: Alushi
+ * Description:
+ *   - Non-interactive run: reads target specs (target_spec.h) from a file or stdin, probes them
+ *     through the concurrent engine and writes one NDJSON record per target:
+ *       {"ip":"10.0.0.1","port":443,"status":"open","rtt_ms":1.84,"ts":1760000000000}
+ *   - Streams end to end: targets are pulled as window slots free up and records go through a
+ *     64 KB buffer, so memory stays flat no matter how large the input is.
+ *   - Records come out in completion order; a "[Batch] ..." summary goes to stderr.
+ *   - With a result log (result_log.h) every result is also appended there, and
+ *     runLogDump() turns a filtered slice of such a log back into the same NDJSON.
+ *   - With an exposure file the open ports of the run are packed into a port map (port_map.h);
+ *     the ports opened and closed since the previous run's map go to stderr as "[Exposure] ..."
+ *     lines, then the new map replaces the old one. runExposureDiff() compares two saved
+ *     maps and writes one NDJSON record per changed host:
+ *       {"ip":"10.0.0.1","new_host":false,"opened":[443],"closed":[22]}
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "result_log.h"
+
+struct BatchOptions {
+    std::string input = "-";                // Spec file, "-" = stdin
+    std::string output = "-";               // NDJSON file, "-" = stdout
+    std::vector<std::pair<uint16_t, uint16_t>> defaultPorts = { { 80, 80 } };  // For specs without ":ports"
+    size_t window = 512;                    // Connects in flight
+    int timeoutMs = 500;
+    std::string logPath;                    // Binary result log to append to, empty = none
+    std::string exposurePath;               // Open-port map to diff against and replace, empty = none
+};
+
+// Returns the process exit code: 0 done, 1 input/output error, 2 some specs were malformed
+int runBatch(const BatchOptions& opts);
+
+// Writes the results of 'path' matching 'q' to stdout as NDJSON; 0 done, 1 unreadable log
+int runLogDump(const std::string& path, const ResultLogQuery& q);
+
+// Writes the port changes from map 'before' to map 'after' to stdout as NDJSON; 0 done, 1 unreadable map
+int runExposureDiff(const std::string& before, const std::string& after);
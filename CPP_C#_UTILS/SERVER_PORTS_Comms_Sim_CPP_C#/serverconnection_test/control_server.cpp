@@ -0,0 +1,436 @@
+/*
+ * Control Socket Server (Linux)
+ * Author: Alushi
+ * Description:
+ *   - See control_server.h.
+ */
+
+#include "control_server.h"
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "probe_cache.h"
+#include "probe_engine.h"
+#include "probe_jobs.h"
+
+namespace {
+
+const size_t kMaxLine = 1024;
+const size_t kReadBurst = 16;           // 4 KiB chunks read per wakeup of one client
+const size_t kMaxOutput = 4 << 20;      // A client that stops reading is dropped past this
+
+// epoll data for the two non-client fds; client fds are stored as-is
+const uint64_t kListenTag = ~0ull;
+const uint64_t kWakeTag = ~0ull - 1;
+
+} // namespace
+
+struct ControlServer::Job {
+    enum Kind { Test, Scan } kind = Test;
+    int fd = -1;
+    uint64_t connId = 0;
+    std::string ip;
+    int lo = 0;
+    int hi = 0;
+    uint64_t runnerId = 0;
+    std::string result;         // Written by the runner (or the cache), read by the loop after hand-off
+    bool complete = false;      // Loop thread only
+};
+
+struct ControlServer::Client {
+    struct Pending {
+        std::string text;
+        std::shared_ptr<Job> job;   // Set while the answer is still being probed
+    };
+
+    int fd = -1;
+    uint64_t connId = 0;
+    bool subscribed = false;
+    bool eof = false;               // Peer shut its write side; answer what was asked, then close
+    std::string in;
+    std::string out;
+    std::deque<Pending> pending;    // Responses in request order
+};
+
+ControlServer::ControlServer(ControlServerOptions opts, ProbeJobRunner& runner, std::function<std::string()> status)
+    : opts_(std::move(opts)), runner_(runner), status_(std::move(status)) {}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+bool ControlServer::start() {
+    if (running_.load()) return true;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (opts_.path.size() >= sizeof(addr.sun_path)) return false;
+    std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", opts_.path.c_str());
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) return false;
+    unlink(opts_.path.c_str());         // Stale socket file from a previous run
+    if (bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd_, 128) < 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    chmod(opts_.path.c_str(), 0600);    // Same user only: "test"/"scan" make outbound connections
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = kListenTag;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &ev);
+    ev.data.u64 = kWakeTag;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+    running_.store(true);
+    thread_ = std::thread(&ControlServer::loop, this);
+    return true;
+}
+
+void ControlServer::stop() {
+    if (!running_.exchange(false)) return;
+    wake();
+    if (thread_.joinable()) thread_.join();
+
+    // Jobs still on the runner point back at this server: cancel them and wait out the ones
+    // that started. A job dropped while still queued never runs, so never calls finish().
+    {
+        std::unique_lock<std::mutex> lock(doneMutex_);
+        for (auto it = submitted_.begin(); it != submitted_.end();) {
+            bool discarded = false;
+            runner_.cancel(it->first, &discarded);
+            if (discarded) it = submitted_.erase(it);
+            else ++it;
+        }
+        idleCv_.wait(lock, [&]() { return submitted_.empty(); });
+    }
+
+    for (auto& c : clients_)
+        if (c) close(c->fd);
+    clients_.clear();
+    close(listenFd_);
+    close(epollFd_);
+    close(wakeFd_);
+    listenFd_ = epollFd_ = wakeFd_ = -1;
+    unlink(opts_.path.c_str());
+}
+
+void ControlServer::broadcast(const std::string& line) {
+    if (!running_.load()) return;
+    {
+        std::lock_guard<std::mutex> lock(doneMutex_);
+        events_.push_back("EVENT " + line + "\n");
+    }
+    wake();
+}
+
+void ControlServer::wake() {
+    uint64_t one = 1;
+    ssize_t n = write(wakeFd_, &one, sizeof(one));
+    (void)n;
+}
+
+// ---------- EVENT LOOP ----------
+void ControlServer::loop() {
+    epoll_event events[64];
+    while (running_.load()) {
+        int n = epoll_wait(epollFd_, events, 64, 500);
+        for (int i = 0; i < n; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == kListenTag) {
+                accept();
+                continue;
+            }
+            if (tag == kWakeTag) {
+                uint64_t count;
+                ssize_t r = read(wakeFd_, &count, sizeof(count));
+                (void)r;
+                drainCompletions();
+                continue;
+            }
+
+            int fd = (int)tag;
+            if (fd >= (int)clients_.size() || !clients_[fd]) continue;
+            Client& c = *clients_[fd];
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                drop(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) onReadable(c);
+            if (fd < (int)clients_.size() && clients_[fd] && (events[i].events & EPOLLOUT)) flush(*clients_[fd]);
+        }
+    }
+}
+
+void ControlServer::accept() {
+    while (true) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        if (fd >= (int)clients_.size()) clients_.resize(fd + 1);
+        clients_[fd].reset(new Client());
+        clients_[fd]->fd = fd;
+        clients_[fd]->connId = nextConnId_++;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = (uint64_t)fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) < 0) drop(fd);     // Would never be read
+    }
+}
+
+void ControlServer::onReadable(Client& c) {
+    // Lines are taken out of every chunk as it arrives, so c.in only ever holds one partial
+    // line; a client that sends more than kMaxLine without a newline is dropped right there.
+    // At most kReadBurst chunks per wakeup: level-triggered epoll brings us back for the rest,
+    // and the responses so far get flushed (and the output cap applied) in between.
+    char buf[4096];
+    for (size_t chunk = 0; chunk < kReadBurst; chunk++) {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            c.eof = true;
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                drop(c.fd);
+                return;
+            }
+            break;
+        }
+
+        c.in.append(buf, (size_t)n);
+        size_t start = 0, nl;
+        while ((nl = c.in.find('\n', start)) != std::string::npos) {
+            std::string line = c.in.substr(start, nl - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            start = nl + 1;
+            handleLine(c, line);
+        }
+        c.in.erase(0, start);
+        if (c.in.size() > kMaxLine) {
+            drop(c.fd);
+            return;
+        }
+    }
+
+    // A burst of pipelined requests becomes one write
+    flush(c);
+}
+
+void ControlServer::handleLine(Client& c, const std::string& line) {
+    std::istringstream in(line);
+    std::string cmd;
+    in >> cmd;
+    Client::Pending p;
+
+    if (cmd == "status") {
+        p.text = "OK status " + status_() + "\n";
+    }
+    else if (cmd == "ping") {
+        p.text = "OK pong\n";
+    }
+    else if (cmd == "subscribe") {
+        c.subscribed = true;
+        p.text = "OK subscribed\n";
+    }
+    else if (cmd == "test" || cmd == "scan") {
+        std::string range, ip;
+        in >> range >> ip;
+        if (ip.empty()) ip = opts_.defaultIp;
+
+        auto job = std::make_shared<Job>();
+        job->kind = (cmd == "test") ? Job::Test : Job::Scan;
+        job->fd = c.fd;
+        job->connId = c.connId;
+        job->ip = ip;
+        job->lo = std::atoi(range.c_str());
+        size_t dash = range.find('-');
+        job->hi = (dash == std::string::npos) ? job->lo : std::atoi(range.c_str() + dash + 1);
+
+        ProbeTarget check;
+        if (!makeProbeTarget(ip, job->lo, check) || !makeProbeTarget(ip, job->hi, check) || job->hi < job->lo) {
+            p.text = "ERR bad target\n";
+        }
+        else if (job->hi - job->lo + 1 > opts_.maxScanPorts) {
+            p.text = "ERR range too large\n";
+        }
+        else {
+            p.job = job;
+            // Held under doneMutex_ so the job cannot finish before it is registered
+            std::lock_guard<std::mutex> lock(doneMutex_);
+            job->runnerId = runner_.submit(cmd + " " + range + " (control)", [this, job](const std::atomic<bool>& cancelled) {
+                runJob(job, cancelled);
+            }, job->kind == Job::Scan ? ProbeClass::Bulk : ProbeClass::Interactive);
+            submitted_[job->runnerId] = job;
+        }
+    }
+    else if (!cmd.empty()) {
+        p.text = "ERR unknown command\n";
+    }
+    else {
+        return;     // Blank line
+    }
+    c.pending.push_back(std::move(p));
+}
+
+// Moves answered responses (in order) to the output buffer and writes what the socket takes
+void ControlServer::flush(Client& c) {
+    while (!c.pending.empty()) {
+        Client::Pending& front = c.pending.front();
+        if (front.job) {
+            if (!front.job->complete) break;
+            c.out += front.job->result;
+        }
+        else {
+            c.out += front.text;
+        }
+        c.pending.pop_front();
+    }
+
+    size_t sent = 0;
+    while (sent < c.out.size()) {
+        ssize_t n = send(c.fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0 && errno == EINTR) continue;
+        drop(c.fd);
+        return;
+    }
+    c.out.erase(0, sent);
+    if (c.out.size() > kMaxOutput || (c.eof && c.pending.empty() && c.out.empty())) {
+        drop(c.fd);
+        return;
+    }
+
+    // After EOF stop watching input, or the level-triggered EPOLLIN would spin
+    epoll_event ev{};
+    ev.events = (c.eof ? 0u : (uint32_t)(EPOLLIN | EPOLLRDHUP)) | (c.out.empty() ? 0u : (uint32_t)EPOLLOUT);
+    ev.data.u64 = (uint64_t)c.fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, c.fd, &ev);
+}
+
+void ControlServer::drop(int fd) {
+    close(fd);                          // Also leaves the epoll set
+    clients_[fd].reset();
+}
+
+void ControlServer::drainCompletions() {
+    std::vector<std::shared_ptr<Job>> done;
+    std::vector<std::string> events;
+    {
+        std::lock_guard<std::mutex> lock(doneMutex_);
+        done.swap(done_);
+        events.swap(events_);
+    }
+
+    for (auto& job : done) {
+        job->complete = true;
+        // The fd may have been closed and reused by a new client since the job was queued
+        if (job->fd < (int)clients_.size() && clients_[job->fd] && clients_[job->fd]->connId == job->connId)
+            flush(*clients_[job->fd]);
+    }
+
+    if (events.empty()) return;
+    for (size_t fd = 0; fd < clients_.size(); fd++) {
+        if (!clients_[fd] || !clients_[fd]->subscribed) continue;
+        for (const std::string& e : events) clients_[fd]->out += e;
+        flush(*clients_[fd]);
+    }
+}
+
+// ---------- PROBE JOBS ----------
+// Hands the answered job to the loop; for a test joined to a probe in flight this runs on
+// the thread of that probe
+void ControlServer::finish(const std::shared_ptr<Job>& job) {
+    {
+        // Wake under the lock: once submitted_ is empty stop() may close wakeFd_
+        std::lock_guard<std::mutex> done(doneMutex_);
+        done_.push_back(job);
+        submitted_.erase(job->runnerId);
+        wake();
+    }
+    idleCv_.notify_all();
+}
+
+void ControlServer::runJob(const std::shared_ptr<Job>& job, const std::atomic<bool>& cancelled) {
+    std::vector<ProbeTarget> targets(job->hi - job->lo + 1);
+    for (int p = job->lo; p <= job->hi; p++) makeProbeTarget(job->ip, p, targets[p - job->lo]);
+
+    ProbeEngine engine(ProbeBackend::Epoll, opts_.scanWindow, opts_.probeTimeoutMs);
+    engine.setCancelFlag(&cancelled);
+    engine.setPerfSink(opts_.perf);
+    std::ostringstream out;
+    if (job->kind == Job::Test && opts_.cache) {
+        ProbeCacheKey key;
+        key.addr = targets[0].addr;
+        key.port = targets[0].port;
+        key.timeoutMs = opts_.probeTimeoutMs;
+        opts_.cache->get(key, [&]() {
+            ProbeCacheValue v;
+            engine.run(targets, [&](const ProbeResult& r) {
+                v.status = r.status;
+                v.rttMs = r.rttMs;
+            });
+            v.cancelled = cancelled.load();
+            return v;
+        }, [this, job](const ProbeCacheAnswer& a) {
+            std::ostringstream line;
+            if (a.value.cancelled)
+                line << "ERR test " << job->ip << ":" << job->lo << " cancelled\n";
+            else
+                line << "OK test " << job->ip << ":" << job->lo << " " << probeStatusName(a.value.status) << " "
+                    << a.value.rttMs << "ms " << probeCacheSourceName(a.source) << " " << a.ageMs << "ms\n";
+            job->result = line.str();
+            finish(job);
+        });
+        return;
+    }
+    if (job->kind == Job::Test) {
+        ProbeResult res;
+        engine.run(targets, [&](const ProbeResult& r) { res = r; });
+        out << "OK test " << job->ip << ":" << job->lo << " " << probeStatusName(res.status)
+            << " " << res.rttMs << "ms\n";
+    }
+    else {
+        std::vector<bool> open(targets.size(), false);
+        size_t count = 0;
+        engine.run(targets, [&](const ProbeResult& r) {
+            if (r.status == ProbeStatus::Open) {
+                open[r.index] = true;
+                count++;
+            }
+        });
+        out << "OK scan " << job->ip << " " << job->lo << "-" << job->hi << " open=" << count << " ports=";
+        bool first = true;
+        for (size_t i = 0; i < open.size(); i++) {
+            if (!open[i]) continue;
+            out << (first ? "" : ",") << job->lo + (int)i;
+            first = false;
+        }
+        out << "\n";
+    }
+    job->result = out.str();
+    finish(job);
+}
+
+#endif
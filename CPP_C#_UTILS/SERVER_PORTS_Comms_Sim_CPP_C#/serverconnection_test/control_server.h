@@ -0,0 +1,103 @@
+/*
+ * Control Socket Server (Linux)
+ * Author: Alushi
+ * Description:
+ *   - Unix domain socket API next to the REPL, for scripts and other tools.
+ *   - Line protocol, one request per line, one response line per request, in request order
+ *     per connection; clients may pipeline as many requests as they like.
+ *       status                  -> OK status <ip>:<port> online|offline ...
+ *                                  (--targets: OK status targets=<n> online=<n> offline=<n> ...)
+ *       test <port> [ip]        -> OK test <ip>:<port> open|closed|timeout|error <rtt>ms
+ *       scan <lo>-<hi> [ip]     -> OK scan <ip> <lo>-<hi> open=<n> ports=<p1,p2,...>
+ *       subscribe               -> OK subscribed, then "EVENT ..." lines on every status change
+ *       ping                    -> OK pong
+ *     Anything else gets "ERR <reason>".
+ *   - One epoll thread serves all clients; status and ping are answered inline from memory.
+ *     test/scan run as jobs on the shared ProbeJobRunner (the REPL's pool), so a slow probe
+ *     only delays the responses queued behind it on the same connection. Tests run in the
+ *     interactive class, scans in the bulk class (probe_priority.h).
+ *   - With a probe cache (probe_cache.h, shared with the REPL) test answers end in
+ *     "fresh 0ms", "cached <age>ms" or "joined <age>ms"; identical tests in flight share one probe.
+ *     A test whose shared probe belonged to a job that got cancelled answers "ERR test <ip>:<port>
+ *     cancelled" instead of the unfinished result.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "perf_counters.h"
+
+class ProbeCache;
+class ProbeJobRunner;
+
+struct ControlServerOptions {
+    std::string path = "/tmp/serverconnection.sock";
+    std::string defaultIp = "127.0.0.1";    // Target of test/scan when no ip is given
+    int probeTimeoutMs = 500;
+    size_t scanWindow = 256;                // Connects in flight per scan
+    int maxScanPorts = 65535;
+    ProbeCache* cache = nullptr;            // For test, null = always probe; must outlive the server
+    PerfAccumulator* perf = nullptr;        // Counters of the test/scan engine loops (--perf); must outlive the server
+};
+
+class ControlServer {
+public:
+    // 'status' builds the text after "OK status " from the caller's in-memory state;
+    // test/scan jobs go to 'runner', which must outlive the server
+    ControlServer(ControlServerOptions opts, ProbeJobRunner& runner, std::function<std::string()> status);
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    bool start();
+    void stop();
+    bool running() const { return running_.load(); }
+
+    // Queues "EVENT <line>" for every subscriber; safe from any thread
+    void broadcast(const std::string& line);
+
+private:
+    struct Job;
+    struct Client;
+
+    void loop();
+    void runJob(const std::shared_ptr<Job>& job, const std::atomic<bool>& cancelled);
+    void finish(const std::shared_ptr<Job>& job);
+    void accept();
+    void onReadable(Client& c);
+    void handleLine(Client& c, const std::string& line);
+    void flush(Client& c);
+    void drop(int fd);
+    void drainCompletions();
+    void wake();
+
+    ControlServerOptions opts_;
+    ProbeJobRunner& runner_;
+    std::function<std::string()> status_;
+
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;                       // eventfd: completions or events are waiting
+    std::atomic<bool> running_{ false };
+    std::thread thread_;
+
+    std::vector<std::unique_ptr<Client>> clients_;   // Indexed by fd
+    uint64_t nextConnId_ = 1;
+
+    std::mutex doneMutex_;
+    std::condition_variable idleCv_;
+    std::map<uint64_t, std::shared_ptr<Job>> submitted_;    // Runner job id -> job, until it finishes
+    std::vector<std::shared_ptr<Job>> done_;
+    std::vector<std::string> events_;
+};
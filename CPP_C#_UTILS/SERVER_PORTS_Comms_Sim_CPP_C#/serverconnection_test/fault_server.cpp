@@ -0,0 +1,482 @@
+/*
+ * Fault-Injecting Stand-In Server (Linux)
+ * Author: Alushi
+ * Description:
+ *   - Local targets that misbehave in controlled, repeatable ways, one behavior per port.
+ *   - Used to measure monitor detection latency and false-positive rates deterministically.
+ *   - Every state change is logged with a monotonic timestamp so runs can be lined up
+ *     against the monitor's own [DEBUG] output.
+ *   - Standalone tool (own main), not part of the serverconnection_test project:
+ *       g++ -O2 -std=c++17 fault_server.cpp -o fault_server
+ *       ./fault_server --script faults.txt      (or --rule "7133 flap 2000 1000" ...)
+ *
+ * Script format, one rule per line ('#' starts a comment):
+ *   <port> ok                      accept and close at once
+ *   <port> accept-delay <ms>       accept one queued connection every <ms> and close it
+ *                                  (a server-first read waits at least <ms>)
+ *   <port> blackhole               accept queue kept full: SYNs are dropped, connect() times out
+ *   <port> rst                     accept, then reset the established connection (SO_LINGER 0)
+ *   <port> flap <upMs> <downMs> [jitterMs]
+ *                                  listener open for upMs, closed (refused) for downMs;
+ *                                  jitter is drawn from a fixed-seed PRNG so runs repeat
+ *   <port> close-after <n>         send the first n bytes of a valid HTTP 200 response, then close
+ *   <port> hang                    accept and never send anything (hung app)
+ *   <port> http <status> [delayMs] answer every request with <status>, after delayMs, keep-alive
+ *
+ * What a bare connect probe can see: the kernel completes the handshake before accept(), so
+ * only flap (refused while down) and blackhole (timeout) change its result. accept-delay, rst,
+ * close-after, hang and http act after the connection is established. Probes that read or
+ * write afterwards see them: banner grab, HTTP, TLS and the persistent link. To a connect
+ * probe, accept-delay looks like ok. For rst, the reset races the probe's SO_ERROR read, so it
+ * shows as open or as an error, never as refused.
+ */
+
+#ifndef __linux__
+#error "fault_server needs Linux (epoll)"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Behavior { Ok, AcceptDelay, Blackhole, Rst, Flap, CloseAfter, Hang, Http };
+
+struct PortRule {
+    int port = 0;
+    Behavior behavior = Behavior::Ok;
+    int arg1 = 0;
+    int arg2 = 0;
+    int arg3 = 0;
+};
+
+struct PortState {
+    PortRule rule;
+    int listenFd = -1;
+    bool up = true;
+    Clock::time_point nextFlip;         // Flap: when to toggle
+    Clock::time_point acceptAt;         // Accept-delay: when the waiting connection may be accepted
+    bool acceptPending = false;
+    std::vector<int> fillers;           // Blackhole: our own connections that keep the queue full
+    uint64_t accepts = 0;
+    uint64_t flips = 0;
+};
+
+struct ConnState {
+    int fd = -1;
+    size_t port = 0;                    // Index into ports
+    Clock::time_point respondAt;        // Http with delay: when the queued response is due
+    bool responsePending = false;
+};
+
+const uint64_t kListenerTag = 1ull << 62;
+const uint64_t kConnTag = 1ull << 61;
+
+volatile std::sig_atomic_t running = 1;
+Clock::time_point startTime;
+
+void onSignal(int) {
+    running = 0;
+}
+
+double nowMs() {
+    return std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+}
+
+void logEvent(int port, const std::string& what) {
+    std::cout << "[FAULT] t=" << nowMs() << " port " << port << " " << what << "\n";
+    std::cout.flush();
+}
+
+bool parseRule(const std::string& line, PortRule& rule) {
+    std::istringstream in(line);
+    std::string name;
+    if (!(in >> rule.port >> name)) return false;
+    if (rule.port <= 0 || rule.port > 65535) return false;
+
+    if (name == "ok") rule.behavior = Behavior::Ok;
+    else if (name == "accept-delay") rule.behavior = Behavior::AcceptDelay;
+    else if (name == "blackhole") rule.behavior = Behavior::Blackhole;
+    else if (name == "rst") rule.behavior = Behavior::Rst;
+    else if (name == "flap") rule.behavior = Behavior::Flap;
+    else if (name == "close-after") rule.behavior = Behavior::CloseAfter;
+    else if (name == "hang") rule.behavior = Behavior::Hang;
+    else if (name == "http") rule.behavior = Behavior::Http;
+    else return false;
+
+    in >> rule.arg1 >> rule.arg2 >> rule.arg3;
+    if (rule.behavior == Behavior::Flap && (rule.arg1 <= 0 || rule.arg2 <= 0)) return false;
+    if (rule.behavior == Behavior::Http && rule.arg1 == 0) rule.arg1 = 200;
+    return true;
+}
+
+int openListener(int port, int backlog) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, backlog) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Connects to our own never-accepting listener until the accept queue stops taking entries
+void fillAcceptQueue(PortState& ps) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(ps.rule.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int i = 0; i < 8; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        connect(fd, (sockaddr*)&addr, sizeof(addr));
+        pollfd pfd{ fd, POLLOUT, 0 };
+        int so_error = -1;
+        if (poll(&pfd, 1, 50) > 0) {
+            socklen_t len = sizeof(so_error);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+        }
+        if (so_error != 0) {
+            close(fd);
+            break;          // This SYN was dropped: the queue is full
+        }
+        ps.fillers.push_back(fd);
+    }
+}
+
+void resetAndClose(int fd) {
+    linger lg{ 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+}
+
+std::string httpResponse(int status) {
+    std::string body = (status >= 200 && status < 300) ? "ok" : "fault";
+    return "HTTP/1.1 " + std::to_string(status) + " Fault Injected\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: keep-alive\r\n\r\n" + body;
+}
+
+class FaultServer {
+public:
+    explicit FaultServer(std::vector<PortRule> rules) : rng_(12345) {
+        ep_ = epoll_create1(EPOLL_CLOEXEC);
+        for (auto& r : rules) {
+            PortState ps;
+            ps.rule = r;
+            ports_.push_back(ps);
+        }
+    }
+
+    bool start() {
+        auto now = Clock::now();
+        for (size_t i = 0; i < ports_.size(); i++) {
+            PortState& ps = ports_[i];
+            if (!openPort(i)) {
+                std::cerr << "[!] Cannot listen on port " << ps.rule.port << "\n";
+                return false;
+            }
+            if (ps.rule.behavior == Behavior::Flap) ps.nextFlip = now + flapPeriod(ps, true);
+            logEvent(ps.rule.port, "up (" + describe(ps.rule) + ")");
+        }
+        return true;
+    }
+
+    void run() {
+        epoll_event events[128];
+        while (running) {
+            int n = epoll_wait(ep_, events, 128, nextTimeoutMs());
+            for (int i = 0; i < n; i++) {
+                uint64_t tag = events[i].data.u64;
+                if (tag & kListenerTag) onListenerReady(tag & 0xffffffff);
+                else if (tag & kConnTag) onConnReady(tag & 0xffffffff, events[i].events);
+            }
+            onTimers();
+        }
+    }
+
+    void summary() const {
+        for (const PortState& ps : ports_)
+            std::cout << "[FAULT] port " << ps.rule.port << " (" << describe(ps.rule) << "): "
+            << ps.accepts << " accepts, " << ps.flips << " flips\n";
+    }
+
+private:
+    static std::string describe(const PortRule& r) {
+        switch (r.behavior) {
+        case Behavior::Ok: return "ok";
+        case Behavior::AcceptDelay: return "accept-delay " + std::to_string(r.arg1) + "ms";
+        case Behavior::Blackhole: return "blackhole";
+        case Behavior::Rst: return "rst";
+        case Behavior::Flap: return "flap " + std::to_string(r.arg1) + "/" + std::to_string(r.arg2) + "ms";
+        case Behavior::CloseAfter: return "close-after " + std::to_string(r.arg1) + "B";
+        case Behavior::Hang: return "hang";
+        case Behavior::Http: return "http " + std::to_string(r.arg1);
+        }
+        return "?";
+    }
+
+    std::chrono::milliseconds flapPeriod(const PortState& ps, bool up) {
+        int base = up ? ps.rule.arg1 : ps.rule.arg2;
+        int jitter = ps.rule.arg3;
+        if (jitter > 0) base += std::uniform_int_distribution<int>(-jitter, jitter)(rng_);
+        return std::chrono::milliseconds(std::max(1, base));
+    }
+
+    bool openPort(size_t idx) {
+        PortState& ps = ports_[idx];
+        bool blackhole = ps.rule.behavior == Behavior::Blackhole;
+        ps.listenFd = openListener(ps.rule.port, blackhole ? 0 : 4096);
+        if (ps.listenFd < 0) return false;
+        ps.up = true;
+
+        if (blackhole) {
+            fillAcceptQueue(ps);    // Never registered with epoll: nothing is ever accepted
+            return true;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = kListenerTag | idx;
+        epoll_ctl(ep_, EPOLL_CTL_ADD, ps.listenFd, &ev);
+        return true;
+    }
+
+    void closePort(size_t idx) {
+        PortState& ps = ports_[idx];
+        if (ps.listenFd >= 0) close(ps.listenFd);   // Also drops whatever sat in the accept queue
+        ps.listenFd = -1;
+        ps.up = false;
+        ps.acceptPending = false;
+    }
+
+    void addConn(int fd, size_t portIdx) {
+        size_t slot = conns_.size();
+        for (size_t i = 0; i < conns_.size(); i++)
+            if (conns_[i].fd < 0) { slot = i; break; }
+        if (slot == conns_.size()) conns_.emplace_back();
+        conns_[slot] = ConnState{};
+        conns_[slot].fd = fd;
+        conns_[slot].port = portIdx;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = kConnTag | slot;
+        epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void dropConn(size_t slot) {
+        if (conns_[slot].fd >= 0) close(conns_[slot].fd);
+        conns_[slot].fd = -1;
+        conns_[slot].responsePending = false;
+    }
+
+    void acceptOne(size_t idx) {
+        PortState& ps = ports_[idx];
+        int c = accept4(ps.listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (c < 0) return;
+        ps.accepts++;
+
+        switch (ps.rule.behavior) {
+        case Behavior::Rst:
+            resetAndClose(c);
+            break;
+        case Behavior::CloseAfter: {
+            std::string full = "HTTP/1.1 200 OK\r\nContent-Length: 64\r\n\r\n" + std::string(64, 'x');
+            size_t n = std::min<size_t>(ps.rule.arg1, full.size());
+            if (n) send(c, full.data(), n, MSG_NOSIGNAL);
+            close(c);
+            break;
+        }
+        case Behavior::Hang:
+        case Behavior::Http:
+            addConn(c, idx);
+            break;
+        default:
+            close(c);
+            break;
+        }
+    }
+
+    void onListenerReady(size_t idx) {
+        PortState& ps = ports_[idx];
+        if (ps.listenFd < 0) return;
+
+        if (ps.rule.behavior == Behavior::AcceptDelay) {
+            // Park the listener until the head-of-queue connection has waited long enough
+            if (!ps.acceptPending) {
+                ps.acceptPending = true;
+                ps.acceptAt = Clock::now() + std::chrono::milliseconds(ps.rule.arg1);
+                epoll_event ev{};
+                ev.data.u64 = kListenerTag | idx;
+                epoll_ctl(ep_, EPOLL_CTL_MOD, ps.listenFd, &ev);
+            }
+            return;
+        }
+        for (int k = 0; k < 64; k++) {
+            uint64_t before = ps.accepts;
+            acceptOne(idx);
+            if (ps.accepts == before) break;
+        }
+    }
+
+    void onConnReady(size_t slot, uint32_t events) {
+        ConnState& cs = conns_[slot];
+        if (cs.fd < 0) return;
+
+        char buf[4096];
+        ssize_t r = recv(cs.fd, buf, sizeof(buf), 0);
+        if (r == 0 || (r < 0 && errno != EAGAIN) || (events & (EPOLLHUP | EPOLLERR))) {
+            dropConn(slot);
+            return;
+        }
+        if (r < 0) return;
+
+        const PortRule& rule = ports_[cs.port].rule;
+        if (rule.behavior != Behavior::Http) return;     // Hang: swallow input forever
+
+        // One response per request burst; a delayed one is sent from onTimers()
+        if (rule.arg2 > 0) {
+            cs.respondAt = Clock::now() + std::chrono::milliseconds(rule.arg2);
+            cs.responsePending = true;
+        }
+        else {
+            std::string resp = httpResponse(rule.arg1);
+            send(cs.fd, resp.data(), resp.size(), MSG_NOSIGNAL);
+        }
+    }
+
+    void onTimers() {
+        auto now = Clock::now();
+        for (size_t i = 0; i < ports_.size(); i++) {
+            PortState& ps = ports_[i];
+
+            if (ps.rule.behavior == Behavior::Flap && now >= ps.nextFlip) {
+                if (ps.up) closePort(i);
+                else openPort(i);
+                ps.flips++;
+                ps.nextFlip = now + flapPeriod(ps, ps.up);
+                logEvent(ps.rule.port, ps.up ? "up" : "down");
+            }
+
+            if (ps.acceptPending && now >= ps.acceptAt && ps.listenFd >= 0) {
+                ps.acceptPending = false;
+                acceptOne(i);
+                epoll_event ev{};
+                ev.events = EPOLLIN;
+                ev.data.u64 = kListenerTag | i;
+                epoll_ctl(ep_, EPOLL_CTL_MOD, ps.listenFd, &ev);
+            }
+        }
+
+        for (ConnState& cs : conns_) {
+            if (cs.fd < 0 || !cs.responsePending || now < cs.respondAt) continue;
+            std::string resp = httpResponse(ports_[cs.port].rule.arg1);
+            send(cs.fd, resp.data(), resp.size(), MSG_NOSIGNAL);
+            cs.responsePending = false;
+        }
+    }
+
+    int nextTimeoutMs() const {
+        auto now = Clock::now();
+        auto next = now + std::chrono::milliseconds(200);
+        for (const PortState& ps : ports_) {
+            if (ps.rule.behavior == Behavior::Flap) next = std::min(next, ps.nextFlip);
+            if (ps.acceptPending) next = std::min(next, ps.acceptAt);
+        }
+        for (const ConnState& cs : conns_)
+            if (cs.fd >= 0 && cs.responsePending) next = std::min(next, cs.respondAt);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count();
+        return ms < 0 ? 0 : (int)ms + 1;
+    }
+
+    int ep_ = -1;
+    std::vector<PortState> ports_;
+    std::vector<ConnState> conns_;
+    std::mt19937 rng_;              // Fixed seed: flap jitter is identical on every run
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<PortRule> rules;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--script" && hasValue) {
+            std::ifstream file(argv[++i]);
+            if (!file) {
+                std::cerr << "[!] Cannot open script: " << argv[i] << "\n";
+                return 1;
+            }
+            std::string line;
+            int lineNo = 0;
+            while (std::getline(file, line)) {
+                lineNo++;
+                size_t hash = line.find('#');
+                if (hash != std::string::npos) line.resize(hash);
+                if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+                PortRule r;
+                if (!parseRule(line, r)) {
+                    std::cerr << "[!] " << argv[i] << ":" << lineNo << ": invalid rule\n";
+                    return 1;
+                }
+                rules.push_back(r);
+            }
+        }
+        else if (arg == "--rule" && hasValue) {
+            PortRule r;
+            if (!parseRule(argv[++i], r)) {
+                std::cerr << "[!] Invalid rule: " << argv[i] << "\n";
+                return 1;
+            }
+            rules.push_back(r);
+        }
+        else {
+            std::cerr << "Usage: fault_server [--script <file>] [--rule \"<port> <behavior> [args]\"]...\n";
+            return 1;
+        }
+    }
+    if (rules.empty()) {
+        std::cerr << "[!] No rules given.\n";
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    startTime = Clock::now();
+    FaultServer server(rules);
+    if (!server.start()) return 1;
+    server.run();
+    server.summary();
+    return 0;
+}
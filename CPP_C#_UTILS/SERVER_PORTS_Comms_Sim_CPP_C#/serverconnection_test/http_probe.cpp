@@ -0,0 +1,304 @@
+/*
+ * HTTP/1.1 Health Probe
+ * Author: Alushi
+ * Description:
+ *   - See http_probe.h.
+ */
+
+#include "http_probe.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+bool equalsNoCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x = char(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = char(y - 'A' + 'a');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view v) {
+    while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back() == ' ' || v.back() == '\t')) v.remove_suffix(1);
+    return v;
+}
+
+// Incremental walker over a chunked body; only tracks framing, the payload is discarded
+struct ChunkedWalker {
+    enum State { Size, Data, DataCrlf, Trailer, Done } state = Size;
+    size_t remaining = 0;
+    size_t lineLen = 0;         // Bytes seen on the current trailer line
+    bool sawHex = false;
+    bool inExtension = false;
+
+    // Consumes bytes; returns false on a framing error
+    bool feed(const char* p, size_t n) {
+        for (size_t i = 0; i < n && state != Done; i++) {
+            char c = p[i];
+            switch (state) {
+            case Size:
+                // Hex size, optionally followed by ";extensions", terminated by CRLF
+                if (c == '\n') {
+                    if (!sawHex) return false;
+                    state = remaining ? Data : Trailer;
+                    sawHex = false;
+                    inExtension = false;
+                }
+                else if (!inExtension) {
+                    int d = (c >= '0' && c <= '9') ? c - '0'
+                        : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                        : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+                    if (d >= 0) {
+                        remaining = remaining * 16 + size_t(d);
+                        sawHex = true;
+                    }
+                    else {
+                        inExtension = true;
+                    }
+                }
+                break;
+            case Data: {
+                size_t take = (n - i < remaining) ? n - i : remaining;
+                remaining -= take;
+                i += take - 1;
+                if (remaining == 0) state = DataCrlf;
+                break;
+            }
+            case DataCrlf:
+                if (c == '\n') state = Size;
+                break;
+            case Trailer:
+                // Trailer section ends with an empty line
+                if (c == '\n') {
+                    if (lineLen == 0) state = Done;
+                    lineLen = 0;
+                }
+                else if (c != '\r') {
+                    lineLen++;
+                }
+                break;
+            case Done:
+                break;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+size_t parseHttpStatusLine(std::string_view buf, HttpStatusLine& out) {
+    size_t eol = buf.find("\r\n");
+    if (eol == std::string_view::npos) return 0;
+    std::string_view line = buf.substr(0, eol);
+
+    if (line.size() < 12 || line.compare(0, 7, "HTTP/1.") != 0 || line[8] != ' ') return 0;
+    out.version = line.substr(0, 8);
+
+    int status = 0;
+    for (size_t i = 9; i < 12; i++) {
+        if (line[i] < '0' || line[i] > '9') return 0;
+        status = status * 10 + (line[i] - '0');
+    }
+    out.status = status;
+    out.reason = (line.size() > 13) ? line.substr(13) : std::string_view();
+    return eol + 2;
+}
+
+void recordHttpProbe(TargetStats& stats, const HttpProbeResult& res) {
+    stats.probes++;
+    if (!res.healthy) stats.failures++;
+    if (res.reused) stats.reusedConnections++;
+    else if (res.failedPhase != HttpPhase::Connect) stats.connect.record(res.connectMs);
+    if (res.firstByteMs > 0.0) stats.firstByte.record(res.firstByteMs);
+    if (res.completeMs > 0.0) stats.complete.record(res.completeMs);
+}
+
+HttpHealthProbe::HttpHealthProbe(const std::string& ip, int port, HttpProbeOptions opts)
+    : ip_(ip), port_(port), opts_(std::move(opts)) {
+    const std::string& host = opts_.hostHeader.empty() ? ip_ : opts_.hostHeader;
+    request_ = "GET " + opts_.path + " HTTP/1.1\r\n"
+        "Host: " + host + "\r\n"
+        "User-Agent: serverconnection_test\r\n"
+        "Accept: */*\r\n"
+        "Connection: keep-alive\r\n\r\n";
+}
+
+HttpHealthProbe::~HttpHealthProbe() {
+    for (socket_t s : idle_) closeSocket(s);
+}
+
+socket_t HttpHealthProbe::takeIdle() {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    while (!idle_.empty()) {
+        socket_t s = idle_.back();
+        idle_.pop_back();
+        // An idle keep-alive socket should have nothing to read; EOF or stray bytes mean it's stale
+        if (!waitSocket(s, false, 0)) return s;
+        closeSocket(s);
+    }
+    return kInvalidSocket;
+}
+
+void HttpHealthProbe::giveBack(socket_t s) {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    if (idle_.size() < opts_.maxIdleConnections) idle_.push_back(s);
+    else closeSocket(s);
+}
+
+HttpProbeResult HttpHealthProbe::probe(TargetStats* stats) {
+    HttpProbeResult res;
+
+    bool needFresh = true;
+    socket_t pooled = takeIdle();
+    if (pooled != kInvalidSocket) {
+        auto start = std::chrono::steady_clock::now();
+        res = attempt(pooled, true, 0.0);
+        // The server may have closed the pooled connection between checks; retry once fresh.
+        // A genuine first-byte timeout is not retried, so a hung app isn't waited on twice.
+        needFresh = res.status == 0 &&
+            (res.failedPhase == HttpPhase::Send || res.failedPhase == HttpPhase::FirstByte) &&
+            elapsedMs(start) < opts_.firstByteTimeoutMs;
+    }
+
+    if (needFresh) {
+        auto start = std::chrono::steady_clock::now();
+        socket_t fresh = connectWithTimeout(ip_, port_, opts_.connectTimeoutMs);
+        double connectMs = elapsedMs(start);
+        if (fresh == kInvalidSocket) {
+            res = HttpProbeResult{};
+            res.failedPhase = HttpPhase::Connect;
+            res.connectMs = connectMs;
+        }
+        else {
+            res = attempt(fresh, false, connectMs);
+        }
+    }
+
+    if (stats) recordHttpProbe(*stats, res);
+    return res;
+}
+
+HttpProbeResult HttpHealthProbe::attempt(socket_t s, bool reused, double connectMs) {
+    HttpProbeResult res;
+    res.reused = reused;
+    res.connectMs = connectMs;
+
+    auto fail = [&](HttpPhase phase) {
+        closeSocket(s);
+        res.failedPhase = phase;
+        res.healthy = false;
+        return res;
+    };
+
+    const auto sent = std::chrono::steady_clock::now();
+    auto remaining = [&](int budgetMs) { return budgetMs - (int)elapsedMs(sent); };
+
+    // ---- Send request ----
+    size_t off = 0;
+    while (off < request_.size()) {
+        int n = send(s, request_.data() + off, (int)(request_.size() - off), kSendFlags);
+        if (n > 0) { off += n; continue; }
+        if (n < 0 && wouldBlock() && waitSocket(s, true, remaining(opts_.completeTimeoutMs))) continue;
+        return fail(HttpPhase::Send);
+    }
+
+    // ---- First byte + headers ----
+    // Fixed per-call buffer: headers are parsed in place, body bytes are counted and dropped
+    char buf[8192];
+    size_t used = 0;
+    size_t headerEnd = std::string_view::npos;
+
+    while (headerEnd == std::string_view::npos) {
+        int budget = (used == 0) ? remaining(opts_.firstByteTimeoutMs) : remaining(opts_.completeTimeoutMs);
+        if (!waitSocket(s, false, budget)) return fail(used == 0 ? HttpPhase::FirstByte : HttpPhase::Complete);
+
+        int n = recv(s, buf + used, (int)(sizeof(buf) - used), 0);
+        if (n <= 0) {
+            if (n < 0 && wouldBlock()) continue;
+            return fail(used == 0 ? HttpPhase::FirstByte : HttpPhase::Complete);
+        }
+        if (used == 0) res.firstByteMs = elapsedMs(sent);
+        used += n;
+
+        size_t pos = std::string_view(buf, used).find("\r\n\r\n");
+        if (pos != std::string_view::npos) headerEnd = pos + 4;
+        else if (used == sizeof(buf)) return fail(HttpPhase::Parse);
+    }
+
+    std::string_view head(buf, headerEnd);
+    HttpStatusLine statusLine;
+    size_t lineEnd = parseHttpStatusLine(head, statusLine);
+    if (lineEnd == 0) return fail(HttpPhase::Parse);
+    res.status = statusLine.status;
+
+    // ---- Headers that decide framing and reuse ----
+    bool keepAlive = (statusLine.version == "HTTP/1.1");
+    bool chunked = false;
+    bool hasLength = false;
+    size_t contentLength = 0;
+
+    std::string_view rest = head.substr(lineEnd, headerEnd - lineEnd - 2);
+    while (!rest.empty()) {
+        size_t eol = rest.find("\r\n");
+        std::string_view line = rest.substr(0, eol);
+        rest = (eol == std::string_view::npos) ? std::string_view() : rest.substr(eol + 2);
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = trim(line.substr(colon + 1));
+
+        if (equalsNoCase(name, "content-length")) {
+            hasLength = true;
+            contentLength = std::strtoul(std::string(value).c_str(), nullptr, 10);
+        }
+        else if (equalsNoCase(name, "transfer-encoding")) {
+            chunked = value.size() >= 7 && equalsNoCase(value.substr(value.size() - 7), "chunked");
+        }
+        else if (equalsNoCase(name, "connection")) {
+            if (equalsNoCase(value, "close")) keepAlive = false;
+            else if (equalsNoCase(value, "keep-alive")) keepAlive = true;
+        }
+    }
+
+    bool noBody = (res.status / 100 == 1) || res.status == 204 || res.status == 304;
+    if (!noBody && !chunked && !hasLength) keepAlive = false;     // Body runs until close
+
+    // ---- Body (discarded) ----
+    size_t bodyHave = used - headerEnd;
+    ChunkedWalker walker;
+    if (chunked && !walker.feed(buf + headerEnd, bodyHave)) return fail(HttpPhase::Parse);
+
+    auto bodyDone = [&]() {
+        if (noBody) return true;
+        if (chunked) return walker.state == ChunkedWalker::Done;
+        if (hasLength) return bodyHave >= contentLength;
+        return false;
+    };
+
+    while (!bodyDone()) {
+        if (!waitSocket(s, false, remaining(opts_.completeTimeoutMs))) return fail(HttpPhase::Complete);
+        int n = recv(s, buf, (int)sizeof(buf), 0);
+        if (n < 0 && wouldBlock()) continue;
+        if (n <= 0) {
+            if (!chunked && !hasLength && n == 0) break;    // Close-delimited body finished
+            return fail(HttpPhase::Complete);
+        }
+        bodyHave += n;
+        if (chunked && !walker.feed(buf, n)) return fail(HttpPhase::Parse);
+    }
+
+    res.completeMs = elapsedMs(sent);
+    res.healthy = (res.status >= 200 && res.status < 300);
+
+    if (keepAlive) giveBack(s);
+    else closeSocket(s);
+    return res;
+}
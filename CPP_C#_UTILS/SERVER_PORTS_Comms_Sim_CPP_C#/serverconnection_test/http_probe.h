@@ -0,0 +1,78 @@
+/*
+ * HTTP/1.1 Health Probe
+ * Author: Alushi
+ * Description:
+ *   - Sends "GET <path>" over pooled keep-alive connections to one host:port.
+ *   - Status line and headers are parsed in place (string_view into the receive buffer).
+ *   - Separate deadlines for connect, first byte and complete response.
+ *   - Per-phase latencies are recorded into the caller's TargetStats.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "socket_util.h"
+#include "target_stats.h"
+
+struct HttpProbeOptions {
+    std::string path = "/health";
+    std::string hostHeader;         // Defaults to the target IP
+    int connectTimeoutMs = 500;
+    int firstByteTimeoutMs = 1000;  // Measured from the moment the request is sent
+    int completeTimeoutMs = 2000;   // Measured from the moment the request is sent
+    size_t maxIdleConnections = 2;
+};
+
+enum class HttpPhase { None, Connect, Send, FirstByte, Complete, Parse };
+
+struct HttpProbeResult {
+    bool healthy = false;           // Completed with a 2xx status
+    int status = 0;
+    HttpPhase failedPhase = HttpPhase::None;
+    bool reused = false;            // Served on a pooled keep-alive connection
+    double connectMs = 0.0;
+    double firstByteMs = 0.0;
+    double completeMs = 0.0;
+};
+
+// Views into the receive buffer; valid until the buffer is reused
+struct HttpStatusLine {
+    std::string_view version;
+    int status = 0;
+    std::string_view reason;
+};
+
+// Parses "HTTP/1.x NNN Reason\r\n" without copying; returns bytes consumed or 0 if incomplete/invalid
+size_t parseHttpStatusLine(std::string_view buf, HttpStatusLine& out);
+
+// Folds one probe result into a target's per-phase statistics
+void recordHttpProbe(TargetStats& stats, const HttpProbeResult& res);
+
+class HttpHealthProbe {
+public:
+    HttpHealthProbe(const std::string& ip, int port, HttpProbeOptions opts = {});
+    ~HttpHealthProbe();
+
+    HttpHealthProbe(const HttpHealthProbe&) = delete;
+    HttpHealthProbe& operator=(const HttpHealthProbe&) = delete;
+
+    // Runs one health check; stats (optional) receives the per-phase latencies
+    HttpProbeResult probe(TargetStats* stats = nullptr);
+
+private:
+    HttpProbeResult attempt(socket_t s, bool reused, double connectMs);
+    socket_t takeIdle();
+    void giveBack(socket_t s);
+
+    std::string ip_;
+    int port_;
+    HttpProbeOptions opts_;
+    std::string request_;           // Pre-built once; identical for every probe
+
+    std::mutex poolMutex_;
+    std::vector<socket_t> idle_;
+};
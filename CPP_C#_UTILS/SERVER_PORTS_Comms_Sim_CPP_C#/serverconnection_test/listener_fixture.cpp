@@ -0,0 +1,257 @@
+/*
+ * Loopback Multi-Port Listener Fixture (Linux)
+ * Author: Alushi
+ * Description:
+ *   - C++ counterpart to MultiPortServerSim for load-testing the prober on one box.
+ *   - Opens thousands of listening ports, accepts with accept4() in batches off epoll.
+ *   - Optional SO_REUSEPORT sharding: every worker binds every port, the kernel spreads SYNs.
+ *   - Reports accepts per second once a second and a summary on Ctrl+C.
+ *   - Standalone tool (own main), not part of the serverconnection_test project:
+ *       g++ -O2 -std=c++17 -pthread listener_fixture.cpp -o listener_fixture
+ *       ./listener_fixture --ports 20000-20999 --threads 4 --reuseport
+ */
+
+#ifndef __linux__
+#error "listener_fixture needs Linux (epoll, accept4, SO_REUSEPORT)"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+struct FixtureConfig {
+    std::string bindIp = "127.0.0.1";
+    std::vector<int> ports;
+    int threads = 1;
+    bool reusePort = false;     // Each worker binds every port; otherwise ports are split across workers
+    bool hold = false;          // Keep accepted connections until the peer closes (default: close at once)
+    int backlog = 4096;
+    int acceptBatch = 64;       // Max accept4() calls per ready listener per wakeup
+    int reportMs = 1000;
+};
+
+// One counter per worker on its own cache line so workers never contend
+struct alignas(64) WorkerCounters {
+    std::atomic<uint64_t> accepts{ 0 };
+    std::atomic<uint64_t> wakeups{ 0 };
+    std::atomic<uint64_t> errors{ 0 };
+};
+
+std::atomic<bool> running{ true };
+
+void onSignal(int) {
+    running.store(false);
+}
+
+bool parsePorts(const std::string& spec, std::vector<int>& out) {
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t comma = spec.find(',', pos);
+        std::string item = spec.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t dash = item.find('-');
+        int lo = std::atoi(item.c_str());
+        int hi = (dash == std::string::npos) ? lo : std::atoi(item.c_str() + dash + 1);
+        if (lo <= 0 || hi > 65535 || hi < lo) return false;
+        for (int p = lo; p <= hi; p++) out.push_back(p);
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return !out.empty();
+}
+
+void raiseFdLimit() {
+    rlimit lim{};
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+}
+
+int openListener(const FixtureConfig& cfg, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (cfg.reusePort) setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, cfg.bindIp.c_str(), &addr.sin_addr);
+
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, cfg.backlog) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Listener fds are tagged in epoll data with the high bit so held connections can share the set
+const uint64_t kListenerTag = 1ull << 63;
+
+void workerLoop(const FixtureConfig& cfg, std::vector<int> listeners, WorkerCounters& counters) {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    for (int fd : listeners) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = kListenerTag | (uint32_t)fd;
+        epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    epoll_event events[256];
+    while (running.load(std::memory_order_relaxed)) {
+        int n = epoll_wait(ep, events, 256, 200);
+        if (n <= 0) continue;
+        counters.wakeups.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t accepted = 0;
+        for (int i = 0; i < n; i++) {
+            uint64_t tag = events[i].data.u64;
+            int fd = (int)(uint32_t)tag;
+
+            if (!(tag & kListenerTag)) {
+                // Held connection: peer closed or sent data; either way we are done with it
+                close(fd);
+                continue;
+            }
+
+            for (int k = 0; k < cfg.acceptBatch; k++) {
+                int c = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (c < 0) {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                        counters.errors.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+                accepted++;
+                if (cfg.hold) {
+                    epoll_event ev{};
+                    ev.events = EPOLLIN | EPOLLRDHUP;
+                    ev.data.u64 = (uint32_t)c;
+                    if (epoll_ctl(ep, EPOLL_CTL_ADD, c, &ev) < 0) close(c);
+                }
+                else {
+                    close(c);
+                }
+            }
+        }
+        counters.accepts.fetch_add(accepted, std::memory_order_relaxed);
+    }
+
+    for (int fd : listeners) close(fd);
+    close(ep);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    FixtureConfig cfg;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--ports" && hasValue) {
+            if (!parsePorts(argv[++i], cfg.ports)) {
+                std::cerr << "[!] Invalid port spec: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--bind" && hasValue) cfg.bindIp = argv[++i];
+        else if (arg == "--threads" && hasValue) cfg.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--backlog" && hasValue) cfg.backlog = std::atoi(argv[++i]);
+        else if (arg == "--batch" && hasValue) cfg.acceptBatch = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--report-ms" && hasValue) cfg.reportMs = std::max(100, std::atoi(argv[++i]));
+        else if (arg == "--reuseport") cfg.reusePort = true;
+        else if (arg == "--hold") cfg.hold = true;
+        else {
+            std::cerr << "Usage: listener_fixture --ports <a-b,c,...> [--bind ip] [--threads n] [--reuseport]\n"
+                "                        [--hold] [--backlog n] [--batch n] [--report-ms ms]\n";
+            return 1;
+        }
+    }
+    if (cfg.ports.empty()) parsePorts("7129-7130", cfg.ports);   // Same defaults as MultiPortServerSim
+
+    raiseFdLimit();
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    // With SO_REUSEPORT every worker owns a listener per port; otherwise ports are dealt round-robin
+    std::vector<std::vector<int>> perWorker(cfg.threads);
+    size_t opened = 0, failed = 0;
+    for (int w = 0; w < cfg.threads; w++) {
+        for (size_t p = 0; p < cfg.ports.size(); p++) {
+            if (!cfg.reusePort && (int)(p % cfg.threads) != w) continue;
+            int fd = openListener(cfg, cfg.ports[p]);
+            if (fd < 0) {
+                failed++;
+                continue;
+            }
+            perWorker[w].push_back(fd);
+            opened++;
+        }
+    }
+
+    std::cout << "=== Listener Fixture ===\n"
+        << "Listening on " << cfg.bindIp << ", " << cfg.ports.size() << " ports, "
+        << opened << " sockets (" << failed << " failed), " << cfg.threads << " workers"
+        << (cfg.reusePort ? ", SO_REUSEPORT" : "") << (cfg.hold ? ", holding connections" : "") << "\n";
+    if (opened == 0) return 1;
+
+    std::vector<WorkerCounters> counters(cfg.threads);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < cfg.threads; w++)
+        workers.emplace_back(workerLoop, std::cref(cfg), perWorker[w], std::ref(counters[w]));
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto last = start;
+    uint64_t lastTotal = 0;
+    double peakRate = 0.0;
+
+    while (running.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(cfg.reportMs));
+        auto now = Clock::now();
+        uint64_t total = 0, wakeups = 0, errors = 0;
+        for (auto& c : counters) {
+            total += c.accepts.load(std::memory_order_relaxed);
+            wakeups += c.wakeups.load(std::memory_order_relaxed);
+            errors += c.errors.load(std::memory_order_relaxed);
+        }
+        double secs = std::chrono::duration<double>(now - last).count();
+        double rate = (total - lastTotal) / secs;
+        if (rate > peakRate) peakRate = rate;
+
+        std::cout << "[FIXTURE] accepts/s: " << (uint64_t)rate
+            << " | total: " << total
+            << " | per wakeup: " << (wakeups ? (double)total / wakeups : 0.0)
+            << " | errors: " << errors << "\n";
+
+        last = now;
+        lastTotal = total;
+    }
+
+    for (auto& t : workers) t.join();
+    lastTotal = 0;
+    for (auto& c : counters) lastTotal += c.accepts.load();
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "[FIXTURE] done: " << lastTotal << " accepts in " << elapsed << " s, avg "
+        << (uint64_t)(lastTotal / elapsed) << "/s, peak " << (uint64_t)peakRate << "/s\n";
+    return 0;
+}
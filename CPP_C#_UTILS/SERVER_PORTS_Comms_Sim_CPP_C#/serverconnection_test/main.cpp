@@ -4,7 +4,45 @@
  * Description:
  *   - Continuously monitors a given IP by attempting TCP connections.
  *   - If the host is unreachable for a configured threshold, sets serverConnection = false.
- *   - Also supports on-demand port testing from user input.
+ *   - Optional phi-accrual detection (--phi) adapts to each target's observed check rhythm.
+ *   - Optional persistent-connection mode (--persistent, Linux) holds one link open instead.
+ *   - Optional HTTP health mode (--http [path]) requires a 2xx from GET /health, not just a connect.
+ *   - Optional TLS mode (--tls [sni], needs PROBE_WITH_OPENSSL) times the handshake phases.
+ *   - Plain checks run through the policy probe core (probe_policy.h): --transport udp|icmp,
+ *     --completion banner|head and --adaptive-timeout pick its instantiation once at startup;
+ *     --perf or --trace-sample picks the traced one, whose per-status totals "stats" prints.
+ *   - Also supports on-demand port testing from user input, optionally with a banner grab.
+ *     Tests, scans and watches run as background jobs (probe_jobs.h), so the prompt never
+ *     blocks and results print as they arrive. Optional --test-cache [ttl ms] answers repeated
+ *     tests from a result cache and merges identical tests in flight (probe_cache.h).
+ *   - Optional --board [name] publishes the target's status (every scheduler target's with
+ *     --targets) in shared memory (status_board.h) so other processes can read it without
+ *     talking to this one.
+ *   - Optional --control [path] (Linux) serves status/test/scan/subscribe on a Unix socket
+ *     (control_server.h) for scripts and other tools.
+ *   - Optional --batch <file|-> (batch_mode.h) probes a list of target specs through the
+ *     concurrent engine, writes NDJSON results and exits instead of monitoring. With
+ *     --exposure <file> it also keeps the open ports per host as compressed port maps
+ *     (port_map.h) and reports what opened or closed since the last run;
+ *     --exposure-diff <old> <new> compares two saved maps.
+ *   - Optional --log <file> appends every check (and batch result) to a compact binary result
+ *     log (result_log.h); --log-dump <file> prints a target / time-range slice of one as NDJSON.
+ *   - Every check of the monitor and of watches lands in a fixed-memory per-target history
+ *     (target_history.h); "uptime [target] [window]" answers from its minute / hour rollups.
+ *   - Optional --snapshot <file> saves monitor state, scheduler targets and histories periodically
+ *     (state_snapshot.h) and restores them on start, so a restart keeps its estimators, target
+ *     health and check phases.
+ *   - Optional --targets <file> monitors every target listed there (target_config.h) on a timing
+ *     wheel (target_scheduler.h) instead of the single --ip/--port target; edits to the file are
+ *     picked up live and applied as a diff. Its results reach history, log and events through
+ *     lock-free per-worker queues (result_pipeline.h; --result-queue, --result-overflow).
+ *     Their histories are rollup-sized (--target-history raw,minutes,hours; about 3.7 KB per
+ *     target by default) so large target files stay within a bounded footprint.
+ *   - Probe work is split into priority classes (probe_priority.h): critical / normal monitored
+ *     targets, interactive tests and bulk scans; --dispatch strict|weighted picks how queued
+ *     work is ordered. "jobs" and "targets" show queue delay per class.
+ *   - Optional --perf (Linux) counts cycles/instructions/cache misses/context switches per probe.
+ *   - Builds with PROBE_TRACE add per-phase probe timings ("stats") and Chrome trace export.
  */
 
 #include <iostream>
@@ -13,6 +51,40 @@
 #include <chrono>
 #include <atomic>
 #include <vector>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "phi_accrual.h"
+#include "persistent_link.h"
+#include "http_probe.h"
+#include "target_stats.h"
+#include "banner_grab.h"
+#include "tls_probe.h"
+#include "port_probe.h"
+#include "probe_policy.h"
+#include "probe_trace.h"
+#include "perf_counters.h"
+#include "status_board.h"
+#include "control_server.h"
+#include "probe_jobs.h"
+#include "probe_cache.h"
+#include "probe_engine.h"
+#include "batch_mode.h"
+#include "target_spec.h"
+#include "result_log.h"
+#include "target_history.h"
+#include "state_snapshot.h"
+#include "target_config.h"
+#include "target_scheduler.h"
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -29,68 +101,266 @@
  // Shared atomic flag used for monitoring thread communication
 std::atomic<bool> serverConnection{ true };
 
-// ---------- TCP-BASED SERVER CHECK ----------
-// Attempts to connect to a host on a given port with a short timeout
-bool isHostReachable(const std::string& ip, int port = 80, int timeoutMs = 500) {
-#ifdef _WIN32
-    WSADATA wsa;
-    WSAStartup(MAKEWORD(2, 2), &wsa);
-#endif
+// Set at exit: the monitor thread finishes its current check and returns, so main can join it
+// before tearing down what it publishes to (board, log, control socket, histories)
+std::atomic<bool> monitorStop{ false };
+std::mutex monitorStopMutex;
+std::condition_variable monitorStopCv;
 
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) return false;
+// Sleeps until 'until' unless a stop is requested first; false once stopping
+bool monitorSleepUntil(std::chrono::steady_clock::time_point until) {
+    std::unique_lock<std::mutex> lock(monitorStopMutex);
+    return !monitorStopCv.wait_until(lock, until, [] { return monitorStop.load(); });
+}
 
-#ifdef _WIN32
-    u_long mode = 1;
-    ioctlsocket(sockfd, FIONBIO, &mode); // Set non-blocking mode
-#else
-    fcntl(sockfd, F_SETFL, O_NONBLOCK);
+void stopMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(monitorStopMutex);
+        monitorStop.store(true);
+    }
+    monitorStopCv.notify_all();
+}
+
+// Last suspicion level computed by the phi-accrual detector (0 when unused)
+std::atomic<double> serverPhi{ 0.0 };
+
+// Last kernel-smoothed RTT of the persistent link in ms (0 when unused)
+std::atomic<double> serverRttMs{ 0.0 };
+
+// Per-phase probe latencies of the monitored target (HTTP / TLS modes)
+TargetStats serverStats;
+std::mutex serverStatsMutex;
+
+// Counter totals of the monitor's checks and of the engine loops behind the REPL's scans,
+// watches and tests and the control socket's jobs (--perf)
+PerfAccumulator monitorPerf;
+PerfAccumulator scanPerf;
+PerfAccumulator watchPerf;
+PerfAccumulator testPerf;
+PerfAccumulator controlPerf;
+
+// Per-status totals of the plain checks' traced probe variant (--perf / --trace-sample; guarded by serverStatsMutex)
+ProbeCounts plainCounts;
+bool plainTraced = false;
+
+// Latest check of the monitored target, as published to the board and control socket
+// (guarded by serverStatsMutex; serverTarget is set once before the monitor starts)
+TargetStatus serverStatus;
+std::string serverTarget;
+
+// Shared-memory copy of the monitor's view for other processes (--board); slot -1 = off
+StatusBoardWriter statusBoard;
+std::atomic<int> statusBoardSlot{ -1 };
+
+// Long-term history of the monitor's checks (--log)
+ResultLogWriter resultLog;
+
+// Raw ring + minute / hour rollups per "ip:port" of the monitor, scheduler targets and REPL
+// watches ("uptime"); smaller rings in --targets mode
+TargetHistoryTable targetHistory;
+
+// Ring sizes of every history in --targets mode: last 16 checks, an hour of minutes, two days of hours
+const TargetHistorySizes kTargetHistorySizes = { 16, 60, 48 };
+
+// Results of on-demand tests, shared by the REPL and the control socket (--test-cache); null when off
+std::unique_ptr<ProbeCache> testCache;
+
+// "(fresh)", "(cached, 1.2 s old)" or "(joined a test in flight)" after a cached test result
+std::string describeCacheAnswer(const ProbeCacheAnswer& a) {
+    if (a.source == ProbeCacheSource::Fresh) return " (fresh)";
+    if (a.source == ProbeCacheSource::Joined) return " (joined a test in flight)";
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(1);
+    out << " (cached, " << a.ageMs / 1000.0 << " s old)";
+    return out.str();
+}
+
+#ifdef __linux__
+// Unix-socket query API (--control); null when off
+std::unique_ptr<ControlServer> controlServer;
 #endif
 
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    inet_pton(AF_INET, ip.c_str(), &addr.sin_addr);
+// Config-driven multi-target monitor (--targets), replacing the single-target one; null when off
+std::unique_ptr<TargetScheduler> targetScheduler;
+
+// Board entries for --targets mode; each scheduler target claims one on its first check
+const uint32_t kTargetBoardCapacity = 65536;
+
+// Monitor settings; defaults reproduce the original 5s / 3-strike behavior
+struct MonitorConfig {
+    int port = 80;
+    int intervalMs = 5000;          // Time between checks
+    int probeTimeoutMs = 500;       // Connect timeout per check
+    int failureThreshold = kDefaultFailureThreshold;   // Strike mode: consecutive failures before Offline
+    bool usePhiAccrual = false;     // Replace strike counting with phi-accrual detection
+    double phiThreshold = kDefaultPhiThreshold;       // Phi mode: suspicion level treated as Offline
+    double phiMinStdDevMs = kDefaultPhiMinStdDevMs;   // Phi mode: jitter floor, raise for noisy WAN targets
+    double phiPauseMs = 0.0;        // Phi mode: extra tolerated silence on top of the mean
+    bool persistent = false;        // Hold one connection open and watch it instead of reconnecting
+    PersistentLinkOptions link;     // Persistent mode: keepalive / user-timeout tuning
+    bool http = false;              // Check with an HTTP GET instead of a bare connect
+    HttpProbeOptions httpOpts;      // HTTP mode: path and per-phase deadlines
+    bool tls = false;               // Check with a timed TLS handshake instead of a bare connect
+    TlsProbeOptions tlsOpts;        // TLS mode: SNI, deadlines, session reuse
+    ProbeVariant probe;             // Plain checks: transport, completion check, timeout strategy
+};
+
+// Estimator and schedule state of the monitor, refreshed after every check for snapshots
+// (--snapshot) and used to seed a restarted monitor; guarded by serverStatsMutex
+struct MonitorState {
+    int failureCount = 0;
+    std::vector<double> phiIntervals;   // Oldest first
+    int64_t lastHeartbeatUnixMs = 0;    // Last success seen by the phi detector, 0 if none
+    int64_t nextCheckUnixMs = 0;        // 0 = check immediately
+};
+MonitorState monitorState;
+
+// Fixed part of the snapshot's monitor section; phiIntervals doubles follow it
+struct MonitorSnapshot {
+    char target[48];                    // serverTarget it belongs to; other targets ignore it
+    int32_t failureCount;
+    uint32_t phiIntervals;
+    double sinceHeartbeatMs;            // -1 if none; restart downtime is not counted
+    int64_t nextCheckInMs;              // Schedule phase at save time
+    TargetStatus status;
+    TargetStats stats;
+};
 
-    connect(sockfd, (sockaddr*)&addr, sizeof(addr)); // Non-blocking connect
+int64_t unixMsNow() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
 
-    fd_set writeSet;
-    FD_ZERO(&writeSet);
-    FD_SET(sockfd, &writeSet);
+// REPL job output arrives on runner threads; whole lines only, never interleaved
+std::mutex consoleMutex;
 
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = timeoutMs * 1000;
+void printAsync(const std::string& line) {
+    std::lock_guard<std::mutex> lock(consoleMutex);
+    std::cout << line << std::endl;
+}
 
-    int res = select(sockfd + 1, nullptr, &writeSet, nullptr, &tv);
+// ---------- STATUS PUBLICATION ----------
+// One-line form used by the control socket: "<ip>:<port> online phi=.. rtt=..ms ..."
+std::string formatStatus(const TargetStatus& s) {
+    const char* health = s.health == TargetHealth::Online ? "online"
+        : s.health == TargetHealth::Offline ? "offline" : "unknown";
+    return serverTarget + " " + health
+        + " phi=" + std::to_string(s.phi)
+        + " rtt=" + std::to_string(s.rttMs) + "ms"
+        + " failures=" + std::to_string(s.consecutiveFailures)
+        + " probes=" + std::to_string(s.probes)
+        + " failed=" + std::to_string(s.failures)
+        + " changed=" + std::to_string(s.lastChangeUnixMs);
+}
 
-    bool connected = false;
-    if (res > 0) {
-        int so_error = 0;
-        socklen_t len = sizeof(so_error);
-        getsockopt(sockfd, SOL_SOCKET, SO_ERROR, (char*)&so_error, &len);
-        connected = (so_error == 0);
+// Folds one check into serverStatus and hands it to the status board (--board) and to
+// control-socket subscribers (--control; only on Online <-> Offline changes)
+void publishStatus(bool reachable, int failureCount, double rttMs) {
+    uint64_t now = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    TargetHealth health = serverConnection ? TargetHealth::Online : TargetHealth::Offline;
+
+    TargetStatus snapshot;
+    bool changed;
+    {
+        std::lock_guard<std::mutex> lock(serverStatsMutex);
+        changed = (health != serverStatus.health);
+        if (changed) serverStatus.lastChangeUnixMs = now;
+        serverStatus.health = health;
+        serverStatus.consecutiveFailures = (uint32_t)failureCount;
+        monitorState.failureCount = failureCount;
+        serverStatus.phi = (float)serverPhi.load();
+        serverStatus.rttMs = (float)rttMs;
+        serverStatus.lastCheckUnixMs = now;
+        serverStatus.probes++;
+        if (!reachable) serverStatus.failures++;
+        snapshot = serverStatus;
     }
 
-#ifdef _WIN32
-    closesocket(sockfd);
-    WSACleanup();
-#else
-    close(sockfd);
+    int slot = statusBoardSlot.load();
+    if (slot >= 0) statusBoard.publish(slot, snapshot);
+    targetHistory.record(serverTarget, (int64_t)now, reachable, (float)rttMs);
+    // Logged as open / error: a failed check does not say whether it was refused or timed out
+    resultLog.append(snapshot.addr, snapshot.port, reachable ? ProbeStatus::Open : ProbeStatus::Error,
+        (float)rttMs, (int64_t)now);
+#ifdef __linux__
+    if (changed && controlServer) controlServer->broadcast("status " + formatStatus(snapshot));
 #endif
-
-    return connected;
 }
 
 // ---------- SERVER MONITOR ----------
 // Periodically checks if the server is reachable; updates global status flag
-void monitorServer(const std::string& ip) {
-    int failureCount = 0;
-    const int intervalMs = 5000;           // 5 seconds between checks
-    const int failureThreshold = 3;        // Fail after 3 consecutive failures (~15s)
+void monitorServer(const std::string& ip, MonitorConfig cfg, MonitorState resume) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto nowMs = [&]() {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    int failureCount = resume.failureCount;
+    PhiAccrualDetector detector(kDefaultPhiWindow, cfg.phiMinStdDevMs, cfg.phiPauseMs, cfg.intervalMs);
+    if (!resume.phiIntervals.empty())
+        detector.restore(resume.phiIntervals, nowMs() - (double)(unixMsNow() - resume.lastHeartbeatUnixMs));
+    auto nextCheck = Clock::now();
+    if (resume.nextCheckUnixMs > unixMsNow())
+        nextCheck += std::chrono::milliseconds(resume.nextCheckUnixMs - unixMsNow());
+    if (!monitorSleepUntil(nextCheck)) return;
+
+    // The plain check's policy instantiation is chosen once here, not per check
+    std::string probeError;
+    std::unique_ptr<ProbeRunner> plain = makeProbeRunner(cfg.probe, probeError);
+    ProbeTarget target;
+    makeProbeTarget(ip, cfg.port, target);
+
+    std::unique_ptr<HttpHealthProbe> http;
+    if (cfg.http) http.reset(new HttpHealthProbe(ip, cfg.port, cfg.httpOpts));
+#ifdef PROBE_WITH_OPENSSL
+    std::unique_ptr<TlsHandshakeProbe> tls;
+    if (cfg.tls) tls.reset(new TlsHandshakeProbe(ip, cfg.port, cfg.tlsOpts));
+#endif
 
     while (true) {
-        bool reachable = isHostReachable(ip, 80);
+        bool reachable;
+        const auto checkStart = Clock::now();
+        PerfScope perfScope(&monitorPerf, 1);
+#ifdef PROBE_WITH_OPENSSL
+        if (tls) {
+            TlsProbeResult res = tls->probe();
+            {
+                std::lock_guard<std::mutex> lock(serverStatsMutex);
+                recordTlsProbe(serverStats, res);
+            }
+            reachable = res.ok;
+            std::cerr << "[DEBUG] TLS " << (res.ok ? res.protocol : res.error)
+                << (res.resumed ? " (resumed)" : "")
+                << " | connect " << res.connectMs << " ms"
+                << " | server hello " << res.serverHelloMs << " ms"
+                << " | handshake " << res.handshakeMs << " ms\n";
+        }
+        else
+#endif
+        if (http) {
+            HttpProbeResult res = http->probe();
+            {
+                std::lock_guard<std::mutex> lock(serverStatsMutex);
+                recordHttpProbe(serverStats, res);
+            }
+            reachable = res.healthy;
+            std::cerr << "[DEBUG] HTTP " << cfg.httpOpts.path << " -> " << res.status
+                << (res.reused ? " (reused)" : "")
+                << " | connect " << res.connectMs << " ms"
+                << " | first byte " << res.firstByteMs << " ms"
+                << " | complete " << res.completeMs << " ms\n";
+        }
+        else {
+            reachable = plain && plain->probe(target).status == ProbeStatus::Open;
+            if (plain && plain->counts()) {
+                std::lock_guard<std::mutex> lock(serverStatsMutex);
+                plainCounts = *plain->counts();
+            }
+        }
+        perfScope.stop();
 
         if (reachable) {
             failureCount = 0;
@@ -99,7 +369,18 @@ void monitorServer(const std::string& ip) {
             failureCount++;
         }
 
-        if (failureCount >= failureThreshold) {
+        if (cfg.usePhiAccrual) {
+            double now = nowMs();
+            if (reachable) detector.heartbeat(now);
+            double phi = detector.phi(now);
+            serverPhi.store(phi);
+            // No distribution yet (target never answered): fall back to strike counting
+            if (detector.samples() == 0)
+                serverConnection.store(failureCount < cfg.failureThreshold);
+            else
+                serverConnection.store(phi < cfg.phiThreshold);
+        }
+        else if (failureCount >= cfg.failureThreshold) {
             serverConnection.store(false);
         }
         else {
@@ -109,95 +390,864 @@ void monitorServer(const std::string& ip) {
         // Print current status for debug purposes
         std::cerr << "[DEBUG] Check IP: " << ip
             << " | Reachable: " << reachable
-            << " | Failures: " << failureCount
-            << " | Status: " << (serverConnection ? "Online" : "Offline") << "\n";
+            << " | Failures: " << failureCount;
+        if (cfg.usePhiAccrual) std::cerr << " | Phi: " << serverPhi.load();
+        std::cerr << " | Status: " << (serverConnection ? "Online" : "Offline") << "\n";
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+        publishStatus(reachable, failureCount,
+            std::chrono::duration<double, std::milli>(Clock::now() - checkStart).count());
+
+        // Fixed-rate schedule so probe time doesn't stretch the interval (phi relies on it)
+        nextCheck += std::chrono::milliseconds(cfg.intervalMs);
+        if (nextCheck < Clock::now()) nextCheck = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(serverStatsMutex);
+            int64_t unixNow = unixMsNow();
+            monitorState.nextCheckUnixMs = unixNow
+                + std::chrono::duration_cast<std::chrono::milliseconds>(nextCheck - Clock::now()).count();
+            if (cfg.usePhiAccrual && detector.hasHeartbeat()) {
+                monitorState.phiIntervals = detector.intervals();
+                monitorState.lastHeartbeatUnixMs = unixNow - (int64_t)(nowMs() - detector.lastHeartbeatMs());
+            }
+        }
+        if (!monitorSleepUntil(nextCheck)) return;
     }
 }
 
-// ---------- PORT TEST ----------
-// Tests a specific port using non-blocking TCP connection
-bool testPortFast(const std::string& ip, int port, int timeoutMs = 200) {
-#ifdef _WIN32
-    WSADATA wsa;
-    WSAStartup(MAKEWORD(2, 2), &wsa);
+// ---------- PERSISTENT MONITOR ----------
+// Holds one connection open; death is reported by epoll the moment the kernel sees it.
+// RTT comes from TCP_INFO every interval. Reconnects only after the link drops.
+#ifdef __linux__
+// One interval on the link, in short slices so a stop request is noticed within 250 ms
+LinkEvent waitLinkInterval(PersistentLink& link, int intervalMs) {
+    const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(intervalMs);
+    while (!monitorStop.load()) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(until - std::chrono::steady_clock::now()).count();
+        if (left <= 0) break;
+        if (link.wait((int)std::min<int64_t>(left, 250)) == LinkEvent::Dropped) return LinkEvent::Dropped;
+    }
+    return LinkEvent::Idle;
+}
+
+void monitorServerPersistent(const std::string& ip, MonitorConfig cfg, MonitorState resume) {
+    PersistentLink link(ip, cfg.port, cfg.link);
+    int failureCount = resume.failureCount;
+
+    while (!monitorStop.load()) {
+        if (!link.isOpen()) {
+            if (link.open(cfg.probeTimeoutMs)) {
+                failureCount = 0;
+                serverConnection.store(true);
+                publishStatus(true, failureCount, serverRttMs.load());
+                std::cerr << "[DEBUG] Link up IP: " << ip << ":" << cfg.port << "\n";
+            }
+            else {
+                failureCount++;
+                serverConnection.store(failureCount < cfg.failureThreshold);
+                publishStatus(false, failureCount, 0.0);
+                std::cerr << "[DEBUG] Connect IP: " << ip
+                    << " | Failures: " << failureCount
+                    << " | Status: " << (serverConnection ? "Online" : "Offline") << "\n";
+                monitorSleepUntil(std::chrono::steady_clock::now() + std::chrono::milliseconds(cfg.intervalMs));
+                continue;
+            }
+        }
+
+        if (waitLinkInterval(link, cfg.intervalMs) == LinkEvent::Dropped) {
+            link.close();
+            // The drop itself is strong evidence; one immediate reconnect attempt decides
+            if (link.open(cfg.probeTimeoutMs)) {
+                std::cerr << "[DEBUG] Link dropped and re-established IP: " << ip << "\n";
+                continue;
+            }
+            failureCount = cfg.failureThreshold;
+            serverConnection.store(false);
+            publishStatus(false, failureCount, 0.0);
+            std::cerr << "[DEBUG] Link dropped IP: " << ip << " | Status: Offline\n";
+            continue;
+        }
+
+        if (monitorStop.load()) break;
+        double srtt = 0.0, rttVar = 0.0;
+        if (link.sampleRtt(srtt, rttVar)) serverRttMs.store(srtt);
+        publishStatus(true, failureCount, srtt);
+        std::cerr << "[DEBUG] Link IP: " << ip
+            << " | RTT: " << srtt << " ms (var " << rttVar << ")"
+            << " | Status: " << (serverConnection ? "Online" : "Offline") << "\n";
+    }
+}
 #endif
 
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) return false;
+// ---------- WARM RESTART ----------
+// Writes monitor state, scheduler targets and every target history to 'path' (atomically
+// replacing it); the histories stream into the file, so a save never holds a second copy of them
+bool saveSnapshot(const std::string& path) {
+    int64_t now = unixMsNow();
+    MonitorSnapshot rec{};
+    std::vector<double> intervals;
+    {
+        std::lock_guard<std::mutex> lock(serverStatsMutex);
+        rec.failureCount = monitorState.failureCount;
+        intervals = monitorState.phiIntervals;
+        rec.sinceHeartbeatMs = monitorState.lastHeartbeatUnixMs ? (double)(now - monitorState.lastHeartbeatUnixMs) : -1.0;
+        rec.nextCheckInMs = monitorState.nextCheckUnixMs ? monitorState.nextCheckUnixMs - now : 0;
+        rec.status = serverStatus;
+        rec.stats = serverStats;
+    }
+    std::strncpy(rec.target, serverTarget.c_str(), sizeof(rec.target) - 1);
+    rec.phiIntervals = (uint32_t)intervals.size();
 
-#ifdef _WIN32
-    u_long mode = 1;
-    ioctlsocket(sockfd, FIONBIO, &mode);
+    SnapshotWriter w;
+    if (!w.open(path)) return false;
+    w.begin(SnapshotSection::Monitor, sizeof(rec) + intervals.size() * sizeof(double));
+    w.write(&rec, sizeof(rec));
+    w.write(intervals.data(), intervals.size() * sizeof(double));
+    targetHistory.save(w, SnapshotSection::History);
+    if (targetScheduler) {
+        std::vector<TargetResume> targets = targetScheduler->saveState();
+        w.add(SnapshotSection::Targets, targets.data(), targets.size() * sizeof(TargetResume));
+    }
+    return w.commit(now);
+}
+
+// Restores histories, the scheduler targets' state (applied by the first reload) and the
+// monitor's state when the snapshot is for the same target; the time the process was down
+// counts neither against the targets nor the schedule
+void loadSnapshot(const std::string& path, const MonitorConfig& cfg, MonitorState& resume) {
+    SnapshotReader r;
+    if (!r.open(path)) return;
+
+    const uint8_t* data;
+    size_t bytes;
+    size_t histories = 0;
+    if (r.section(SnapshotSection::History, data, bytes)) histories = targetHistory.load(data, bytes);
+    size_t targets = 0;
+    if (targetScheduler && r.section(SnapshotSection::Targets, data, bytes) && bytes % sizeof(TargetResume) == 0) {
+        targets = bytes / sizeof(TargetResume);
+        targetScheduler->restoreState((const TargetResume*)data, targets);
+    }
+
+    bool warm = false;
+    MonitorSnapshot rec;
+    if (r.section(SnapshotSection::Monitor, data, bytes) && bytes >= sizeof(rec)) {
+        std::memcpy(&rec, data, sizeof(rec));
+        rec.target[sizeof(rec.target) - 1] = '\0';
+        warm = serverTarget == rec.target && bytes == sizeof(rec) + rec.phiIntervals * sizeof(double);
+    }
+    if (warm) {
+        int64_t now = unixMsNow();
+        resume.failureCount = rec.failureCount;
+        resume.phiIntervals.resize(rec.phiIntervals);
+        if (rec.phiIntervals) std::memcpy(resume.phiIntervals.data(), data + sizeof(rec), rec.phiIntervals * sizeof(double));
+        if (rec.sinceHeartbeatMs >= 0) resume.lastHeartbeatUnixMs = now - (int64_t)rec.sinceHeartbeatMs;
+        else resume.phiIntervals.clear();
+        resume.nextCheckUnixMs = now + std::max<int64_t>(0, std::min<int64_t>(rec.nextCheckInMs, cfg.intervalMs));
+
+        std::lock_guard<std::mutex> lock(serverStatsMutex);
+        TargetStatus status = rec.status;
+        status.addr = serverStatus.addr;
+        status.port = serverStatus.port;
+        serverStatus = status;
+        serverStats = rec.stats;
+        monitorState = resume;
+        serverConnection.store(status.health != TargetHealth::Offline);
+    }
+    std::cout << "[Snapshot] Restored " << histories << " target histories" << (warm ? " and monitor state" : "")
+        << (targets ? ", " + std::to_string(targets) + " scheduler targets" : "")
+        << " from " << path << " (saved " << (unixMsNow() - r.savedUnixMs()) / 1000 << " s ago)\n";
+}
+
+// "<n>s|m|h|d"; false for anything else
+bool parseDurationMs(const std::string& s, int64_t& ms) {
+    char* end = nullptr;
+    long long v = std::strtoll(s.c_str(), &end, 10);
+    if (end == s.c_str() || v < 0) return false;
+    int64_t unit = *end == 's' ? 1000 : *end == 'm' ? 60000 : *end == 'h' ? 3600000 : *end == 'd' ? 86400000 : 0;
+    if (!unit || end[1] != '\0') return false;
+    ms = v * unit;
+    return true;
+}
+
+// "1760000000000" (unix ms) or a duration meaning that long ago; false if neither
+bool parseTimeArg(const std::string& s, int64_t& unixMs) {
+    char* end = nullptr;
+    long long v = std::strtoll(s.c_str(), &end, 10);
+    if (end != s.c_str() && *end == '\0') {
+        unixMs = v;
+        return true;
+    }
+    int64_t ago;
+    if (!parseDurationMs(s, ago)) return false;
+    unixMs = unixMsNow() - ago;
+    return true;
+}
+
+// ---------- MAIN ----------
+// Usage: serverconnection_test [--ip <addr>] [--port <n>] [--phi [threshold]] [--persistent] [--http [path]]
+//                              [--tls [sni]] [--transport tcp|udp|icmp] [--completion connect|banner|head]
+//                              [--adaptive-timeout [min ms]] [--interval <ms>] [--timeout <ms>] [--board [name]]
+//                              [--control [socket path]] [--log <file>] [--snapshot <file>]
+//                              [--snapshot-every <ms>] [--targets <file>] [--target-history <raw>,<min>,<hours>]
+//                              [--result-queue <n>]
+//                              [--result-overflow drop|block] [--test-cache [ttl ms]]
+//                              [--dispatch strict|weighted] [--perf] [--trace-sample <n>]
+//        serverconnection_test --batch <file|-> [--batch-out <file>] [--batch-ports <list>]
+//                              [--window <n>] [--timeout <ms>] [--log <file>] [--exposure <file>]
+//        serverconnection_test --exposure-diff <old map> <new map>
+//        serverconnection_test --log-dump <file> [--log-target <ip>[:port]] [--log-from <t>] [--log-to <t>]
+int main(int argc, char* argv[]) {
+    std::string ip = "127.0.0.1"; // Single monitored target (--ip), also the REPL's test/scan target
+    MonitorConfig cfg;
+    std::string boardName;
+    std::string controlPath;
+    bool batch = false;
+    BatchOptions batchOpts;
+    std::string logPath;
+    std::string targetsPath;
+    TargetSchedulerOptions schedOpts;
+    TargetHistorySizes schedHistory = kTargetHistorySizes;
+    std::string snapshotPath;
+    int snapshotEveryMs = 30000;
+    std::string logDumpPath;
+    ResultLogQuery logQuery;
+    std::string exposureDiff[2];
+    int testCacheTtlMs = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--phi") {
+            cfg.usePhiAccrual = true;
+            if (hasValue && argv[i + 1][0] != '-') cfg.phiThreshold = std::atof(argv[++i]);
+        }
+        else if (arg == "--persistent") {
+            cfg.persistent = true;
+        }
+        else if (arg == "--http") {
+            cfg.http = true;
+            if (hasValue && argv[i + 1][0] == '/') cfg.httpOpts.path = argv[++i];
+        }
+        else if (arg == "--tls") {
+            cfg.tls = true;
+            if (hasValue && argv[i + 1][0] != '-') cfg.tlsOpts.serverName = argv[++i];
+        }
+        else if (arg == "--transport" && hasValue) {
+            if (!parseProbeTransport(argv[++i], cfg.probe.transport)) {
+                std::cerr << "[!] Unknown transport: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--completion" && hasValue) {
+            if (!parseProbeCompletion(argv[++i], cfg.probe.completion)) {
+                std::cerr << "[!] Unknown completion check: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--adaptive-timeout") {
+            cfg.probe.adaptiveTimeout = true;
+            if (hasValue && argv[i + 1][0] != '-') cfg.probe.minTimeoutMs = std::atoi(argv[++i]);
+        }
+        else if (arg == "--ip" && hasValue) {
+            ip = argv[++i];
+            ProbeTarget check;
+            if (!makeProbeTarget(ip, 1, check)) {
+                std::cerr << "[!] Bad address: " << ip << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--targets" && hasValue) {
+            targetsPath = argv[++i];
+        }
+        else if (arg == "--target-history" && hasValue) {
+            unsigned raw = 0, minutes = 0, hours = 0;
+            if (std::sscanf(argv[++i], "%u,%u,%u", &raw, &minutes, &hours) != 3 || !raw || !minutes || !hours) {
+                std::cerr << "[!] --target-history takes <raw>,<minutes>,<hours> ring sizes\n";
+                return 1;
+            }
+            schedHistory = { raw, minutes, hours };
+        }
+        else if (arg == "--result-queue" && hasValue) {
+            schedOpts.resultQueue = (size_t)std::max(16, std::atoi(argv[++i]));
+        }
+        else if (arg == "--result-overflow" && hasValue) {
+            std::string policy = argv[++i];
+            if (policy != "drop" && policy != "block") {
+                std::cerr << "[!] --result-overflow takes drop or block\n";
+                return 1;
+            }
+            schedOpts.overflow = policy == "drop" ? OverflowPolicy::DropOldest : OverflowPolicy::Backpressure;
+        }
+        else if (arg == "--port" && hasValue) {
+            cfg.port = std::atoi(argv[++i]);
+        }
+        else if ((arg == "--interval" || arg == "--timeout") && hasValue) {
+            // Whole seconds are fine (socket waits split ms into tv_sec / tv_usec); zero or junk is not
+            int ms = std::atoi(argv[++i]);
+            if (ms <= 0) {
+                std::cerr << "[!] " << arg << " takes a positive number of ms\n";
+                return 1;
+            }
+            (arg == "--interval" ? cfg.intervalMs : cfg.probeTimeoutMs) = ms;
+        }
+        else if (arg == "--board") {
+            boardName = (hasValue && argv[i + 1][0] != '-') ? argv[++i] : kStatusBoardDefaultName;
+        }
+        else if (arg == "--control") {
+            controlPath = (hasValue && argv[i + 1][0] != '-') ? argv[++i] : ControlServerOptions().path;
+        }
+        else if (arg == "--batch" && hasValue) {
+            batch = true;
+            batchOpts.input = argv[++i];
+        }
+        else if (arg == "--batch-out" && hasValue) {
+            batchOpts.output = argv[++i];
+        }
+        else if (arg == "--batch-ports" && hasValue) {
+            if (!parsePortList(argv[++i], batchOpts.defaultPorts)) {
+                std::cerr << "[!] Bad port list: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--window" && hasValue) {
+            int window = std::atoi(argv[++i]);
+            batchOpts.window = window > 0 ? (size_t)window : 1;
+        }
+        else if (arg == "--dispatch" && hasValue) {
+            if (!parseDispatchPolicy(argv[++i], schedOpts.dispatch)) {
+                std::cerr << "[!] --dispatch takes strict or weighted\n";
+                return 1;
+            }
+        }
+        else if (arg == "--test-cache") {
+            testCacheTtlMs = ProbeCacheOptions().ttlMs;
+            if (hasValue && argv[i + 1][0] != '-') testCacheTtlMs = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--exposure" && hasValue) {
+            batchOpts.exposurePath = argv[++i];
+        }
+        else if (arg == "--exposure-diff" && i + 2 < argc) {
+            exposureDiff[0] = argv[++i];
+            exposureDiff[1] = argv[++i];
+        }
+        else if (arg == "--log" && hasValue) {
+            logPath = argv[++i];
+        }
+        else if (arg == "--snapshot" && hasValue) {
+            snapshotPath = argv[++i];
+        }
+        else if (arg == "--snapshot-every" && hasValue) {
+            snapshotEveryMs = std::max(1000, std::atoi(argv[++i]));
+        }
+        else if (arg == "--log-dump" && hasValue) {
+            logDumpPath = argv[++i];
+        }
+        else if (arg == "--log-target" && hasValue) {
+            std::string t = argv[++i];
+            size_t colon = t.find(':');
+            bool anyPort = (colon == std::string::npos);
+            ProbeTarget target;
+            if (!makeProbeTarget(t.substr(0, colon), anyPort ? 1 : std::atoi(t.c_str() + colon + 1), target)) {
+                std::cerr << "[!] Bad log target: " << t << "\n";
+                return 1;
+            }
+            logQuery.addr = target.addr;
+            logQuery.port = anyPort ? 0 : target.port;
+        }
+        else if ((arg == "--log-from" || arg == "--log-to") && hasValue) {
+            if (!parseTimeArg(argv[++i], arg == "--log-from" ? logQuery.fromUnixMs : logQuery.toUnixMs)) {
+                std::cerr << "[!] Bad time: " << argv[i] << " (unix ms or e.g. 90m, 24h, 7d ago)\n";
+                return 1;
+            }
+        }
+        else if (arg == "--perf") {
+            perfSetEnabled(true);
+            cfg.probe.instrumented = true;
+        }
+        else if (arg == "--trace-sample" && hasValue) {
+#ifdef PROBE_TRACE
+            traceSetSampleEvery((uint32_t)std::atoi(argv[++i]));
+            cfg.probe.instrumented = true;
 #else
-    fcntl(sockfd, F_SETFL, O_NONBLOCK);
+            ++i;
+            std::cerr << "[!] --trace-sample needs a build with PROBE_TRACE; ignored.\n";
 #endif
+        }
+        else {
+            std::cerr << "[!] Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
 
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    inet_pton(AF_INET, ip.c_str(), &addr.sin_addr);
+    if (cfg.http) cfg.httpOpts.connectTimeoutMs = cfg.probeTimeoutMs;
+    cfg.tlsOpts.connectTimeoutMs = cfg.probeTimeoutMs;
+#ifndef PROBE_WITH_OPENSSL
+    if (cfg.tls) {
+        std::cerr << "[!] --tls needs a build with PROBE_WITH_OPENSSL; using connect checks.\n";
+        cfg.tls = false;
+    }
+#endif
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN); // Writes to dropped peers (TLS shutdown, HTTP reuse) must not kill us
+#endif
 
-    connect(sockfd, (sockaddr*)&addr, sizeof(addr));
+    if (!logDumpPath.empty()) return runLogDump(logDumpPath, logQuery);
+    if (!exposureDiff[0].empty()) return runExposureDiff(exposureDiff[0], exposureDiff[1]);
+    if (!batchOpts.exposurePath.empty() && !batch) {
+        std::cerr << "[!] --exposure needs --batch\n";
+        return 1;
+    }
+    if (batch) {
+        batchOpts.timeoutMs = cfg.probeTimeoutMs;
+        batchOpts.logPath = logPath;
+        return runBatch(batchOpts);
+    }
 
-    fd_set writeSet;
-    FD_ZERO(&writeSet);
-    FD_SET(sockfd, &writeSet);
+    // A probe must finish before the next heartbeat is due, otherwise phi sees late arrivals
+    if (cfg.usePhiAccrual && cfg.probeTimeoutMs > cfg.intervalMs) cfg.probeTimeoutMs = cfg.intervalMs;
 
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = timeoutMs * 1000;
+    cfg.probe.timeoutMs = cfg.probeTimeoutMs;
+    {
+        std::string probeError;
+        if (!makeProbeRunner(cfg.probe, probeError)) {
+            std::cerr << "[!] Bad probe variant: " << probeError << "\n";
+            return 1;
+        }
+        plainTraced = cfg.probe.instrumented && !cfg.http && !cfg.tls && !cfg.persistent;
+    }
 
-    int res = select(sockfd + 1, nullptr, &writeSet, nullptr, &tv);
+    serverTarget = ip + ":" + std::to_string(cfg.port);
+    ProbeTarget self;
+    if (makeProbeTarget(ip, cfg.port, self)) serverStatus.addr = self.addr;
+    serverStatus.port = (uint16_t)cfg.port;
+    if (!logPath.empty()) {
+        if (resultLog.open(logPath)) std::cout << "[Log] Appending checks to " << logPath << "\n";
+        else std::cerr << "[!] Could not open result log " << logPath << ".\n";
+    }
+    if (!boardName.empty()) {
+        // In --targets mode the scheduler's board stage adds its targets; the idle --ip target stays off
+        if (statusBoard.open(boardName, targetsPath.empty() ? 1024 : kTargetBoardCapacity)) {
+            if (targetsPath.empty()) statusBoardSlot.store(statusBoard.addTarget(ip, cfg.port));
+            std::cout << "[Board] Publishing status to shared memory '" << boardName << "'\n";
+        }
+        else {
+            std::cerr << "[!] Could not create status board '" << boardName << "'.\n";
+        }
+    }
+
+    if (!targetsPath.empty()) {
+        targetHistory.setSizes(schedHistory);
+        std::cout << "[Targets] History of " << schedHistory.raw << " checks, " << schedHistory.minutes << " minutes, "
+            << schedHistory.hours << " hours per target (" << schedHistory.bytes() << " bytes)\n";
+
+        // Before the snapshot is loaded, which seeds its targets
+        targetScheduler.reset(new TargetScheduler(schedOpts));
+        targetScheduler->addStage("history", [](const TargetCheck* c, size_t n) {
+            for (size_t i = 0; i < n; i++)
+                targetHistory.record(c[i].key, (int64_t)c[i].state.lastCheckUnixMs, c[i].up, c[i].state.rttMs);
+        });
+        targetScheduler->addStage("log", [](const TargetCheck* c, size_t n) {
+            for (size_t i = 0; i < n; i++)
+                resultLog.append(c[i].state.addr, c[i].state.port, c[i].status, c[i].state.rttMs, (int64_t)c[i].state.lastCheckUnixMs);
+        });
+        targetScheduler->addStage("events", [](const TargetCheck* c, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                if (!c[i].changed) continue;
+                std::string health = c[i].state.health == TargetHealth::Online ? "Online" : "Offline";
+                printAsync("[Target " + c[i].key + "] " + health);
+#ifdef __linux__
+                if (controlServer) controlServer->broadcast("target " + c[i].key + " " + (c[i].up ? "online" : "offline"));
+#endif
+            }
+        });
+        if (statusBoard.isOpen()) {
+            targetScheduler->addStage("board", [slots = std::unordered_map<std::string, int>()](const TargetCheck* c, size_t n) mutable {
+                for (size_t i = 0; i < n; i++) {
+                    auto it = slots.find(c[i].key);
+                    if (it == slots.end())
+                        it = slots.emplace(c[i].key, statusBoard.addTarget(c[i].key.substr(0, c[i].key.rfind(':')), c[i].state.port)).first;
+                    if (it->second >= 0) statusBoard.publish(it->second, c[i].state);
+                }
+            });
+        }
+    }
 
-    bool connected = false;
-    if (res > 0) {
-        int so_error = 0;
-        socklen_t len = sizeof(so_error);
-        getsockopt(sockfd, SOL_SOCKET, SO_ERROR, (char*)&so_error, &len);
-        connected = (so_error == 0);
+    MonitorState resume;
+    if (!snapshotPath.empty()) loadSnapshot(snapshotPath, cfg, resume);
+
+    // Shared by REPL commands and the control socket
+    ProbeJobRunner probeJobs(4, schedOpts.dispatch);
+    const int replProbeTimeoutMs = 200;
+
+    if (!snapshotPath.empty()) {
+        probeJobs.every("snapshot", snapshotEveryMs, [snapshotPath](const std::atomic<bool>&) {
+            if (!saveSnapshot(snapshotPath)) printAsync("[!] Could not write snapshot " + snapshotPath);
+        });
     }
 
-#ifdef _WIN32
-    closesocket(sockfd);
-    WSACleanup();
+    if (testCacheTtlMs > 0) {
+        ProbeCacheOptions cacheOpts;
+        cacheOpts.ttlMs = testCacheTtlMs;
+        testCache.reset(new ProbeCache(cacheOpts));
+    }
+
+    if (!controlPath.empty()) {
+#ifdef __linux__
+        ControlServerOptions copts;
+        copts.path = controlPath;
+        copts.defaultIp = ip;
+        copts.probeTimeoutMs = cfg.probeTimeoutMs;
+        copts.cache = testCache.get();
+        copts.perf = &controlPerf;
+        controlServer.reset(new ControlServer(copts, probeJobs, []() {
+            if (targetScheduler) return targetScheduler->summary();
+            std::lock_guard<std::mutex> lock(serverStatsMutex);
+            return formatStatus(serverStatus);
+        }));
+        if (controlServer->start()) std::cout << "[Control] Listening on " << controlPath << "\n";
+        else {
+            std::cerr << "[!] Could not listen on " << controlPath << ".\n";
+            controlServer.reset();
+        }
 #else
-    close(sockfd);
+        std::cerr << "[!] --control needs Linux; ignored.\n";
 #endif
+    }
 
-    return connected;
-}
+    // Config-driven multi-target monitoring replaces the single-target monitor
+    TargetConfigWatcher targetsWatcher;
+    std::unordered_map<std::string, TargetConfig> appliedTargets;   // Only touched by reloads
+    auto reloadTargets = [&](bool initial) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<TargetConfig> configs;
+        std::string error;
+        if (!loadTargetConfig(targetsPath, configs, error)) {
+            printAsync("[!] Config " + error + (initial ? "" : " (keeping the running targets)"));
+            return false;
+        }
+        TargetConfigDiff diff = diffTargetConfigs(appliedTargets, configs);
+        targetScheduler->apply(diff);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printAsync("[Config] " + std::to_string(appliedTargets.size()) + " targets: +" + std::to_string(diff.added.size())
+            + " -" + std::to_string(diff.removed.size()) + " ~" + std::to_string(diff.changed.size())
+            + " =" + std::to_string(diff.unchanged) + " in " + std::to_string((int)ms) + " ms");
+        return true;
+    };
+    if (targetScheduler) {
+        if (!reloadTargets(true)) return 1;
+        targetScheduler->start();
+        targetsWatcher.start(targetsPath, [&]() { reloadTargets(false); });
+    }
 
-// ---------- MAIN ----------
-int main() {
-    std::string ip = "127.0.0.1"; // Change to target IP for monitoring
-    std::thread monitorThread(monitorServer, ip); // Launch background monitor
+    std::thread monitorThread; // Launch background monitor
+    if (!targetScheduler) {
+#ifdef __linux__
+        if (cfg.persistent) monitorThread = std::thread(monitorServerPersistent, ip, cfg, resume);
+#else
+        if (cfg.persistent) std::cerr << "[!] --persistent needs Linux; using periodic checks.\n";
+#endif
+        if (!monitorThread.joinable()) monitorThread = std::thread(monitorServer, ip, cfg, resume);
+    }
 
     std::cout << "=== Server Monitor & Port Tester ===\n";
     std::cout << "Commands:\n";
     std::cout << "  status       - Show server status\n";
     std::cout << "  test <port>  - Test specific port\n";
+    std::cout << "  test <port> banner - Test port and identify the listening service\n";
+    std::cout << "  test <port> tls    - Time a TLS handshake (resumes on repeat)\n";
+    std::cout << "  scan <lo>-<hi>     - Test a port range, open ports stream in as found\n";
+    std::cout << "  watch <port> [ms]  - Re-test a port periodically, report changes\n";
+    std::cout << "  jobs / cancel <id> - List or stop running tests, scans and watches\n";
+    std::cout << "  cache [clear]      - Test result cache counters (--test-cache), or empty it\n";
+    std::cout << "  uptime [ip[:port]] [24h] - Uptime and RTT of the monitor or a watched port\n";
+    if (targetScheduler) std::cout << "  targets [n]  - Health of the configured targets (--targets)\n";
+    std::cout << "  stats        - Probe counters (--perf) and per-phase timings (PROBE_TRACE builds)\n";
+    std::cout << "  trace <file> - Write sampled probe phases as Chrome trace JSON\n";
     std::cout << "  exit         - Quit\n";
 
+#ifdef PROBE_WITH_OPENSSL
+    std::map<int, std::unique_ptr<TlsHandshakeProbe>> tlsProbes; // Kept per port so repeats resume
+    std::mutex tlsProbesMutex;                                   // TLS tests run one at a time
+#endif
+
     std::string input;
     while (true) {
-        std::cout << "> ";
-        std::getline(std::cin, input);
+        {
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cout << "> " << std::flush;
+        }
+        if (!std::getline(std::cin, input) || input == "exit") break;
 
-        if (input == "exit") break;
+        if (input == "status" && targetScheduler) {
+            std::cout << "[Targets] " << targetScheduler->online() << " of " << targetScheduler->size() << " online\n";
+        }
+        else if (input == "targets" || input.rfind("targets ", 0) == 0) {
+            if (!targetScheduler) {
+                std::cout << "[!] No target file (start with --targets <file>).\n";
+                continue;
+            }
+            size_t n = input.size() > 8 ? (size_t)std::strtoul(input.c_str() + 8, nullptr, 10) : 20;
+            std::cout << "[Targets] " << targetScheduler->online() << " of " << targetScheduler->size() << " online, "
+                << targetScheduler->overdue() << " overdue\n";
+            for (const std::string& line : targetScheduler->describe(n)) std::cout << "  " << line << "\n";
+            std::cout << "[Pipeline]\n";
+            for (const std::string& line : targetScheduler->describePipeline()) std::cout << "  " << line << "\n";
+            std::cout << "[Queues] " << dispatchPolicyName(schedOpts.dispatch) << " dispatch\n";
+            for (const std::string& line : targetScheduler->describeQueues()) std::cout << "  " << line << "\n";
+        }
+        else if (input == "status") {
+            std::cout << "[Server status] " << (serverConnection ? "Online" : "Offline");
+            if (cfg.usePhiAccrual) std::cout << " (phi " << serverPhi.load() << ")";
+            if (cfg.persistent) std::cout << " (rtt " << serverRttMs.load() << " ms)";
+            std::cout << "\n";
+            if (cfg.tls) {
+                std::lock_guard<std::mutex> lock(serverStatsMutex);
+                std::cout << "  probes " << serverStats.probes << ", failed " << serverStats.failures
+                    << ", resumed " << serverStats.resumedSessions
+                    << ", cert expires in " << serverStats.certDaysLeft << " days\n"
+                    << "  connect      " << serverStats.connect << "\n"
+                    << "  server hello " << serverStats.serverHello << "\n"
+                    << "  handshake    " << serverStats.handshake << "\n";
+            }
+            if (cfg.http) {
+                std::lock_guard<std::mutex> lock(serverStatsMutex);
+                std::cout << "  probes " << serverStats.probes << ", failed " << serverStats.failures
+                    << ", reused " << serverStats.reusedConnections << "\n"
+                    << "  connect    " << serverStats.connect << "\n"
+                    << "  first byte " << serverStats.firstByte << "\n"
+                    << "  complete   " << serverStats.complete << "\n";
+            }
+        }
+        else if (input == "stats") {
+            if (perfEnabled()) {
+                std::cout << "[PERF] monitor checks: " << monitorPerf.snapshot() << "\n"
+                    << "[PERF] scan engine: " << scanPerf.snapshot() << "\n"
+                    << "[PERF] watch engine: " << watchPerf.snapshot() << "\n"
+                    << "[PERF] test engine: " << testPerf.snapshot() << "\n"
+                    << "[PERF] control engine: " << controlPerf.snapshot() << "\n";
+                if (targetScheduler) {
+                    std::vector<PerfTotals> workers = targetScheduler->perfTotals();
+                    for (size_t w = 0; w < workers.size(); w++)
+                        std::cout << "[PERF] scheduler worker " << w << " engine: " << workers[w] << "\n";
+                }
+            }
+            else {
+                std::cout << "[!] Performance counters are off (start with --perf).\n";
+            }
+            if (plainTraced) {
+                std::lock_guard<std::mutex> lock(serverStatsMutex);
+                uint64_t n = 0;
+                std::cout << "[PROBE] " << describeProbeVariant(cfg.probe) << " checks:";
+                for (int st = 0; st < 4; st++) {
+                    std::cout << " " << probeStatusName((ProbeStatus)st) << " " << plainCounts.byStatus[st];
+                    n += plainCounts.byStatus[st];
+                }
+                std::cout << ", avg " << (n ? plainCounts.rttSumMs / n : 0.0) << " ms\n";
+            }
+#ifdef PROBE_TRACE
+            tracePrintStats(std::cout);
+#else
+            std::cout << "[!] Per-phase timings need a build with PROBE_TRACE.\n";
+#endif
+        }
+        else if (input.rfind("trace ", 0) == 0) {
+#ifdef PROBE_TRACE
+            std::string path = input.substr(6);
+            if (traceExportChrome(path)) std::cout << "[TRACE] Written to " << path << "\n";
+            else std::cout << "[!] Could not write " << path << "\n";
+#else
+            std::cout << "[!] Probe tracing needs a build with PROBE_TRACE.\n";
+#endif
+        }
+        else if (input == "cache" || input == "cache clear") {
+            if (!testCache) {
+                std::cout << "[!] The test cache is off (start with --test-cache [ttl ms]).\n";
+                continue;
+            }
+            if (input == "cache clear") testCache->clear();
+            ProbeCacheStats cs = testCache->stats();
+            std::cout << "[Cache] ttl " << testCache->options().ttlMs << " ms: " << cs.entries << " results, "
+                << cs.inFlight << " in flight; " << cs.probes << " probes, " << cs.hits << " hits, "
+                << cs.joined << " joined\n";
+        }
+        else if (input == "jobs") {
+            std::vector<std::string> lines = probeJobs.describe();
+            if (lines.empty()) std::cout << "[Jobs] none\n";
+            for (const std::string& l : lines) std::cout << "[Jobs] " << l << "\n";
+            for (const std::string& l : probeJobs.describeQueues()) std::cout << "[Queues] " << l << "\n";
+        }
+        else if (input.rfind("cancel ", 0) == 0) {
+            uint64_t id = std::strtoull(input.c_str() + 7, nullptr, 10);
+            std::cout << (probeJobs.cancel(id) ? "[Jobs] cancelled " : "[!] No job ") << id << "\n";
+        }
+        else if (input == "uptime" || input.rfind("uptime ", 0) == 0) {
+            std::istringstream args(input.substr(6));
+            std::string who, window = "24h";
+            int64_t windowMs;
+            args >> who >> window;
+            if (parseDurationMs(who, windowMs)) {
+                window = who;   // "uptime 24h"
+                who.clear();
+            }
+            if (who.empty() || who == ip) who = serverTarget;
+            else if (who.find(':') == std::string::npos) {
+                for (const std::string& t : targetHistory.targets())
+                    if (t.compare(0, who.size() + 1, who + ":") == 0) { who = t; break; }
+            }
+            HistorySummary sum;
+            if (!parseDurationMs(window, windowMs)) {
+                std::cout << "[!] Usage: uptime [ip[:port]] [<n>m|h|d]\n";
+            }
+            else if (!targetHistory.summarize(who, unixMsNow(), windowMs, sum) || sum.checks == 0) {
+                std::cout << "[Uptime] " << who << ": no checks in the last " << window << "\n";
+            }
+            else {
+                std::cout << "[Uptime] " << who << " last " << window << ": " << sum.uptime() * 100.0 << "% up ("
+                    << sum.up << "/" << sum.checks << " checks), rtt min " << sum.minRttMs << " avg " << sum.avgRttMs()
+                    << " max " << sum.maxRttMs << " ms [" << sum.buckets << (sum.bucketMs == 60000 ? " minute" : " hour")
+                    << " buckets]\n";
+                std::string strip;
+                for (const HistorySample& s : targetHistory.recent(who, 60)) strip += s.up ? '+' : 'x';
+                std::cout << "  recent " << strip << " (" << targetHistory.targets().size() << " targets, "
+                    << targetHistory.memoryBytes() / 1024 << " KB of history)\n";
+            }
+        }
+        else if (input.rfind("scan ", 0) == 0) {
+            std::string range = input.substr(5);
+            int lo = std::atoi(range.c_str());
+            size_t dash = range.find('-');
+            int hi = (dash == std::string::npos) ? lo : std::atoi(range.c_str() + dash + 1);
+            ProbeTarget check;
+            if (!makeProbeTarget(ip, lo, check) || !makeProbeTarget(ip, hi, check) || hi < lo) {
+                std::cout << "[!] Usage: scan <lo>-<hi>\n";
+                continue;
+            }
+            std::string tag = "[Scan " + std::to_string(lo) + "-" + std::to_string(hi) + "]";
+            uint64_t id = probeJobs.submit("scan " + range, [=](const std::atomic<bool>& cancelled) {
+                std::vector<ProbeTarget> targets(hi - lo + 1);
+                for (int p = lo; p <= hi; p++) makeProbeTarget(ip, p, targets[p - lo]);
+                ProbeEngine engine(ProbeBackend::Epoll, 256, replProbeTimeoutMs);
+                engine.setCancelFlag(&cancelled);
+                engine.setPerfSink(&scanPerf);
 
-        if (input == "status") {
-            std::cout << "[Server status] " << (serverConnection ? "Online" : "Offline") << "\n";
+                size_t open = 0, done = 0;
+                auto start = std::chrono::steady_clock::now();
+                engine.run(targets, [&](const ProbeResult& r) {
+                    done++;
+                    if (r.status != ProbeStatus::Open) return;
+                    open++;
+                    printAsync(tag + " port " + std::to_string(lo + (int)r.index) + " open (" + std::to_string(r.rttMs) + " ms)");
+                });
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                printAsync(tag + (cancelled.load() ? " cancelled: " : " done: ") + std::to_string(open) + " open of "
+                    + std::to_string(done) + " tested in " + std::to_string((int)ms) + " ms");
+            }, ProbeClass::Bulk);
+            std::cout << tag << " started as job " << id << "\n";
         }
-        else if (input.rfind("test ", 0) == 0) {
-            try {
-                int port = std::stoi(input.substr(5));
-                bool ok = testPortFast(ip, port);
-                std::cout << "[Port " << port << "] " << (ok ? "Open" : "Closed") << "\n";
+        else if (input.rfind("watch ", 0) == 0) {
+            int port = std::atoi(input.c_str() + 6);
+            size_t sp = input.find(' ', 6);
+            int everyMs = (sp == std::string::npos) ? 1000 : std::atoi(input.c_str() + sp + 1);
+            ProbeTarget target;
+            if (!makeProbeTarget(ip, port, target) || everyMs <= 0) {
+                std::cout << "[!] Usage: watch <port> [ms]\n";
+                continue;
             }
-            catch (...) {
+            auto last = std::make_shared<int>(-1);  // Only ever touched by this job's runs
+            std::string tag = "[Watch " + std::to_string(port) + "]";
+            uint64_t id = probeJobs.every("watch " + std::to_string(port), everyMs, [=](const std::atomic<bool>&) {
+                ProbeEngine engine(ProbeBackend::Epoll, 1, replProbeTimeoutMs);
+                engine.setPerfSink(&watchPerf);
+                ProbeResult res;
+                engine.run({ target }, [&](const ProbeResult& r) { res = r; });
+                int open = (res.status == ProbeStatus::Open) ? 1 : 0;
+                targetHistory.record(ip + ":" + std::to_string(port), unixMsNow(), open != 0, res.rttMs);
+                if (open == *last) return;
+                printAsync(tag + " " + (*last < 0 ? "" : (*last ? "Open -> " : "Closed -> ")) + (open ? "Open" : "Closed"));
+                *last = open;
+            });
+            std::cout << tag << " every " << everyMs << " ms as job " << id << "\n";
+        }
+        else if (input.rfind("test ", 0) == 0) {
+            int port = std::atoi(input.c_str() + 5);
+            bool wantBanner = input.size() > 7 && input.compare(input.size() - 7, 7, " banner") == 0;
+            bool wantTls = input.size() > 4 && input.compare(input.size() - 4, 4, " tls") == 0;
+            ProbeTarget target;
+            if (!makeProbeTarget(ip, port, target)) {
                 std::cout << "[!] Invalid port number.\n";
+                continue;
+            }
+            std::string tag = "[Port " + std::to_string(port) + "] ";
+
+            if (wantTls) {
+#ifdef PROBE_WITH_OPENSSL
+                probeJobs.submit("test " + std::to_string(port) + " tls", [&, port, tag](const std::atomic<bool>&) {
+                    std::lock_guard<std::mutex> lock(tlsProbesMutex);
+                    auto& probe = tlsProbes[port];
+                    if (!probe) probe.reset(new TlsHandshakeProbe(ip, port));
+                    TlsProbeResult t = probe->probe();
+                    std::ostringstream out;
+                    out << tag;
+                    if (!t.ok) {
+                        out << "TLS failed: " << t.error;
+                    }
+                    else {
+                        out << t.protocol << " " << t.cipher << (t.resumed ? " (resumed)" : "")
+                            << " | connect " << t.connectMs << " ms | server hello " << t.serverHelloMs
+                            << " ms | handshake " << t.handshakeMs << " ms";
+                        if (t.hasCert) out << " | cert expires in " << (int)t.certDaysLeft << " days";
+                    }
+                    printAsync(out.str());
+                });
+#else
+                std::cout << "[!] TLS probing needs a build with PROBE_WITH_OPENSSL.\n";
+#endif
+            }
+            else if (!wantBanner) {
+                probeJobs.submit("test " + std::to_string(port), [=](const std::atomic<bool>&) {
+                    auto probe = [&]() {
+                        ProbeEngine engine(ProbeBackend::Epoll, 1, replProbeTimeoutMs);
+                        engine.setPerfSink(&testPerf);
+                        ProbeCacheValue v;
+                        engine.run({ target }, [&](const ProbeResult& r) {
+                            v.status = r.status;
+                            v.rttMs = r.rttMs;
+                        });
+                        return v;
+                    };
+                    if (!testCache) {
+                        printAsync(tag + (probe().status == ProbeStatus::Open ? "Open" : "Closed"));
+                        return;
+                    }
+                    testCache->get(ProbeCacheKey{ target.addr, target.port, ProbeCacheType::Connect, replProbeTimeoutMs }, probe,
+                        [tag](const ProbeCacheAnswer& a) {
+                            if (a.value.cancelled) printAsync(tag + "Cancelled (the test it joined was stopped)");
+                            else printAsync(tag + (a.value.status == ProbeStatus::Open ? "Open" : "Closed") + describeCacheAnswer(a));
+                        });
+                });
+            }
+            else {
+                probeJobs.submit("test " + std::to_string(port) + " banner", [=](const std::atomic<bool>&) {
+                    auto probe = [&]() {
+                        BannerResult b = grabBanner(ip, port, replProbeTimeoutMs);
+                        ProbeCacheValue v;
+                        v.status = b.connected ? ProbeStatus::Open : ProbeStatus::Closed;
+                        if (b.connected) {
+                            v.detail = " - " + (b.service.empty() ? std::string(b.bytes ? "unknown" : "no banner") : b.service);
+                            if (!b.banner.empty()) v.detail += " \"" + b.banner + "\"";
+                            if (b.nudged) v.detail += " (after nudge)";
+                        }
+                        return v;
+                    };
+                    auto line = [tag](const ProbeCacheValue& v) {
+                        return tag + (v.status == ProbeStatus::Open ? "Open" : "Closed") + v.detail;
+                    };
+                    if (!testCache) {
+                        printAsync(line(probe()));
+                        return;
+                    }
+                    testCache->get(ProbeCacheKey{ target.addr, target.port, ProbeCacheType::Banner, replProbeTimeoutMs }, probe,
+                        [line](const ProbeCacheAnswer& a) { printAsync(line(a.value) + describeCacheAnswer(a)); });
+                });
             }
         }
         else {
@@ -205,6 +1255,19 @@ int main() {
         }
     }
 
-    monitorThread.detach(); // Clean up on exit (or replace with join or stop flag)
+    // Producers stop before what they publish to: the monitor and the scheduler's stages write
+    // to the board, the log, the control socket and the histories
+    stopMonitor();
+    if (monitorThread.joinable()) monitorThread.join();     // At most one check (probe timeout) away
+    statusBoardSlot.store(-1);  // Stop publishing before the board is unmapped at exit
+    targetsWatcher.stop();
+    if (targetScheduler) targetScheduler->stop();
+#ifdef __linux__
+    if (controlServer) controlServer->stop();
+#endif
+    probeJobs.stop();
+    if (!snapshotPath.empty() && !saveSnapshot(snapshotPath))
+        std::cerr << "[!] Could not write snapshot " << snapshotPath << ".\n";
+    resultLog.close();          // Pending block + index footer; later checks are dropped
     return 0;
 }
@@ -0,0 +1,166 @@
+/*
+ * Probe Performance Counters
+ * Author: Alushi
+ * Description:
+ *   - See perf_counters.h.
+ */
+
+#include "perf_counters.h"
+
+#include <atomic>
+#include <chrono>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::atomic<bool> enabled{ false };
+
+double wallNowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef __linux__
+// One set of counters per probing thread, opened on first use and kept for the thread's life
+struct ThreadCounters {
+    int fd[kPerfCounters];
+
+    ThreadCounters() {
+        static const struct { uint32_t type; uint64_t config; } kEvents[kPerfCounters] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+        };
+        for (int i = 0; i < kPerfCounters; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = kEvents[i].type;
+            attr.config = kEvents[i].config;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.exclude_hv = 1;
+            // Context switches happen in the kernel; try counting it first, then user-only
+            // for perf_event_paranoid >= 2
+            fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+            if (fd[i] < 0) {
+                attr.exclude_kernel = 1;
+                fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+            }
+        }
+    }
+
+    ~ThreadCounters() {
+        for (int f : fd) if (f >= 0) close(f);
+    }
+
+    bool read3(int i, double out[3]) const {
+        uint64_t v[3];
+        if (fd[i] < 0 || ::read(fd[i], v, sizeof(v)) != (ssize_t)sizeof(v)) return false;
+        for (int k = 0; k < 3; k++) out[k] = (double)v[k];
+        return true;
+    }
+};
+
+ThreadCounters& threadCounters() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+#endif
+
+} // namespace
+
+const char* perfCounterName(PerfCounter counter) {
+    switch (counter) {
+    case PerfCounter::Cycles: return "cycles";
+    case PerfCounter::Instructions: return "instructions";
+    case PerfCounter::CacheMisses: return "cache_misses";
+    case PerfCounter::ContextSwitches: return "context_switches";
+    case PerfCounter::Count: break;
+    }
+    return "?";
+}
+
+double PerfTotals::ipc() const {
+    int cy = (int)PerfCounter::Cycles, in = (int)PerfCounter::Instructions;
+    if (!available[cy] || !available[in] || counts[cy] <= 0.0) return 0.0;
+    return counts[in] / counts[cy];
+}
+
+std::ostream& operator<<(std::ostream& out, const PerfTotals& t) {
+    out << t.probes << " probes, " << t.probesPerSec() << " probes/s | per 1k probes:";
+    for (int i = 0; i < kPerfCounters; i++) {
+        out << " " << perfCounterName((PerfCounter)i) << " ";
+        if (t.available[i]) out << t.per1kProbes((PerfCounter)i);
+        else out << "n/a";
+    }
+    if (t.ipc() > 0.0) out << " | IPC " << t.ipc();
+    return out;
+}
+
+void perfSetEnabled(bool on) {
+    enabled.store(on);
+}
+
+bool perfEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void PerfAccumulator::add(const PerfTotals& delta) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    totals_.probes += delta.probes;
+    totals_.wallMs += delta.wallMs;
+    for (int i = 0; i < kPerfCounters; i++) {
+        totals_.counts[i] += delta.counts[i];
+        totals_.available[i] = totals_.available[i] || delta.available[i];
+    }
+}
+
+PerfTotals PerfAccumulator::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totals_;
+}
+
+void PerfAccumulator::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    totals_ = PerfTotals();
+}
+
+PerfScope::PerfScope(PerfAccumulator* sink, uint64_t probes)
+    : sink_(perfEnabled() ? sink : nullptr), probes_(probes) {
+    if (!sink_) return;
+#ifdef __linux__
+    ThreadCounters& tc = threadCounters();
+    for (int i = 0; i < kPerfCounters; i++)
+        if (!tc.read3(i, start_[i])) start_[i][0] = -1.0;
+#endif
+    startMs_ = wallNowMs();
+}
+
+void PerfScope::stop() {
+    if (!sink_) return;
+    PerfTotals delta;
+    delta.probes = probes_;
+    delta.wallMs = wallNowMs() - startMs_;
+#ifdef __linux__
+    ThreadCounters& tc = threadCounters();
+    for (int i = 0; i < kPerfCounters; i++) {
+        double end[3];
+        if (start_[i][0] < 0.0 || !tc.read3(i, end)) continue;
+        double enabledNs = end[1] - start_[i][1];
+        double runningNs = end[2] - start_[i][2];
+        double value = end[0] - start_[i][0];
+        // Scale up when the PMU was multiplexed between more events than it has registers
+        if (runningNs > 0.0 && runningNs < enabledNs) value *= enabledNs / runningNs;
+        delta.counts[i] = value;
+        delta.available[i] = true;
+    }
+#endif
+    sink_->add(delta);
+    sink_ = nullptr;
+}
@@ -0,0 +1,71 @@
+/*
+ * Probe Performance Counters
+ * Author: Alushi
+ * Description:
+ *   - Cycles, instructions, cache misses and context switches of the probing threads,
+ *     read with perf_event_open (Linux) around the engine's run loop and the monitor's checks.
+ *   - Reported per 1k probes together with IPC and throughput, so hot-loop regressions
+ *     show up as counter changes rather than wall-clock noise.
+ *   - Off unless perfSetEnabled(true). Counters the kernel refuses (no PMU in a VM,
+ *     perf_event_paranoid) are reported as unavailable; the rest still work.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+enum class PerfCounter { Cycles, Instructions, CacheMisses, ContextSwitches, Count };
+
+const int kPerfCounters = (int)PerfCounter::Count;
+
+const char* perfCounterName(PerfCounter counter);
+
+struct PerfTotals {
+    uint64_t probes = 0;
+    double wallMs = 0.0;                    // Time spent inside measured scopes
+    double counts[kPerfCounters] = {};      // Scaled for multiplexing
+    bool available[kPerfCounters] = {};
+
+    double per1kProbes(PerfCounter c) const { return probes ? counts[(int)c] * 1000.0 / probes : 0.0; }
+    double probesPerSec() const { return wallMs > 0.0 ? probes * 1000.0 / wallMs : 0.0; }
+    double ipc() const;                     // 0 when cycles or instructions are unavailable
+};
+
+std::ostream& operator<<(std::ostream& out, const PerfTotals& t);
+
+void perfSetEnabled(bool on);
+bool perfEnabled();
+
+// Thread-safe sink the scopes add into; read by the REPL / benchmark
+class PerfAccumulator {
+public:
+    void add(const PerfTotals& delta);
+    PerfTotals snapshot() const;
+    void reset();
+
+private:
+    mutable std::mutex mutex_;
+    PerfTotals totals_;
+};
+
+// Counts the calling thread's events from construction to stop() (or destruction) and adds
+// them with 'probes' to 'sink'. Does nothing when sink is null or counters are disabled.
+class PerfScope {
+public:
+    PerfScope(PerfAccumulator* sink, uint64_t probes);
+    ~PerfScope() { stop(); }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+    void stop();
+    void setProbes(uint64_t probes) { probes_ = probes; }
+
+private:
+    PerfAccumulator* sink_;
+    uint64_t probes_;
+    double startMs_ = 0.0;
+    double start_[kPerfCounters][3] = {};   // value, time enabled, time running
+};
@@ -0,0 +1,156 @@
+/*
+ * Persistent Connection Liveness Link (Linux)
+ * Author: Alushi
+ * Description:
+ *   - See persistent_link.h. Compiled only on Linux; other platforms use periodic checks.
+ */
+
+#include "persistent_link.h"
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <chrono>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+PersistentLink::PersistentLink(const std::string& ip, int port, PersistentLinkOptions opts)
+    : ip_(ip), port_(port), opts_(opts) {
+}
+
+PersistentLink::~PersistentLink() {
+    close();
+}
+
+bool PersistentLink::open(int timeoutMs) {
+    close();
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+
+    // Tune liveness before connecting so the settings cover the whole connection lifetime
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &opts_.keepAliveIdleSec, sizeof(int));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &opts_.keepAliveIntervalSec, sizeof(int));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &opts_.keepAliveCount, sizeof(int));
+    unsigned int userTimeout = static_cast<unsigned int>(opts_.userTimeoutMs);
+    setsockopt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &userTimeout, sizeof(userTimeout));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port_);
+    inet_pton(AF_INET, ip_.c_str(), &addr.sin_addr);
+
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        ::close(fd);
+        return false;
+    }
+
+    pollfd pfd{ fd, POLLOUT, 0 };
+    int so_error = -1;
+    if (poll(&pfd, 1, timeoutMs) > 0) {
+        socklen_t len = sizeof(so_error);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+    }
+    if (so_error != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) {
+        ::close(fd);
+        return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP;
+    ev.data.fd = fd;
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        // An unwatched link would never report its death
+        ::close(ep);
+        ::close(fd);
+        return false;
+    }
+
+    sockfd_ = fd;
+    epfd_ = ep;
+    readArmed_ = true;
+    return true;
+}
+
+void PersistentLink::close() {
+    if (epfd_ >= 0) ::close(epfd_);
+    if (sockfd_ >= 0) ::close(sockfd_);
+    epfd_ = -1;
+    sockfd_ = -1;
+}
+
+// Watches for readable data (armed) or only for the link's death (disarmed)
+bool PersistentLink::armRead(bool armed) {
+    epoll_event ev{};
+    ev.events = EPOLLRDHUP | EPOLLERR | EPOLLHUP | (armed ? (uint32_t)EPOLLIN : 0u);
+    ev.data.fd = sockfd_;
+    if (epoll_ctl(epfd_, EPOLL_CTL_MOD, sockfd_, &ev) < 0) return false;
+    readArmed_ = armed;
+    return true;
+}
+
+LinkEvent PersistentLink::wait(int timeoutMs) {
+    if (!isOpen()) return LinkEvent::Dropped;
+    if (!readArmed_ && !armRead(true)) return LinkEvent::Dropped;
+
+    // Only a drop ends the wait early; data the peer pushes is drained and the wait goes on
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true) {
+        int leftMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (leftMs < 0) leftMs = 0;
+
+        epoll_event ev{};
+        int n = epoll_wait(epfd_, &ev, 1, leftMs);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return LinkEvent::Dropped;
+        }
+        if (n == 0) return LinkEvent::Idle;
+
+        if (ev.events & (EPOLLRDHUP | EPOLLERR | EPOLLHUP)) return LinkEvent::Dropped;
+
+        // Some services greet or push data; drain it so level-triggered epoll doesn't spin.
+        // A zero-byte read is an orderly shutdown that raced past EPOLLRDHUP.
+        char sink[512];
+        while (true) {
+            ssize_t r = recv(sockfd_, sink, sizeof(sink), MSG_DONTWAIT);
+            if (r > 0) continue;
+            if (r == 0) return LinkEvent::Dropped;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return LinkEvent::Dropped;
+            break;
+        }
+
+        // A peer that streams would wake us per segment; stop listening for data until the
+        // next wait. Closes and resets are still reported.
+        if (!armRead(false)) return LinkEvent::Dropped;
+    }
+}
+
+bool PersistentLink::sampleRtt(double& srttMs, double& rttVarMs) const {
+    if (!isOpen()) return false;
+
+    tcp_info info{};
+    socklen_t len = sizeof(info);
+    if (getsockopt(sockfd_, IPPROTO_TCP, TCP_INFO, &info, &len) < 0) return false;
+
+    srttMs = info.tcpi_rtt / 1000.0;       // Kernel reports microseconds
+    rttVarMs = info.tcpi_rttvar / 1000.0;
+    return true;
+}
+
+#endif // __linux__
@@ -0,0 +1,56 @@
+/*
+ * Persistent Connection Liveness Link (Linux)
+ * Author: Alushi
+ * Description:
+ *   - Keeps one long-lived TCP connection to a monitored service.
+ *   - Peer death is reported by epoll (EPOLLRDHUP / EPOLLERR / EPOLLHUP) as soon as the kernel knows.
+ *   - Silent deaths are bounded by tuned TCP keepalive and TCP_USER_TIMEOUT.
+ *   - RTT is read from TCP_INFO, so sampling costs no extra packets.
+ */
+
+#pragma once
+
+#include <string>
+
+struct PersistentLinkOptions {
+    int keepAliveIdleSec = 1;       // Idle time before the first keepalive probe
+    int keepAliveIntervalSec = 1;   // Time between unanswered keepalive probes
+    int keepAliveCount = 3;         // Unanswered probes before the kernel drops the link
+    int userTimeoutMs = 3000;       // Max time transmitted data may stay unacknowledged
+};
+
+enum class LinkEvent {
+    Idle,       // Nothing happened within the wait timeout; link still up
+    Dropped,    // Peer closed, reset, or the kernel gave up on it
+};
+
+class PersistentLink {
+public:
+    PersistentLink(const std::string& ip, int port, PersistentLinkOptions opts = {});
+    ~PersistentLink();
+
+    PersistentLink(const PersistentLink&) = delete;
+    PersistentLink& operator=(const PersistentLink&) = delete;
+
+    // Connects with a deadline and arms epoll; returns false if the target refused/timed out
+    bool open(int timeoutMs);
+    void close();
+    bool isOpen() const { return sockfd_ >= 0; }
+
+    // Sleeps for timeoutMs, returning early only if the connection dies. Data the peer sends
+    // is read and discarded, at most once per wait.
+    LinkEvent wait(int timeoutMs);
+
+    // Smoothed RTT and RTT variance as tracked by the kernel for this connection
+    bool sampleRtt(double& srttMs, double& rttVarMs) const;
+
+private:
+    bool armRead(bool armed);
+
+    std::string ip_;
+    int port_;
+    PersistentLinkOptions opts_;
+    int sockfd_ = -1;
+    int epfd_ = -1;
+    bool readArmed_ = false;    // EPOLLIN in the interest set
+};
@@ -0,0 +1,124 @@
+/*
+ * Phi-Accrual Failure Detector
+ * Author: Alushi
+ * Description:
+ *   - Learns the inter-arrival distribution of successful checks per target.
+ *   - Reports a continuous suspicion level (phi) instead of a fixed strike count.
+ *   - phi = -log10(P(next success arrives later than "now")); phi 8 ~ 1 in 10^8 false alarm.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Monitor defaults, shared by the app's MonitorConfig and probe_bench
+const int kDefaultFailureThreshold = 3;        // Strike mode: consecutive failures before Offline
+const double kDefaultPhiThreshold = 8.0;
+const double kDefaultPhiMinStdDevMs = 50.0;
+const size_t kDefaultPhiWindow = 100;
+
+class PhiAccrualDetector {
+public:
+    // windowSize            - how many recent intervals form the distribution
+    // minStdDevMs           - floor on the deviation so very stable targets don't trip on jitter
+    // acceptablePauseMs     - extra slack added to the mean (GC pauses, WAN hiccups)
+    // firstIntervalMs       - expected interval used before any real samples exist
+    PhiAccrualDetector(size_t windowSize = kDefaultPhiWindow, double minStdDevMs = kDefaultPhiMinStdDevMs,
+        double acceptablePauseMs = 0.0, double firstIntervalMs = 1000.0)
+        : intervals_(std::max<size_t>(windowSize, 2)),
+        minStdDevMs_(minStdDevMs),
+        acceptablePauseMs_(acceptablePauseMs),
+        firstIntervalMs_(firstIntervalMs) {
+    }
+
+    // Record a successful check observed at nowMs (monotonic clock)
+    void heartbeat(double nowMs) {
+        if (!hasLast_) {
+            // Seed with two samples around the expected interval (mean = first, std = first/4)
+            double dev = firstIntervalMs_ / 4.0;
+            addInterval(firstIntervalMs_ - dev);
+            addInterval(firstIntervalMs_ + dev);
+        }
+        else {
+            addInterval(nowMs - lastMs_);
+        }
+        lastMs_ = nowMs;
+        hasLast_ = true;
+    }
+
+    // Current suspicion level; 0 until the first success has been seen
+    double phi(double nowMs) const {
+        if (!hasLast_ || count_ == 0) return 0.0;
+
+        double mean = sum_ / count_;
+        double variance = std::max(0.0, sumSq_ / count_ - mean * mean);
+        double stdDev = std::max(std::sqrt(variance), minStdDevMs_);
+
+        double elapsed = nowMs - lastMs_;
+        double y = (elapsed - (mean + acceptablePauseMs_)) / stdDev;
+
+        // Logistic approximation of the normal CDF (error < 0.02%), evaluated in the
+        // numerically stable direction so large y doesn't collapse to log10(0)
+        double e = std::exp(-y * (1.5976 + 0.070566 * y * y));
+        if (elapsed > mean + acceptablePauseMs_)
+            return -std::log10(e / (1.0 + e));
+        return -std::log10(1.0 - 1.0 / (1.0 + e));
+    }
+
+    bool isAvailable(double nowMs, double threshold) const {
+        return phi(nowMs) < threshold;
+    }
+
+    size_t samples() const { return count_; }
+
+    // Recent intervals, oldest first; with lastHeartbeatMs() enough to rebuild the detector
+    std::vector<double> intervals() const {
+        std::vector<double> out;
+        for (size_t i = 0; i < count_; i++)
+            out.push_back(intervals_[(head_ + intervals_.size() - count_ + i) % intervals_.size()]);
+        return out;
+    }
+
+    bool hasHeartbeat() const { return hasLast_; }
+    double lastHeartbeatMs() const { return lastMs_; }
+
+    // Warm start from a snapshot; lastMs is the last success on this detector's clock
+    void restore(const std::vector<double>& intervals, double lastMs) {
+        head_ = count_ = 0;
+        sum_ = sumSq_ = 0.0;
+        for (double ms : intervals) addInterval(ms);
+        lastMs_ = lastMs;
+        hasLast_ = count_ > 0;
+    }
+
+private:
+    void addInterval(double ms) {
+        if (count_ == intervals_.size()) {
+            double old = intervals_[head_];
+            sum_ -= old;
+            sumSq_ -= old * old;
+        }
+        else {
+            count_++;
+        }
+        intervals_[head_] = ms;
+        head_ = (head_ + 1) % intervals_.size();
+        sum_ += ms;
+        sumSq_ += ms * ms;
+    }
+
+    std::vector<double> intervals_;   // Fixed ring of recent inter-success intervals
+    size_t head_ = 0;
+    size_t count_ = 0;
+    double sum_ = 0.0;
+    double sumSq_ = 0.0;
+
+    double minStdDevMs_;
+    double acceptablePauseMs_;
+    double firstIntervalMs_;
+
+    double lastMs_ = 0.0;
+    bool hasLast_ = false;
+};
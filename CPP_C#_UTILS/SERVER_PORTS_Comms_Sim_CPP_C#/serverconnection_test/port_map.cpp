@@ -0,0 +1,399 @@
+/*
+ * Open-Port Maps
+ * Author: Alushi
+ * Description:
+ *   - See port_map.h.
+ */
+
+#include "port_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "state_snapshot.h"
+
+namespace {
+
+const uint32_t kBitmapWords = 65536 / 16;       // Pool words of a bitmap container (8 KB)
+const size_t kBitmapU64 = 65536 / 64;
+
+int lowestBit(uint64_t w) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i, w);
+    return (int)i;
+#else
+    return __builtin_ctzll(w);
+#endif
+}
+
+int popCount(uint64_t w) {
+#ifdef _MSC_VER
+    return (int)__popcnt64(w);
+#else
+    return __builtin_popcountll(w);
+#endif
+}
+
+// A loaded container must be what addHost() could have written: arrays strictly ascending,
+// runs ascending, disjoint and inside 0-65535, and the cardinality matching the content
+bool validContainer(const PortContainerRef& r, const uint16_t* d) {
+    uint64_t count = 0;
+    switch ((PortContainerKind)r.kind) {
+    case PortContainerKind::Array:
+        if (r.words != r.cardinality) return false;
+        for (uint32_t k = 1; k < r.words; k++)
+            if (d[k] <= d[k - 1]) return false;
+        return true;
+    case PortContainerKind::Run:
+        if (r.words % 2 != 0) return false;
+        for (uint32_t k = 0; k < r.words; k += 2) {
+            if ((uint32_t)d[k] + d[k + 1] > 65535) return false;
+            if (k && d[k] <= (uint32_t)d[k - 2] + d[k - 1]) return false;
+            count += (uint32_t)d[k + 1] + 1;
+        }
+        return count == r.cardinality;
+    case PortContainerKind::Bitmap:
+        if (r.words != kBitmapWords) return false;
+        for (size_t w = 0; w < kBitmapU64; w++) {
+            uint64_t bits;
+            std::memcpy(&bits, d + w * 4, sizeof(bits));
+            count += popCount(bits);
+        }
+        return count == r.cardinality;
+    }
+    return false;
+}
+
+template <typename T>
+void putPod(std::vector<uint8_t>& out, const T* v, size_t n = 1) {
+    const uint8_t* b = (const uint8_t*)v;
+    out.insert(out.end(), b, b + sizeof(T) * n);
+}
+
+template <typename T>
+bool getPod(const uint8_t*& p, const uint8_t* end, T* v, size_t n = 1) {
+    if ((size_t)(end - p) < sizeof(T) * n) return false;
+    std::memcpy((void*)v, p, sizeof(T) * n);
+    p += sizeof(T) * n;
+    return true;
+}
+
+void setRange(uint64_t* bits, uint32_t lo, uint32_t hi) {     // Inclusive
+    for (uint32_t w = lo >> 6; w <= hi >> 6; w++) {
+        uint32_t from = w == lo >> 6 ? lo & 63 : 0;
+        uint32_t to = w == hi >> 6 ? hi & 63 : 63;
+        uint64_t mask = (to - from == 63) ? ~0ull : (((1ull << (to - from + 1)) - 1) << from);
+        bits[w] |= mask;
+    }
+}
+
+} // namespace
+
+const char* portContainerKindName(PortContainerKind kind) {
+    switch (kind) {
+    case PortContainerKind::Array: return "array";
+    case PortContainerKind::Bitmap: return "bitmap";
+    case PortContainerKind::Run: return "run";
+    }
+    return "?";
+}
+
+// ---------- MAP ----------
+void PortMap::addHost(uint32_t addr, const uint16_t* ports, size_t count) {
+    size_t runs = 0;
+    for (size_t i = 0; i < count; i++)
+        if (i == 0 || ports[i] != ports[i - 1] + 1) runs++;
+
+    // Smallest encoding wins; arrays break ties since they are the cheapest to diff
+    PortContainerRef ref{};
+    ref.cardinality = (uint32_t)count;
+    ref.offset = (uint32_t)pool_.size();
+    if (count <= runs * 2 && count <= kBitmapWords) {
+        ref.kind = (uint8_t)PortContainerKind::Array;
+        ref.words = (uint32_t)count;
+        pool_.insert(pool_.end(), ports, ports + count);
+    }
+    else if (runs * 2 <= kBitmapWords) {
+        ref.kind = (uint8_t)PortContainerKind::Run;
+        ref.words = (uint32_t)(runs * 2);
+        for (size_t i = 0; i < count;) {
+            size_t j = i + 1;
+            while (j < count && ports[j] == ports[j - 1] + 1) j++;
+            pool_.push_back(ports[i]);
+            pool_.push_back((uint16_t)(j - i - 1));
+            i = j;
+        }
+    }
+    else {
+        ref.kind = (uint8_t)PortContainerKind::Bitmap;
+        ref.words = kBitmapWords;
+        uint64_t bits[kBitmapU64] = {};
+        for (size_t i = 0; i < count; i++) bits[ports[i] >> 6] |= 1ull << (ports[i] & 63);
+        pool_.resize(pool_.size() + kBitmapWords);
+        std::memcpy(pool_.data() + ref.offset, bits, sizeof(bits));
+    }
+    addrs_.push_back(addr);
+    refs_.push_back(ref);
+}
+
+uint64_t PortMap::openPorts() const {
+    uint64_t total = 0;
+    for (const PortContainerRef& r : refs_) total += r.cardinality;
+    return total;
+}
+
+long PortMap::find(uint32_t addr) const {
+    auto it = std::lower_bound(addrs_.begin(), addrs_.end(), addr);
+    return (it != addrs_.end() && *it == addr) ? (long)(it - addrs_.begin()) : -1;
+}
+
+bool PortMap::isOpen(uint32_t addr, uint16_t port) const {
+    long i = find(addr);
+    if (i < 0) return false;
+    const PortContainerRef& r = refs_[i];
+    const uint16_t* d = data(i);
+    switch ((PortContainerKind)r.kind) {
+    case PortContainerKind::Array:
+        return std::binary_search(d, d + r.words, port);
+    case PortContainerKind::Run: {
+        size_t lo = 0, hi = r.words / 2;            // First run starting after 'port'
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (d[mid * 2] <= port) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo > 0 && port - d[(lo - 1) * 2] <= d[(lo - 1) * 2 + 1];
+    }
+    case PortContainerKind::Bitmap: {
+        uint64_t w;
+        std::memcpy(&w, d + (port >> 6) * 4, sizeof(w));
+        return (w >> (port & 63)) & 1;
+    }
+    }
+    return false;
+}
+
+std::vector<uint16_t> PortMap::ports(size_t i) const {
+    const PortContainerRef& r = refs_[i];
+    const uint16_t* d = data(i);
+    std::vector<uint16_t> out;
+    out.reserve(r.cardinality);
+    switch ((PortContainerKind)r.kind) {
+    case PortContainerKind::Array:
+        out.assign(d, d + r.words);
+        break;
+    case PortContainerKind::Run:
+        for (uint32_t k = 0; k < r.words; k += 2)
+            for (uint32_t p = d[k]; p <= (uint32_t)d[k] + d[k + 1]; p++) out.push_back((uint16_t)p);
+        break;
+    case PortContainerKind::Bitmap:
+        for (size_t w = 0; w < kBitmapU64; w++) {
+            uint64_t bits;
+            std::memcpy(&bits, d + w * 4, sizeof(bits));
+            while (bits) {
+                out.push_back((uint16_t)(w * 64 + lowestBit(bits)));
+                bits &= bits - 1;
+            }
+        }
+        break;
+    }
+    return out;
+}
+
+size_t PortMap::memoryBytes() const {
+    return addrs_.capacity() * sizeof(uint32_t) + refs_.capacity() * sizeof(PortContainerRef)
+        + pool_.capacity() * sizeof(uint16_t);
+}
+
+size_t PortMap::hostsWith(PortContainerKind kind) const {
+    size_t n = 0;
+    for (const PortContainerRef& r : refs_) n += r.kind == (uint8_t)kind;
+    return n;
+}
+
+void PortMap::save(std::vector<uint8_t>& out) const {
+    uint32_t sizes[2] = { (uint32_t)addrs_.size(), (uint32_t)pool_.size() };
+    putPod(out, sizes, 2);
+    putPod(out, addrs_.data(), addrs_.size());
+    putPod(out, refs_.data(), refs_.size());
+    putPod(out, pool_.data(), pool_.size());
+}
+
+bool PortMap::load(const uint8_t* p, size_t bytes) {
+    const uint8_t* end = p + bytes;
+    uint32_t sizes[2];
+    if (!getPod(p, end, sizes, 2)) return false;
+    if ((size_t)(end - p) != (size_t)sizes[0] * (sizeof(uint32_t) + sizeof(PortContainerRef)) + (size_t)sizes[1] * sizeof(uint16_t))
+        return false;
+
+    std::vector<uint32_t> addrs(sizes[0]);
+    std::vector<PortContainerRef> refs(sizes[0]);
+    std::vector<uint16_t> pool(sizes[1]);
+    getPod(p, end, addrs.data(), addrs.size());
+    getPod(p, end, refs.data(), refs.size());
+    getPod(p, end, pool.data(), pool.size());
+
+    for (size_t i = 0; i < refs.size(); i++) {
+        const PortContainerRef& r = refs[i];
+        if (i && addrs[i] <= addrs[i - 1]) return false;
+        if (r.cardinality > 65536 || (uint64_t)r.offset + r.words > pool.size()) return false;
+        if (!validContainer(r, pool.data() + r.offset)) return false;
+    }
+    addrs_.swap(addrs);
+    refs_.swap(refs);
+    pool_.swap(pool);
+    return true;
+}
+
+bool PortMap::saveFile(const std::string& path, int64_t savedUnixMs) const {
+    std::vector<uint8_t> buf;
+    save(buf);
+    SnapshotWriter w;
+    if (!w.open(path)) return false;
+    w.add(SnapshotSection::PortMap, buf.data(), buf.size());
+    return w.commit(savedUnixMs);
+}
+
+bool PortMap::loadFile(const std::string& path, int64_t* savedUnixMs) {
+    SnapshotReader r;
+    const uint8_t* data;
+    size_t bytes;
+    if (!r.open(path) || !r.section(SnapshotSection::PortMap, data, bytes) || !load(data, bytes)) return false;
+    if (savedUnixMs) *savedUnixMs = r.savedUnixMs();
+    return true;
+}
+
+// ---------- BUILDER ----------
+void PortMapBuilder::scanned(uint32_t addr) {
+    if (scanned_.empty() || scanned_.back() != addr) scanned_.push_back(addr);  // Results mostly arrive host by host
+}
+
+void PortMapBuilder::open(uint32_t addr, uint16_t port) {
+    open_.push_back((uint64_t)addr << 16 | port);
+    scanned(addr);
+}
+
+PortMap PortMapBuilder::build() {
+    std::sort(scanned_.begin(), scanned_.end());
+    scanned_.erase(std::unique(scanned_.begin(), scanned_.end()), scanned_.end());
+    std::sort(open_.begin(), open_.end());
+    open_.erase(std::unique(open_.begin(), open_.end()), open_.end());
+
+    PortMap map;
+    map.addrs_.reserve(scanned_.size());
+    map.refs_.reserve(scanned_.size());
+    std::vector<uint16_t> ports;
+    size_t j = 0;
+    for (uint32_t addr : scanned_) {
+        ports.clear();
+        for (; j < open_.size() && (uint32_t)(open_[j] >> 16) == addr; j++) ports.push_back((uint16_t)open_[j]);
+        map.addHost(addr, ports.data(), ports.size());
+    }
+    scanned_.clear();
+    open_.clear();
+    return map;
+}
+
+// ---------- DIFF ----------
+struct PortMapDiffer {
+    uint64_t a[kBitmapU64];
+    uint64_t b[kBitmapU64];
+
+    static void expand(const PortMap& m, size_t i, uint64_t* bits) {
+        const PortContainerRef& r = m.refs_[i];
+        const uint16_t* d = m.data(i);
+        switch ((PortContainerKind)r.kind) {
+        case PortContainerKind::Array:
+            std::memset(bits, 0, kBitmapU64 * sizeof(uint64_t));
+            for (uint32_t k = 0; k < r.words; k++) bits[d[k] >> 6] |= 1ull << (d[k] & 63);
+            break;
+        case PortContainerKind::Run:
+            std::memset(bits, 0, kBitmapU64 * sizeof(uint64_t));
+            for (uint32_t k = 0; k < r.words; k += 2) setRange(bits, d[k], (uint32_t)d[k] + d[k + 1]);
+            break;
+        case PortContainerKind::Bitmap:
+            std::memcpy(bits, d, kBitmapU64 * sizeof(uint64_t));
+            break;
+        }
+    }
+
+    static bool identical(const PortMap& before, size_t i, const PortMap& after, size_t k) {
+        const PortContainerRef& ra = before.refs_[i];
+        const PortContainerRef& rb = after.refs_[k];
+        return ra.kind == rb.kind && ra.words == rb.words
+            && std::memcmp(before.data(i), after.data(k), ra.words * sizeof(uint16_t)) == 0;
+    }
+
+    // Fills change.opened / change.closed; both containers hold different bytes
+    void compare(const PortMap& before, size_t i, const PortMap& after, size_t k, PortMapChange& change) {
+        const PortContainerRef& ra = before.refs_[i];
+        const PortContainerRef& rb = after.refs_[k];
+        if (ra.kind == (uint8_t)PortContainerKind::Array && rb.kind == (uint8_t)PortContainerKind::Array) {
+            const uint16_t* x = before.data(i);
+            const uint16_t* y = after.data(k);
+            uint32_t p = 0, q = 0;
+            while (p < ra.words || q < rb.words) {
+                if (q == rb.words || (p < ra.words && x[p] < y[q])) change.closed.push_back(x[p++]);
+                else if (p == ra.words || y[q] < x[p]) change.opened.push_back(y[q++]);
+                else { p++; q++; }
+            }
+            return;
+        }
+        expand(before, i, a);
+        expand(after, k, b);
+        for (size_t w = 0; w < kBitmapU64; w++) {
+            uint64_t diff = a[w] ^ b[w];
+            while (diff) {
+                int bit = lowestBit(diff);
+                ((b[w] >> bit) & 1 ? change.opened : change.closed).push_back((uint16_t)(w * 64 + bit));
+                diff &= diff - 1;
+            }
+        }
+    }
+};
+
+PortMapDiffStats diffPortMaps(const PortMap& before, const PortMap& after,
+    const std::function<void(const PortMapChange&)>& onChange) {
+    auto start = std::chrono::steady_clock::now();
+    PortMapDiffStats stats;
+    std::unique_ptr<PortMapDiffer> differ(new PortMapDiffer());   // 16 KB of scratch, keep it off the stack
+    PortMapChange change;
+
+    size_t i = 0, k = 0;
+    while (i < before.hosts() || k < after.hosts()) {
+        if (k == after.hosts() || (i < before.hosts() && before.hostAddr(i) < after.hostAddr(k))) {
+            stats.hostsMissing++;
+            i++;
+            continue;
+        }
+        change.addr = after.hostAddr(k);
+        change.opened.clear();
+        change.closed.clear();
+        if (i == before.hosts() || after.hostAddr(k) < before.hostAddr(i)) {
+            stats.hostsAdded++;
+            change.newHost = true;
+            change.opened = after.ports(k);
+        }
+        else {
+            stats.hostsCompared++;
+            change.newHost = false;
+            if (!PortMapDiffer::identical(before, i, after, k)) differ->compare(before, i, after, k, change);
+            i++;
+        }
+        k++;
+        if (change.opened.empty() && change.closed.empty()) continue;
+        if (!change.newHost) stats.hostsChanged++;
+        stats.opened += change.opened.size();
+        stats.closed += change.closed.size();
+        onChange(change);
+    }
+    stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,117 @@
+/*
+ * Open-Port Maps
+ * Author: Alushi
+ * Description:
+ *   - The set of open ports per scanned host, compressed the way roaring bitmaps compress a
+ *     16-bit chunk: each host gets one container, whichever of three encodings is smallest:
+ *       Array  - sorted port numbers, 2 bytes per open port (the usual case)
+ *       Run    - [start, length - 1] pairs, 4 bytes per range of consecutive open ports
+ *       Bitmap - 65536 bits, a flat 8 KB no matter how many ports are open
+ *     Hosts are kept sorted by address; every container lives in one shared pool.
+ *   - Hosts that answered but had nothing open are kept with an empty container, so "scanned,
+ *     all closed" differs from "not scanned".
+ *   - diffPortMaps() walks two maps side by side and reports the ports opened and closed on
+ *     each host. Hosts with byte-identical containers are skipped with a memcmp, so a diff
+ *     over thousands of mostly unchanged hosts takes well under a millisecond.
+ *   - Saved as a section of a snapshot file (state_snapshot.h): checksummed and replaced
+ *     atomically, so an interrupted run leaves the previous map intact.
+ *   - A diff assumes both scans covered the same ports: a port left out of the newer scan
+ *     reads as closed.
+ *   - Addresses are in host byte order throughout.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class PortContainerKind : uint8_t { Array = 0, Bitmap = 1, Run = 2 };
+
+const char* portContainerKindName(PortContainerKind kind);
+
+struct PortContainerRef {
+    uint8_t kind;                   // PortContainerKind
+    uint8_t reserved[3];
+    uint32_t cardinality;           // Open ports (up to 65536)
+    uint32_t offset;                // Into the pool, in 16-bit words
+    uint32_t words;
+};
+
+static_assert(sizeof(PortContainerRef) == 16, "port map layout changed");
+
+class PortMap {
+public:
+    size_t hosts() const { return addrs_.size(); }
+    uint64_t openPorts() const;
+    uint32_t hostAddr(size_t i) const { return addrs_[i]; }
+    const PortContainerRef& container(size_t i) const { return refs_[i]; }
+
+    // Index of 'addr' in the map, or -1 when it was not scanned
+    long find(uint32_t addr) const;
+    bool isOpen(uint32_t addr, uint16_t port) const;
+    // Open ports of the host at index 'i', ascending
+    std::vector<uint16_t> ports(size_t i) const;
+
+    // Bytes held by the map, and how many hosts use each container kind
+    size_t memoryBytes() const;
+    size_t hostsWith(PortContainerKind kind) const;
+
+    // Appends the map to 'out'; load() replaces this map and fails on anything malformed
+    void save(std::vector<uint8_t>& out) const;
+    bool load(const uint8_t* p, size_t bytes);
+
+    // Whole-file form (a snapshot with one PortMap section)
+    bool saveFile(const std::string& path, int64_t savedUnixMs) const;
+    bool loadFile(const std::string& path, int64_t* savedUnixMs = nullptr);
+
+private:
+    friend class PortMapBuilder;
+    friend struct PortMapDiffer;
+
+    void addHost(uint32_t addr, const uint16_t* ports, size_t count);
+    const uint16_t* data(size_t i) const { return pool_.data() + refs_[i].offset; }
+
+    std::vector<uint32_t> addrs_;           // Ascending
+    std::vector<PortContainerRef> refs_;    // Parallel to addrs_
+    std::vector<uint16_t> pool_;
+};
+
+// Collects scan results in any order, then packs them into a PortMap
+class PortMapBuilder {
+public:
+    // A host that answered on some port (open, or closed by a reset); timeouts alone prove
+    // nothing, so a host that was down is left out rather than recorded as all closed
+    void scanned(uint32_t addr);
+    void open(uint32_t addr, uint16_t port);
+
+    PortMap build();
+
+private:
+    std::vector<uint32_t> scanned_;
+    std::vector<uint64_t> open_;            // addr << 16 | port
+};
+
+// ---------- DIFF ----------
+struct PortMapChange {
+    uint32_t addr;
+    bool newHost;                           // Not in the older map; every open port counts as opened
+    std::vector<uint16_t> opened;
+    std::vector<uint16_t> closed;
+};
+
+struct PortMapDiffStats {
+    size_t hostsCompared = 0;               // Scanned in both maps
+    size_t hostsChanged = 0;
+    size_t hostsAdded = 0;                  // Only in the newer map
+    size_t hostsMissing = 0;                // Only in the older map (not scanned this time; not reported)
+    uint64_t opened = 0;
+    uint64_t closed = 0;
+    double ms = 0.0;
+};
+
+// Calls 'onChange' for every host whose open ports differ, in address order
+PortMapDiffStats diffPortMaps(const PortMap& before, const PortMap& after,
+    const std::function<void(const PortMapChange&)>& onChange);
@@ -0,0 +1,35 @@
+/*
+ * Single-Shot Port Probes
+ * Author: Alushi
+ * Description:
+ *   - See port_probe.h.
+ */
+
+#include "port_probe.h"
+#include "probe_policy.h"
+
+namespace {
+
+// Both entry points are the same policy instance; they only differ in their defaults
+using ConnectProbe = BasicProbe<TcpTransport, ConnectOnly, FixedTimeout, TraceInstrumentation>;
+
+bool connectProbe(const std::string& ip, int port, int timeoutMs) {
+    ProbeTarget target;
+    if (!makeProbeTarget(ip, port, target)) return false;
+    ConnectProbe probe{ FixedTimeout(timeoutMs) };
+    return probe.probe(target).status == ProbeStatus::Open;
+}
+
+} // namespace
+
+// ---------- TCP-BASED SERVER CHECK ----------
+// Attempts to connect to a host on a given port with a short timeout
+bool isHostReachable(const std::string& ip, int port, int timeoutMs) {
+    return connectProbe(ip, port, timeoutMs);
+}
+
+// ---------- PORT TEST ----------
+// Tests a specific port using non-blocking TCP connection
+bool testPortFast(const std::string& ip, int port, int timeoutMs) {
+    return connectProbe(ip, port, timeoutMs);
+}
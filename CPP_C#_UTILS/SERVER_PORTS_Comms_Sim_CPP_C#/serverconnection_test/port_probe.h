@@ -0,0 +1,18 @@
+/*
+ * Single-Shot Port Probes
+ * Author: Alushi
+ * Description:
+ *   - Blocking TCP connect checks used by the monitor and the REPL "test" command.
+ *   - Thin wrappers over the TCP / connect-only / fixed-timeout instance of BasicProbe
+ *     (probe_policy.h); other transports and checks are selected through makeProbeRunner().
+ */
+
+#pragma once
+
+#include <string>
+
+// Attempts to connect to a host on a given port with a short timeout
+bool isHostReachable(const std::string& ip, int port = 80, int timeoutMs = 500);
+
+// Tests a specific port using non-blocking TCP connection
+bool testPortFast(const std::string& ip, int port, int timeoutMs = 200);
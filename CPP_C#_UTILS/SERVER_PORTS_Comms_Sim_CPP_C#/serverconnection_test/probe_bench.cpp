@@ -0,0 +1,693 @@
+/*
+ * Probe Benchmark Suite (Linux)
+ * Author: Alushi
+ * Description:
+ *   - Per-probe CPU cost by backend (sync isHostReachable, select engine, epoll engine).
+ *   - Sustained probes/sec versus in-flight window.
+ *   - p50/p99 outage detection latency of the strike and phi-accrual monitors (the app's
+ *     default settings), their false-positive rate on refusal blips just within what each
+ *     tolerates and their missed-outage rate on blips just past it (fault_server's flap mode,
+ *     driven in-process so the bench knows exactly how many checks each blip covers).
+ *   - Memory per tracked target.
+ *   - Target store (target_store.h) at 10k / 100k / 1M targets: bytes per target (store alone
+ *     and with the scheduler's name index, by RSS) and the time of one due-time / health sweep.
+ *   - Open-port maps (port_map.h) of 1k / 10k / 100k hosts: bytes per host and the time to
+ *     diff two scans that differ on 1% of the hosts.
+ *   - Heap allocations per probe once warmed up (engine backends and the policy probe core),
+ *     counted by replacing the global operator new; anything above zero fails the run (exit 2).
+ *   - Cycles/instructions/cache misses/context switches per 1k probes and IPC per backend
+ *     (perf_event_open; counters the kernel refuses are left out of the JSON).
+ *   - Emits JSON; with --baseline, compares against a stored run and exits 2 on regression.
+ *   - Standalone tool (own main), not part of the serverconnection_test project. Start the
+ *     listener fixture first, then point the bench at its ports:
+ *       g++ -O2 -std=c++17 -pthread probe_bench.cpp probe_engine.cpp port_probe.cpp perf_counters.cpp \
+ *           target_store.cpp target_config.cpp port_map.cpp state_snapshot.cpp probe_policy.cpp \
+ *           -o probe_bench
+ *       ./listener_fixture --ports 20000-20999 --threads 2 --reuseport &
+ *       ./probe_bench --ports 20000-20999 --out bench.json [--baseline baseline.json]
+ *   - Built with -DPROBE_TRACE, adding probe_trace.cpp to the sources above, --trace file.json
+ *     also writes per-phase histograms to stdout and a sampled Chrome trace.
+ *   - io_uring and raw-SYN backends do not exist in the engine; they are listed as unsupported.
+ */
+
+#ifndef __linux__
+#error "probe_bench needs Linux (getrusage, /proc, epoll)"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "perf_counters.h"
+#include "phi_accrual.h"
+#include "port_map.h"
+#include "port_probe.h"
+#include "probe_engine.h"
+#include "probe_policy.h"
+#include "probe_trace.h"
+#include "target_stats.h"
+#include "target_store.h"
+
+// ---------- ALLOCATION COUNTER ----------
+// Every operator new in the process lands here; the allocation bench reads the delta
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"    // free() does match this operator new
+#endif
+std::atomic<uint64_t> heapAllocations{ 0 };
+
+void* operator new(size_t bytes) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t bytes) {
+    return operator new(bytes);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    std::string ip = "127.0.0.1";
+    int portLo = 20000;
+    int portHi = 20999;
+    size_t cpuProbes = 5000;        // Probes per backend for the CPU-cost runs
+    size_t throughputProbes = 20000;
+    std::vector<size_t> windows{ 1, 8, 32, 128, 512 };
+    int detectTrials = 30;
+    int detectIntervalMs = 10;
+    size_t memoryTargets = 100000;
+    std::vector<size_t> storeSizes{ 10000, 100000, 1000000 };
+    std::vector<size_t> portMapHosts{ 1000, 10000, 100000 };
+    std::string outPath;
+    std::string baselinePath;
+    std::string tracePath;
+    double tolerance = 0.10;        // Relative change treated as a regression
+};
+
+// Ordered so the JSON and the comparison table are stable between runs
+std::vector<std::pair<std::string, double>> metrics;
+
+void addMetric(const std::string& name, double value) {
+    metrics.emplace_back(name, value);
+    std::cout << "  " << name << " = " << value << "\n";
+}
+
+bool higherIsBetter(const std::string& name) {
+    return name.rfind("probes_per_sec", 0) == 0 || name.rfind("ipc", 0) == 0;
+}
+
+// Counters the kernel granted during the run, for the JSON header
+bool perfSeen[kPerfCounters] = {};
+
+void addPerfMetrics(const std::string& backend, const PerfTotals& t) {
+    for (int i = 0; i < kPerfCounters; i++) {
+        if (!t.available[i]) continue;
+        perfSeen[i] = true;
+        addMetric(std::string(perfCounterName((PerfCounter)i)) + "_per_1k_probes." + backend, t.per1kProbes((PerfCounter)i));
+    }
+    if (t.ipc() > 0.0) addMetric("ipc." + backend, t.ipc());
+}
+
+double cpuSeconds() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t idx = (size_t)std::ceil(p * v.size()) - 1;
+    return v[std::min(idx, v.size() - 1)];
+}
+
+std::vector<ProbeTarget> makeTargets(const BenchConfig& cfg, size_t count) {
+    std::vector<ProbeTarget> targets(count);
+    int span = cfg.portHi - cfg.portLo + 1;
+    for (size_t i = 0; i < count; i++) makeProbeTarget(cfg.ip, cfg.portLo + (int)(i % span), targets[i]);
+    return targets;
+}
+
+// ---------- CPU COST PER PROBE ----------
+void benchCpuCost(const BenchConfig& cfg) {
+    std::cout << "[BENCH] CPU cost per probe (" << cfg.cpuProbes << " probes each)\n";
+    int span = cfg.portHi - cfg.portLo + 1;
+
+    PerfAccumulator syncPerf;
+    double c0 = cpuSeconds();
+    size_t open = 0;
+    {
+        PerfScope scope(&syncPerf, cfg.cpuProbes);
+        for (size_t i = 0; i < cfg.cpuProbes; i++)
+            open += isHostReachable(cfg.ip, cfg.portLo + (int)(i % span), 500) ? 1 : 0;
+    }
+    addMetric("cpu_us_per_probe.sync", (cpuSeconds() - c0) * 1e6 / cfg.cpuProbes);
+    addPerfMetrics("sync", syncPerf.snapshot());
+    if (open != cfg.cpuProbes) std::cerr << "[!] sync: only " << open << " probes succeeded\n";
+
+    std::vector<ProbeTarget> targets = makeTargets(cfg, cfg.cpuProbes);
+    for (ProbeBackend backend : { ProbeBackend::Select, ProbeBackend::Epoll }) {
+        ProbeEngine engine(backend, 64, 500);
+        PerfAccumulator enginePerf;
+        engine.setPerfSink(&enginePerf);
+        size_t ok = 0;
+        double c1 = cpuSeconds();
+        engine.run(targets, [&](const ProbeResult& r) { ok += r.status == ProbeStatus::Open; });
+        addMetric(std::string("cpu_us_per_probe.") + probeBackendName(backend), (cpuSeconds() - c1) * 1e6 / targets.size());
+        addPerfMetrics(probeBackendName(backend), enginePerf.snapshot());
+        if (ok != targets.size()) std::cerr << "[!] " << probeBackendName(backend) << ": only " << ok << " probes succeeded\n";
+    }
+}
+
+// ---------- THROUGHPUT VS WINDOW ----------
+void benchThroughput(const BenchConfig& cfg) {
+    std::cout << "[BENCH] Sustained probes/sec vs in-flight window (epoll, " << cfg.throughputProbes << " probes)\n";
+    std::vector<ProbeTarget> targets = makeTargets(cfg, cfg.throughputProbes);
+    for (size_t window : cfg.windows) {
+        ProbeEngine engine(ProbeBackend::Epoll, window, 1000);
+        auto start = Clock::now();
+        engine.run(targets, [](const ProbeResult&) {});
+        double secs = std::chrono::duration<double>(Clock::now() - start).count();
+        addMetric("probes_per_sec.window_" + std::to_string(window), targets.size() / secs);
+    }
+}
+
+// ---------- DETECTION LATENCY ----------
+// Listens on 'port' (0 = any free port, written back); -1 if the port cannot be had
+int openPrivateListener(int& port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    // Never accepted: the kernel completes the handshakes on its own
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 4096) < 0) {
+        close(fd);
+        return -1;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+// One monitor check of either kind; true while the monitor calls the target Online
+struct BenchMonitor {
+    BenchMonitor(bool phi, int interval) : phi(phi), detector(kDefaultPhiWindow, kDefaultPhiMinStdDevMs, 0.0, interval) {}
+
+    // Same decision as monitorServer() with its default settings
+    bool check(bool reachable, double nowMs) {
+        failures = reachable ? 0 : failures + 1;
+        if (!phi) return failures < kDefaultFailureThreshold;
+        if (reachable) detector.heartbeat(nowMs);
+        if (detector.samples() == 0) return failures < kDefaultFailureThreshold;
+        return detector.phi(nowMs) < kDefaultPhiThreshold;
+    }
+
+    bool phi;
+    PhiAccrualDetector detector;
+    int failures = 0;
+};
+
+// Runs a monitor loop against a private listener, kills the listener at a seeded random
+// point after warm-up, and returns the kill -> Offline latency in ms
+double detectOnce(const BenchConfig& cfg, bool phi, std::mt19937& rng) {
+    int port = 0;
+    int listener = openPrivateListener(port);
+
+    const int interval = cfg.detectIntervalMs;
+    const int warmup = 20;
+    BenchMonitor monitor(phi, interval);
+
+    auto start = Clock::now();
+    auto nowMs = [&]() { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    auto next = Clock::now();
+    double killedAt = -1.0;
+
+    for (int i = 0; i < 10000; i++) {
+        bool reachable = isHostReachable("127.0.0.1", port, interval);
+        bool online = monitor.check(reachable, nowMs());
+
+        if (killedAt >= 0.0 && !online) {
+            double latency = nowMs() - killedAt;
+            return latency;
+        }
+
+        next += std::chrono::milliseconds(interval);
+        if (i == warmup) {
+            // Kill at a random phase within the interval so results don't alias to the schedule
+            std::uniform_int_distribution<int> phase(0, interval - 1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(phase(rng)));
+            close(listener);
+            killedAt = nowMs();
+        }
+        std::this_thread::sleep_until(next);
+    }
+    return -1.0;
+}
+
+void benchDetection(const BenchConfig& cfg) {
+    std::cout << "[BENCH] Outage detection latency (" << cfg.detectTrials << " trials, "
+        << cfg.detectIntervalMs << " ms interval)\n";
+    for (bool phi : { false, true }) {
+        std::mt19937 rng(42);       // Same kill phases for every run
+        std::vector<double> samples;
+        for (int t = 0; t < cfg.detectTrials; t++) {
+            double ms = detectOnce(cfg, phi, rng);
+            if (ms >= 0.0) samples.push_back(ms);
+        }
+        std::string mode = phi ? "phi" : "strike";
+        addMetric("detect_ms_p50." + mode, percentile(samples, 0.50));
+        addMetric("detect_ms_p99." + mode, percentile(samples, 0.99));
+    }
+}
+
+// ---------- FALSE POSITIVES ----------
+// Consecutive missed checks a monitor with default settings rides out on a steady target:
+// strike mode threshold - 1, phi mode whatever a window of exact intervals tolerates
+int toleratedMisses(bool phi, int interval) {
+    if (!phi) return kDefaultFailureThreshold - 1;
+    PhiAccrualDetector d(kDefaultPhiWindow, kDefaultPhiMinStdDevMs, 0.0, interval);
+    for (size_t i = 0; i <= kDefaultPhiWindow; i++) d.heartbeat((double)i * interval);
+    const double last = d.lastHeartbeatMs();
+    int k = 1;
+    while (k < 10000 && d.phi(last + (double)k * interval) < kDefaultPhiThreshold) k++;
+    return k - 1;
+}
+
+// The fault server's flap mode in-process: the listener goes away (refused) for a seeded random
+// number of checks around the monitor's limit m, i.e. m - 1, m or m + 1 missed checks, then
+// comes back on the same port. Blips of up to m misses are not outages and should not turn the
+// monitor Offline; blips of m + 1 should.
+struct BlipRates {
+    double falsePositive = 0.0;     // Blips of <= m misses the monitor called Offline
+    double missed = 0.0;            // Blips of m + 1 misses it did not
+};
+
+bool blipRates(const BenchConfig& cfg, bool phi, std::mt19937& rng, BlipRates& out) {
+    int port = 0;
+    int listener = openPrivateListener(port);
+    const int interval = cfg.detectIntervalMs;
+    const int limit = toleratedMisses(phi, interval);
+    BenchMonitor monitor(phi, interval);
+    std::uniform_int_distribution<int> upChecks(15, 25);
+    std::uniform_int_distribution<int> length(std::max(1, limit - 1), limit + 1);
+
+    auto start = Clock::now();
+    auto nowMs = [&]() { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    auto next = Clock::now();
+    int blips = 0, shortBlips = 0, shortFlagged = 0, longBlips = 0, longMissed = 0;
+    int misses = 0, left = 0;               // Length of the current blip, failing checks still to come
+    bool flagged = false;
+    int nextBlip = 20 + upChecks(rng);      // After the same warm-up as detectOnce()
+
+    for (int i = 0; blips < cfg.detectTrials || left > 0; i++) {
+        if (listener < 0 && left == 0) {
+            listener = openPrivateListener(port);
+            if (listener < 0) {
+                std::cerr << "[!] blips: port " << port << " was taken during a blip\n";
+                return false;
+            }
+        }
+        bool online = monitor.check(isHostReachable("127.0.0.1", port, interval), nowMs());
+        if (left > 0) {
+            if (!online) flagged = true;
+            if (--left == 0) {
+                if (misses <= limit) {
+                    shortBlips++;
+                    if (flagged) shortFlagged++;
+                }
+                else {
+                    longBlips++;
+                    if (!flagged) longMissed++;
+                }
+            }
+        }
+
+        next += std::chrono::milliseconds(interval);
+        if (i >= nextBlip && left == 0 && blips < cfg.detectTrials) {
+            close(listener);
+            listener = -1;
+            misses = left = length(rng);
+            flagged = false;
+            blips++;
+            nextBlip = i + misses + upChecks(rng);
+        }
+        std::this_thread::sleep_until(next);
+    }
+    close(listener);
+    out.falsePositive = shortBlips ? (double)shortFlagged / shortBlips : 0.0;
+    out.missed = longBlips ? (double)longMissed / longBlips : 0.0;
+    std::cout << "  " << (phi ? "phi" : "strike") << ": limit " << limit << " missed checks, " << shortBlips
+        << " blips within it (" << shortFlagged << " flagged), " << longBlips << " past it (" << longMissed << " not flagged)\n";
+    return true;
+}
+
+void benchFalsePositives(const BenchConfig& cfg) {
+    std::cout << "[BENCH] Blips around the detection limit, default monitor settings (" << cfg.detectTrials
+        << " blips, " << cfg.detectIntervalMs << " ms interval)\n";
+    for (bool phi : { false, true }) {
+        std::mt19937 rng(43);       // Same blip schedule for every run
+        BlipRates rates;
+        if (!blipRates(cfg, phi, rng, rates)) continue;
+        std::string mode = phi ? "phi" : "strike";
+        addMetric("false_positive_rate." + mode, rates.falsePositive);
+        addMetric("missed_outage_rate." + mode, rates.missed);
+    }
+}
+
+// ---------- MEMORY PER TARGET ----------
+struct TrackedTarget {
+    ProbeTarget target;
+    PhiAccrualDetector detector;
+    TargetStats stats;
+};
+
+void benchMemory(const BenchConfig& cfg) {
+    std::cout << "[BENCH] Memory per tracked target (" << cfg.memoryTargets << " targets)\n";
+    size_t before = residentBytes();
+    std::vector<std::unique_ptr<TrackedTarget>> tracked;
+    tracked.reserve(cfg.memoryTargets);
+    for (size_t i = 0; i < cfg.memoryTargets; i++) {
+        tracked.emplace_back(new TrackedTarget());
+        tracked.back()->detector.heartbeat(0.0);    // Touch the ring so its pages are resident
+    }
+    size_t after = residentBytes();
+    addMetric("bytes_per_target", (double)(after - before) / cfg.memoryTargets);
+}
+
+// ---------- TARGET STORE ----------
+// Median of 'runs' timings of fn(), in microseconds
+template <typename Fn>
+double medianUs(int runs, Fn fn) {
+    std::vector<double> samples;
+    for (int r = 0; r < runs; r++) {
+        auto t0 = Clock::now();
+        fn();
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    }
+    return percentile(samples, 0.50);
+}
+
+void benchTargetStore(const BenchConfig& cfg) {
+    std::cout << "[BENCH] Target store sweeps and footprint (" << TargetStore::hotBytesPerTarget() << " hot bytes per target)\n";
+    for (size_t n : cfg.storeSizes) {
+        const std::string tag = std::to_string(n / 1000) + "k";
+        size_t before = residentBytes();
+        TargetStore store;
+        std::unordered_map<std::string, TargetId> byKey;      // As the scheduler indexes them
+        store.reserve(n);
+        byKey.reserve(n);
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<uint64_t> phase(0, 999);
+        for (size_t i = 0; i < n; i++) {
+            TargetConfig t;
+            t.ip = "10." + std::to_string((i >> 16) & 255) + "." + std::to_string((i >> 8) & 255) + "." + std::to_string(i & 255);
+            t.port = (uint16_t)(1 + i % 60000);
+            t.addr = (uint32_t)i;
+            TargetId id = store.add(t);
+            store.setDueTick(id, phase(rng));
+            store.record(id, i % 10 != 0, 1.0f, 0);
+            byKey.emplace(t.key(), id);
+        }
+        size_t after = residentBytes();
+        addMetric("store_bytes_per_target." + tag, (double)store.memoryBytes() / n);
+        addMetric("registry_rss_bytes_per_target." + tag, (double)(after - before) / n);
+
+        std::vector<TargetId> due;
+        due.reserve(n);
+        uint64_t tick = 0;
+        addMetric("sweep_us.due." + tag, medianUs(21, [&]() {
+            due.clear();
+            store.collectDue(tick++ % 1000, due);   // About 0.1% of targets per tick
+        }));
+        size_t online = 0;
+        addMetric("sweep_us.health." + tag, medianUs(21, [&]() { online += store.countHealth(TargetHealth::Online); }));
+        if (online == 0) std::cerr << "[!] store " << tag << ": health sweep found nothing\n";
+    }
+}
+
+// ---------- OPEN-PORT MAPS ----------
+// Mostly a few well-known ports per host; every 100th host exposes a contiguous range and
+// every 1000th nearly everything, so all three container kinds are exercised
+void benchPortMaps(const BenchConfig& cfg) {
+    static const uint16_t common[] = { 22, 25, 53, 80, 110, 143, 443, 445, 993, 3306, 3389, 5432, 8080, 8443 };
+    std::cout << "[BENCH] Open-port maps: size and diff of two scans, 1% of hosts changed\n";
+    for (size_t n : cfg.portMapHosts) {
+        const std::string tag = std::to_string(n / 1000) + "k";
+        std::mt19937 rng(11);
+        PortMapBuilder before, after;
+        for (size_t h = 0; h < n; h++) {
+            uint32_t addr = 0x0A000000u + (uint32_t)h;
+            before.scanned(addr);
+            after.scanned(addr);
+            std::vector<uint16_t> ports;
+            if (h % 1000 == 999) {
+                for (uint32_t p = 1; p < 65536; p++) if (rng() % 8) ports.push_back((uint16_t)p);
+            }
+            else if (h % 100 == 99) {
+                for (uint16_t p = 8000; p < 9000; p++) ports.push_back(p);
+            }
+            else {
+                for (uint16_t p : common) if (rng() % 4 == 0) ports.push_back(p);
+            }
+            bool changed = rng() % 100 == 0;
+            for (size_t i = 0; i < ports.size(); i++) {
+                before.open(addr, ports[i]);
+                if (!(changed && i == 0)) after.open(addr, ports[i]);   // Changed hosts close one port...
+            }
+            if (changed) after.open(addr, (uint16_t)(10000 + rng() % 50000));  // ...and open another
+        }
+        PortMap a = before.build(), b = after.build();
+        addMetric("portmap_bytes_per_host." + tag, (double)b.memoryBytes() / n);
+
+        size_t changes = 0;
+        addMetric("portmap_diff_us." + tag, medianUs(11, [&]() {
+            changes += diffPortMaps(a, b, [](const PortMapChange&) {}).hostsChanged;
+        }));
+        if (changes == 0) std::cerr << "[!] port map " << tag << ": diff found no changes\n";
+    }
+}
+
+// ---------- ALLOCATIONS PER PROBE ----------
+// Warm up once, then count heap allocations over a second run on the same engine / probe
+bool allocationFailures = false;
+
+void addAllocMetric(const std::string& name, uint64_t allocations, size_t probes) {
+    double perProbe = (double)allocations / probes;
+    addMetric("allocs_per_probe." + name, perProbe);
+    if (allocations) {
+        std::cerr << "[!] " << name << ": " << allocations << " heap allocations in " << probes << " warm probes\n";
+        allocationFailures = true;
+    }
+}
+
+void benchAllocations(const BenchConfig& cfg) {
+    std::cout << "[BENCH] Heap allocations per probe after warm-up (" << cfg.cpuProbes << " probes each)\n";
+    std::vector<ProbeTarget> targets = makeTargets(cfg, cfg.cpuProbes);
+    size_t open = 0;
+    const std::function<void(const ProbeResult&)> count = [&open](const ProbeResult& r) { open += r.status == ProbeStatus::Open; };
+
+    for (ProbeBackend backend : { ProbeBackend::Select, ProbeBackend::Epoll }) {
+        ProbeEngine engine(backend, 64, 500);
+        engine.run(targets.data(), std::min<size_t>(targets.size(), 256), count);
+        uint64_t before = heapAllocations.load();
+        engine.run(targets, count);
+        addAllocMetric(probeBackendName(backend), heapAllocations.load() - before, targets.size());
+    }
+
+    BasicProbe<TcpTransport, ConnectOnly, AdaptiveTimeout, TraceInstrumentation> probe{ AdaptiveTimeout(20, 500) };
+    probe.run(targets.data(), std::min<size_t>(targets.size(), 256), [&](const ProbeResult& r) { count(r); });
+    uint64_t before = heapAllocations.load();
+    probe.run(targets.data(), targets.size(), [&](const ProbeResult& r) { count(r); });
+    addAllocMetric("policy_core", heapAllocations.load() - before, targets.size());
+}
+
+// ---------- JSON / BASELINE ----------
+std::string toJson(const BenchConfig& cfg) {
+    std::ostringstream out;
+    out << "{\n  \"bench\": \"probe_bench\",\n"
+        << "  \"config\": { \"ip\": \"" << cfg.ip << "\", \"ports\": \"" << cfg.portLo << "-" << cfg.portHi
+        << "\", \"cpu_probes\": " << cfg.cpuProbes << ", \"throughput_probes\": " << cfg.throughputProbes
+        << ", \"detect_trials\": " << cfg.detectTrials << ", \"detect_interval_ms\": " << cfg.detectIntervalMs << " },\n"
+        << "  \"unsupported_backends\": [\"io_uring\", \"raw_syn\"],\n"
+        << "  \"perf_counters\": [";
+    bool first = true;
+    for (int i = 0; i < kPerfCounters; i++) {
+        if (!perfSeen[i]) continue;
+        out << (first ? "" : ", ") << "\"" << perfCounterName((PerfCounter)i) << "\"";
+        first = false;
+    }
+    out << "],\n"
+        << "  \"metrics\": {\n";
+    for (size_t i = 0; i < metrics.size(); i++)
+        out << "    \"" << metrics[i].first << "\": " << metrics[i].second << (i + 1 < metrics.size() ? ",\n" : "\n");
+    out << "  }\n}\n";
+    return out.str();
+}
+
+// Reads the flat "metrics" object written by toJson()
+std::map<std::string, double> loadBaseline(const std::string& path) {
+    std::map<std::string, double> out;
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    std::string text = ss.str();
+
+    size_t pos = text.find("\"metrics\"");
+    if (pos == std::string::npos) return out;
+    pos = text.find('{', pos);
+    size_t end = text.find('}', pos);
+    while (pos != std::string::npos && pos < end) {
+        size_t k0 = text.find('"', pos + 1);
+        if (k0 == std::string::npos || k0 > end) break;
+        size_t k1 = text.find('"', k0 + 1);
+        size_t colon = text.find(':', k1);
+        out[text.substr(k0 + 1, k1 - k0 - 1)] = std::strtod(text.c_str() + colon + 1, nullptr);
+        pos = text.find(',', colon);
+    }
+    return out;
+}
+
+int compareBaseline(const BenchConfig& cfg) {
+    std::map<std::string, double> base = loadBaseline(cfg.baselinePath);
+    if (base.empty()) {
+        std::cerr << "[!] Baseline " << cfg.baselinePath << " has no metrics.\n";
+        return 1;
+    }
+
+    int regressions = 0;
+    std::cout << "[BENCH] Compared with " << cfg.baselinePath << " (tolerance " << cfg.tolerance * 100 << "%)\n";
+    for (const auto& m : metrics) {
+        auto it = base.find(m.first);
+        if (it == base.end()) continue;
+        if (it->second == 0.0) {
+            // No relative change from zero (false positives, allocations): any rise regresses
+            bool worse = !higherIsBetter(m.first) && m.second > 0.0;
+            if (worse) regressions++;
+            std::cout << "  " << (worse ? "REGRESSION " : "ok         ") << m.first << ": 0 -> " << m.second << "\n";
+            continue;
+        }
+        double change = (m.second - it->second) / it->second;
+        bool worse = higherIsBetter(m.first) ? change < -cfg.tolerance : change > cfg.tolerance;
+        if (worse) regressions++;
+        std::cout << "  " << (worse ? "REGRESSION " : "ok         ") << m.first
+            << ": " << it->second << " -> " << m.second << " (" << (change >= 0 ? "+" : "") << change * 100 << "%)\n";
+    }
+    return regressions ? 2 : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--ip" && hasValue) cfg.ip = argv[++i];
+        else if (arg == "--ports" && hasValue) {
+            std::string spec = argv[++i];
+            cfg.portLo = std::atoi(spec.c_str());
+            size_t dash = spec.find('-');
+            cfg.portHi = (dash == std::string::npos) ? cfg.portLo : std::atoi(spec.c_str() + dash + 1);
+        }
+        else if (arg == "--probes" && hasValue) cfg.cpuProbes = cfg.throughputProbes = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--trials" && hasValue) cfg.detectTrials = std::atoi(argv[++i]);
+        else if (arg == "--targets" && hasValue) cfg.memoryTargets = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--out" && hasValue) cfg.outPath = argv[++i];
+        else if (arg == "--baseline" && hasValue) cfg.baselinePath = argv[++i];
+        else if (arg == "--tolerance" && hasValue) cfg.tolerance = std::atof(argv[++i]);
+        else if (arg == "--trace" && hasValue) cfg.tracePath = argv[++i];
+        else {
+            std::cerr << "Usage: probe_bench [--ip a.b.c.d] [--ports lo-hi] [--probes n] [--trials n]\n"
+                "                   [--targets n] [--out file.json] [--baseline file.json] [--tolerance 0.1]\n"
+                "                   [--trace trace.json]\n";
+            return 1;
+        }
+    }
+    if (cfg.portHi < cfg.portLo) cfg.portHi = cfg.portLo;
+
+    if (!isHostReachable(cfg.ip, cfg.portLo, 500)) {
+        std::cerr << "[!] Nothing listening on " << cfg.ip << ":" << cfg.portLo
+            << " - start listener_fixture --ports " << cfg.portLo << "-" << cfg.portHi << " first.\n";
+        return 1;
+    }
+
+    perfSetEnabled(true);
+    benchCpuCost(cfg);
+    benchThroughput(cfg);
+    benchDetection(cfg);
+    benchFalsePositives(cfg);
+    benchMemory(cfg);
+    benchTargetStore(cfg);
+    benchPortMaps(cfg);
+    benchAllocations(cfg);
+
+    if (!cfg.tracePath.empty()) {
+#ifdef PROBE_TRACE
+        tracePrintStats(std::cout);
+        if (traceExportChrome(cfg.tracePath)) std::cout << "[BENCH] Trace written to " << cfg.tracePath << "\n";
+#else
+        std::cerr << "[!] --trace needs a build with -DPROBE_TRACE; no trace written.\n";
+#endif
+    }
+
+    std::string json = toJson(cfg);
+    if (cfg.outPath.empty()) {
+        std::cout << json;
+    }
+    else {
+        std::ofstream(cfg.outPath) << json;
+        std::cout << "[BENCH] Results written to " << cfg.outPath << "\n";
+    }
+
+    int rc = cfg.baselinePath.empty() ? 0 : compareBaseline(cfg);
+    return allocationFailures ? 2 : rc;
+}
@@ -0,0 +1,96 @@
+/*
+ * On-Demand Probe Cache
+ * Author: Alushi
+ * Description:
+ *   - See probe_cache.h.
+ */
+
+#include "probe_cache.h"
+
+const char* probeCacheSourceName(ProbeCacheSource source) {
+    switch (source) {
+    case ProbeCacheSource::Fresh: return "fresh";
+    case ProbeCacheSource::Cached: return "cached";
+    case ProbeCacheSource::Joined: return "joined";
+    }
+    return "?";
+}
+
+ProbeCache::ProbeCache(ProbeCacheOptions opts) : opts_(opts) {
+    if (opts_.maxEntries == 0) opts_.maxEntries = 1;
+}
+
+void ProbeCache::get(const ProbeCacheKey& key, const Probe& probe, Done done) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto hit = entries_.find(key);
+        if (hit != entries_.end()) {
+            int64_t age = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - hit->second.at).count();
+            if (age < opts_.ttlMs) {
+                ProbeCacheAnswer a{ hit->second.value, ProbeCacheSource::Cached, age };
+                stats_.hits++;
+                lock.unlock();
+                done(a);
+                return;
+            }
+            entries_.erase(hit);
+        }
+        auto flight = inFlight_.find(key);
+        if (flight != inFlight_.end()) {
+            flight->second.push_back(std::move(done));
+            stats_.joined++;
+            return;
+        }
+        inFlight_[key];                 // Later identical requests queue behind this probe
+        stats_.probes++;
+    }
+
+    ProbeCacheValue value = probe();
+    Clock::time_point at = Clock::now();
+
+    std::vector<Done> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto flight = inFlight_.find(key);
+        waiters.swap(flight->second);
+        inFlight_.erase(flight);
+        if (value.status != ProbeStatus::Error && !value.cancelled) store(key, value, at);
+    }
+
+    done(ProbeCacheAnswer{ value, ProbeCacheSource::Fresh, 0 });
+    for (Done& w : waiters) {
+        int64_t age = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - at).count();
+        w(ProbeCacheAnswer{ value, ProbeCacheSource::Joined, age });
+    }
+}
+
+// Caller holds mutex_
+void ProbeCache::store(const ProbeCacheKey& key, const ProbeCacheValue& value, Clock::time_point at) {
+    if (entries_.size() >= opts_.maxEntries && !entries_.count(key)) {
+        const auto ttl = std::chrono::milliseconds(opts_.ttlMs);
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            if (at - it->second.at >= ttl) it = entries_.erase(it);
+            else ++it;
+        }
+        if (entries_.size() >= opts_.maxEntries) {
+            auto oldest = entries_.begin();
+            for (auto it = entries_.begin(); it != entries_.end(); ++it)
+                if (it->second.at < oldest->second.at) oldest = it;
+            entries_.erase(oldest);
+        }
+    }
+    entries_[key] = Entry{ value, at };
+}
+
+void ProbeCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+ProbeCacheStats ProbeCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProbeCacheStats s = stats_;
+    s.entries = entries_.size();
+    s.inFlight = inFlight_.size();
+    return s;
+}
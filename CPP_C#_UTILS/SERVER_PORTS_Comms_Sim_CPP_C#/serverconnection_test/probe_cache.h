@@ -0,0 +1,116 @@
+/*
+ * On-Demand Probe Cache
+ * Author: Alushi
+ * Description:
+ *   - Opt-in (--test-cache [ttl ms]) cache in front of the on-demand "test <port>" probes of
+ *     the REPL and the control socket, keyed by address, port, probe type (plain connect
+ *     or banner grab) and timeout, since a filtered port that times out at 200 ms may well
+ *     answer within a second. A repeat within the TTL is answered from memory instead of
+ *     paying for another connect, or for a full timeout when the port is filtered.
+ *   - Coalescing: a request for a key that is already being probed does not start a second
+ *     probe. It joins the one in flight and gets the same result when that one finishes.
+ *     Waiters are callbacks, not blocked threads, so a burst of identical tests holds one
+ *     job worker, not all of them.
+ *   - Every answer says where it came from (fresh probe, cache, or joined in-flight probe)
+ *     and how old the result is.
+ *   - Results that are Error (the probe never left this host) are passed on but not cached.
+ *     A probe that was cancelled says so in its value; requests that joined it get that
+ *     "cancelled" answer, not its unfinished result, and nothing is cached.
+ *   - Bounded: at most maxEntries results; expired entries go first, then the oldest.
+ *   - Thread-safe; probes run on the caller's thread, outside the lock.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "probe_engine.h"
+
+enum class ProbeCacheType : uint8_t { Connect, Banner };
+
+struct ProbeCacheKey {
+    uint32_t addr = 0;              // Network byte order, as in ProbeTarget
+    uint16_t port = 0;
+    ProbeCacheType type = ProbeCacheType::Connect;
+    int timeoutMs = 0;
+
+    bool operator==(const ProbeCacheKey& o) const {
+        return addr == o.addr && port == o.port && type == o.type && timeoutMs == o.timeoutMs;
+    }
+};
+
+struct ProbeCacheKeyHash {
+    size_t operator()(const ProbeCacheKey& k) const {
+        uint64_t packed = (uint64_t)k.addr << 24 | (uint64_t)k.port << 8 | (uint8_t)k.type;
+        return std::hash<uint64_t>()(packed ^ (uint64_t)(uint32_t)k.timeoutMs << 56);
+    }
+};
+
+struct ProbeCacheValue {
+    ProbeStatus status = ProbeStatus::Error;
+    float rttMs = 0.0f;
+    std::string detail;             // Probe-type specific text (service and banner)
+    bool cancelled = false;         // Set by a probe stopped before it finished; status is meaningless
+};
+
+enum class ProbeCacheSource : uint8_t { Fresh, Cached, Joined };
+
+const char* probeCacheSourceName(ProbeCacheSource source);
+
+struct ProbeCacheAnswer {
+    ProbeCacheValue value;
+    ProbeCacheSource source = ProbeCacheSource::Fresh;
+    int64_t ageMs = 0;              // Since the probe that produced 'value' finished
+};
+
+struct ProbeCacheOptions {
+    int ttlMs = 2000;
+    size_t maxEntries = 4096;
+};
+
+struct ProbeCacheStats {
+    uint64_t probes = 0;            // Fresh probes actually run
+    uint64_t hits = 0;
+    uint64_t joined = 0;            // Requests that shared an in-flight probe
+    size_t entries = 0;
+    size_t inFlight = 0;
+};
+
+class ProbeCache {
+public:
+    using Probe = std::function<ProbeCacheValue()>;
+    using Done = std::function<void(const ProbeCacheAnswer&)>;
+
+    explicit ProbeCache(ProbeCacheOptions opts);
+
+    // Calls 'done' once: right away from the cache, after running 'probe' on this thread, or
+    // (joining an identical probe in flight) on the thread that runs that probe
+    void get(const ProbeCacheKey& key, const Probe& probe, Done done);
+
+    void clear();
+    ProbeCacheStats stats() const;
+    const ProbeCacheOptions& options() const { return opts_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        ProbeCacheValue value;
+        Clock::time_point at;       // When the probe finished
+    };
+
+    void store(const ProbeCacheKey& key, const ProbeCacheValue& value, Clock::time_point at);
+
+    ProbeCacheOptions opts_;
+    mutable std::mutex mutex_;
+    std::unordered_map<ProbeCacheKey, Entry, ProbeCacheKeyHash> entries_;
+    std::unordered_map<ProbeCacheKey, std::vector<Done>, ProbeCacheKeyHash> inFlight_;    // Waiters per probe in progress
+    ProbeCacheStats stats_;
+};
@@ -0,0 +1,429 @@
+/*
+ * Concurrent Probe Engine
+ * Author: Alushi
+ * Description:
+ *   - See probe_engine.h.
+ */
+
+#include "probe_engine.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "perf_counters.h"
+#include "probe_trace.h"
+#include "socket_util.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const uint32_t kNoSlot = UINT32_MAX;
+
+float msSince(Clock::time_point start, Clock::time_point now) {
+    return std::chrono::duration<float, std::milli>(now - start).count();
+}
+
+bool isRefused(int err) {
+#ifdef _WIN32
+    return err == WSAECONNREFUSED;
+#else
+    return err == ECONNREFUSED;
+#endif
+}
+
+bool connectInProgress() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS;
+#endif
+}
+
+int msUntil(Clock::time_point deadline) {
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return ms < 0 ? 0 : (int)ms + 1;
+}
+
+} // namespace
+
+// ---------- CONTEXT POOL ----------
+// Per-probe contexts (a slab of 'window' slots with a free list), the in-flight list and the
+// completion ring. Allocated once per engine and reused by every run, so steady-state probing
+// never touches the heap.
+struct ProbeContextPool {
+    struct Slot {
+        socket_t fd = kInvalidSocket;
+        size_t index = 0;
+        Clock::time_point start;
+        Clock::time_point deadline;
+        bool active = false;
+        ProbeTarget target;
+        uint32_t prev = kNoSlot;        // In-flight list, launch order
+        uint32_t next = kNoSlot;
+#ifdef PROBE_TRACE
+        uint64_t traceId = 0;
+#endif
+    };
+
+    explicit ProbeContextPool(size_t window) : slots(window), freeSlots(window), ring(window) {
+        for (size_t i = 0; i < window; i++) freeSlots[i] = (uint32_t)(window - 1 - i);
+        freeCount = window;
+#ifdef __linux__
+        events.resize(std::min<size_t>(window, 1024));
+#endif
+    }
+
+    ~ProbeContextPool() {
+#ifdef __linux__
+        if (epollFd >= 0) close(epollFd);
+#endif
+    }
+
+    uint32_t acquire() { return freeSlots[--freeCount]; }
+    void release(uint32_t s) { freeSlots[freeCount++] = s; }
+
+    // All probes share one timeout, so launch order is deadline order: the list head expires first
+    void link(uint32_t s, int timeoutMs) {
+        Slot& slot = slots[s];
+        slot.active = true;
+        slot.deadline = slot.start + std::chrono::milliseconds(timeoutMs);
+        slot.prev = tail;
+        slot.next = kNoSlot;
+        if (tail != kNoSlot) slots[tail].next = s;
+        else head = s;
+        tail = s;
+        inflight++;
+    }
+
+    void unlink(uint32_t s) {
+        Slot& slot = slots[s];
+        if (slot.prev != kNoSlot) slots[slot.prev].next = slot.next;
+        else head = slot.next;
+        if (slot.next != kNoSlot) slots[slot.next].prev = slot.prev;
+        else tail = slot.prev;
+        slot.active = false;
+        inflight--;
+    }
+
+    // Completions are buffered and handed out in batches; a full ring is drained early
+    void deliver(const ProbeResult& r) {
+        ring[pending++] = r;
+        if (pending == ring.size()) flush();
+    }
+
+    void flush() {
+        for (size_t i = 0; i < pending; i++) (*onResult)(ring[i]);
+        pending = 0;
+    }
+
+    void finish(uint32_t s, ProbeStatus status, Clock::time_point now) {
+        Slot& slot = slots[s];
+        ProbeResult r;
+        r.index = slot.index;
+        r.target = slot.target;
+        r.status = status;
+        r.rttMs = msSince(slot.start, now);
+        PROBE_TRACE_MARK(traceMark);
+        closeSocket(slot.fd);           // Also removes it from the epoll set
+        PROBE_TRACE_STEP(Close, slot.traceId, traceMark);
+        slot.fd = kInvalidSocket;
+        unlink(s);
+        release(s);
+        deliver(r);
+    }
+
+    void expire(Clock::time_point now) {
+        while (head != kNoSlot && now >= slots[head].deadline) finish(head, ProbeStatus::Timeout, now);
+    }
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    size_t freeCount = 0;
+    uint32_t head = kNoSlot;
+    uint32_t tail = kNoSlot;
+    size_t inflight = 0;
+    std::vector<ProbeResult> ring;
+    size_t pending = 0;
+    const std::function<void(const ProbeResult&)>* onResult = nullptr;     // Of the current run
+#ifdef __linux__
+    std::vector<epoll_event> events;
+    int epollFd = -1;                   // Created on the first epoll run, kept for the next
+#endif
+};
+
+namespace {
+
+using Slot = ProbeContextPool::Slot;
+
+// Issues a non-blocking connect; returns true if the probe is now pending, false if it
+// finished immediately (result filled in)
+bool launch(const ProbeTarget& t, Slot& slot, ProbeResult& immediate) {
+#ifdef PROBE_TRACE
+    slot.traceId = traceNextProbeId();
+#endif
+    PROBE_TRACE_MARK(traceMark);
+    slot.start = Clock::now();
+    slot.fd = socket(AF_INET, SOCK_STREAM, 0);
+    PROBE_TRACE_STEP(Socket, slot.traceId, traceMark);
+    if (slot.fd == kInvalidSocket) {
+        immediate.status = ProbeStatus::Error;
+        return false;
+    }
+    setNonBlocking(slot.fd);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(t.port);
+    addr.sin_addr.s_addr = t.addr;
+
+    int rc = connect(slot.fd, (sockaddr*)&addr, sizeof(addr));
+    PROBE_TRACE_STEP(Connect, slot.traceId, traceMark);
+    if (rc == 0) {
+        immediate.status = ProbeStatus::Open;
+    }
+    else if (connectInProgress()) {
+        return true;
+    }
+    else {
+#ifdef _WIN32
+        immediate.status = isRefused(WSAGetLastError()) ? ProbeStatus::Closed : ProbeStatus::Error;
+#else
+        immediate.status = isRefused(errno) ? ProbeStatus::Closed : ProbeStatus::Error;
+#endif
+    }
+    immediate.rttMs = msSince(slot.start, Clock::now());
+    closeSocket(slot.fd);
+    PROBE_TRACE_STEP(Close, slot.traceId, traceMark);
+    slot.fd = kInvalidSocket;
+    return false;
+}
+
+ProbeStatus completionStatus(const Slot& slot) {
+    PROBE_TRACE_MARK(traceMark);
+    int so_error = 0;
+    socklen_t len = sizeof(so_error);
+    int rc = getsockopt(slot.fd, SOL_SOCKET, SO_ERROR, (char*)&so_error, &len);
+    PROBE_TRACE_STEP(SockOpt, slot.traceId, traceMark);
+    if (rc != 0) return ProbeStatus::Error;
+    if (so_error == 0) return ProbeStatus::Open;
+    return isRefused(so_error) ? ProbeStatus::Closed : ProbeStatus::Error;
+}
+
+} // namespace
+
+bool makeProbeTarget(const std::string& ip, int port, ProbeTarget& out) {
+    in_addr a{};
+    if (inet_pton(AF_INET, ip.c_str(), &a) != 1 || port <= 0 || port > 65535) return false;
+    out.addr = a.s_addr;
+    out.port = (uint16_t)port;
+    return true;
+}
+
+const char* probeBackendName(ProbeBackend backend) {
+    switch (backend) {
+    case ProbeBackend::Select: return "select";
+    case ProbeBackend::Epoll: return "epoll";
+    }
+    return "?";
+}
+
+const char* probeStatusName(ProbeStatus status) {
+    switch (status) {
+    case ProbeStatus::Open: return "open";
+    case ProbeStatus::Closed: return "closed";
+    case ProbeStatus::Timeout: return "timeout";
+    case ProbeStatus::Error: return "error";
+    }
+    return "?";
+}
+
+ProbeEngine::ProbeEngine(ProbeBackend backend, size_t window, int timeoutMs)
+    : backend_(backend), window_(window ? window : 1), timeoutMs_(timeoutMs) {
+#ifndef __linux__
+    backend_ = ProbeBackend::Select;
+#endif
+    // select() can only watch FD_SETSIZE sockets (64 by default on Windows)
+    if (backend_ == ProbeBackend::Select) window_ = std::min<size_t>(window_, FD_SETSIZE - 8 > 0 ? FD_SETSIZE - 8 : 1);
+    pool_.reset(new ProbeContextPool(window_));
+}
+
+ProbeEngine::~ProbeEngine() = default;
+
+void ProbeEngine::run(const ProbeTarget* targets, size_t count, const std::function<void(const ProbeResult&)>& onResult) {
+    // One captured pointer fits std::function's inline storage, so wrapping the source is free
+    struct Cursor {
+        const ProbeTarget* next;
+        const ProbeTarget* end;
+    } cursor{ targets, targets + count };
+    run([c = &cursor](ProbeTarget& out) {
+        if (c->next == c->end) return false;
+        out = *c->next++;
+        return true;
+    }, onResult);
+}
+
+void ProbeEngine::run(const std::vector<ProbeTarget>& targets, const std::function<void(const ProbeResult&)>& onResult) {
+    run(targets.data(), targets.size(), onResult);
+}
+
+void ProbeEngine::run(const ProbeSource& source, const std::function<void(const ProbeResult&)>& onResult) {
+    netInitOnce();
+    PerfScope perfScope(perf_, 0);
+    pool_->onResult = &onResult;
+    size_t pulled;
+#ifdef __linux__
+    if (backend_ == ProbeBackend::Epoll)
+        pulled = runEpoll(source);
+    else
+#endif
+    pulled = runSelect(source);
+    pool_->flush();
+    perfScope.setProbes(pulled);
+}
+
+size_t ProbeEngine::runSelect(const ProbeSource& source) {
+    ProbeContextPool& pool = *pool_;
+    size_t next = 0;
+    bool exhausted = false;
+
+    while (!exhausted || pool.inflight > 0) {
+        if (cancel_ && cancel_->load(std::memory_order_relaxed)) exhausted = true;
+        while (pool.inflight < window_ && !exhausted) {
+            uint32_t s = pool.acquire();
+            Slot& slot = pool.slots[s];
+            if (!source(slot.target)) {
+                pool.release(s);
+                exhausted = true;
+                break;
+            }
+            slot.index = next;
+            ProbeResult immediate;
+            immediate.index = next;
+            immediate.target = slot.target;
+            next++;
+            bool pending = launch(slot.target, slot, immediate);
+#ifndef _WIN32
+            if (pending && slot.fd >= FD_SETSIZE) {
+                closeSocket(slot.fd);
+                immediate.status = ProbeStatus::Error;
+                pending = false;
+            }
+#endif
+            if (!pending) {
+                pool.release(s);
+                pool.deliver(immediate);
+                continue;
+            }
+            pool.link(s, timeoutMs_);
+        }
+        if (pool.inflight == 0) continue;
+
+        fd_set writeSet, errorSet;
+        FD_ZERO(&writeSet);
+        FD_ZERO(&errorSet);
+        socket_t maxFd = 0;
+        for (uint32_t s = pool.head; s != kNoSlot; s = pool.slots[s].next) {
+            socket_t fd = pool.slots[s].fd;
+            FD_SET(fd, &writeSet);
+            FD_SET(fd, &errorSet);          // Windows reports failed connects here
+            if (fd > maxFd) maxFd = fd;
+        }
+
+        int waitMs = msUntil(pool.slots[pool.head].deadline);
+        struct timeval tv;
+        tv.tv_sec = waitMs / 1000;
+        tv.tv_usec = (waitMs % 1000) * 1000;
+        PROBE_TRACE_MARK(traceMark);
+        int n = select((int)maxFd + 1, nullptr, &writeSet, &errorSet, &tv);
+        PROBE_TRACE_STEP(Wait, 0, traceMark);
+
+        auto now = Clock::now();
+        if (n > 0) {
+            for (uint32_t s = pool.head; s != kNoSlot;) {
+                uint32_t after = pool.slots[s].next;   // finish() unlinks s
+                socket_t fd = pool.slots[s].fd;
+                if (FD_ISSET(fd, &writeSet) || FD_ISSET(fd, &errorSet))
+                    pool.finish(s, completionStatus(pool.slots[s]), now);
+                s = after;
+            }
+        }
+        pool.expire(now);
+        pool.flush();
+    }
+    return next;
+}
+
+#ifdef __linux__
+size_t ProbeEngine::runEpoll(const ProbeSource& source) {
+    ProbeContextPool& pool = *pool_;
+    if (pool.epollFd < 0) pool.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (pool.epollFd < 0) return runSelect(source);
+    const int ep = pool.epollFd;
+
+    size_t next = 0;
+    bool exhausted = false;
+
+    while (!exhausted || pool.inflight > 0) {
+        if (cancel_ && cancel_->load(std::memory_order_relaxed)) exhausted = true;
+        while (pool.inflight < window_ && !exhausted) {
+            uint32_t s = pool.acquire();
+            Slot& slot = pool.slots[s];
+            if (!source(slot.target)) {
+                pool.release(s);
+                exhausted = true;
+                break;
+            }
+            slot.index = next;
+            ProbeResult immediate;
+            immediate.index = next;
+            immediate.target = slot.target;
+            next++;
+            if (!launch(slot.target, slot, immediate)) {
+                pool.release(s);
+                pool.deliver(immediate);
+                continue;
+            }
+            // One-shot: the first readiness report decides the probe and disarms the fd
+            epoll_event ev{};
+            ev.events = EPOLLOUT | EPOLLONESHOT;
+            ev.data.u64 = s;
+            if (epoll_ctl(ep, EPOLL_CTL_ADD, slot.fd, &ev) < 0) {
+                // An unwatched probe would only ever end at its deadline; fail it now instead
+                closeSocket(slot.fd);
+                slot.fd = kInvalidSocket;
+                immediate.status = ProbeStatus::Error;
+                immediate.rttMs = msSince(slot.start, Clock::now());
+                pool.release(s);
+                pool.deliver(immediate);
+                continue;
+            }
+            pool.link(s, timeoutMs_);
+        }
+        if (pool.inflight == 0) continue;
+
+        PROBE_TRACE_MARK(traceMark);
+        int n = epoll_wait(ep, pool.events.data(), (int)pool.events.size(), msUntil(pool.slots[pool.head].deadline));
+        PROBE_TRACE_STEP(Wait, 0, traceMark);
+        if (n < 0 && errno != EINTR) {
+            // The set itself is broken; nothing in flight can be reported any more
+            auto now = Clock::now();
+            while (pool.head != kNoSlot) pool.finish(pool.head, ProbeStatus::Error, now);
+            pool.flush();
+            continue;
+        }
+        auto now = Clock::now();
+        for (int i = 0; i < n; i++) {
+            uint32_t s = (uint32_t)pool.events[i].data.u64;
+            if (pool.slots[s].active) pool.finish(s, completionStatus(pool.slots[s]), now);
+        }
+        pool.expire(now);
+        pool.flush();
+    }
+    return next;
+}
+#endif
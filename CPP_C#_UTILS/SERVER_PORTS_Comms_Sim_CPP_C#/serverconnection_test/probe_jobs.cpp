@@ -0,0 +1,151 @@
+/*
+ * Probe Job Runner
+ * Author: Alushi
+ * Description:
+ *   - See probe_jobs.h.
+ */
+
+#include "probe_jobs.h"
+
+ProbeJobRunner::ProbeJobRunner(int workers, DispatchPolicy policy) : ready_(policy), workerCount_(workers > 0 ? (size_t)workers : 1) {
+    for (size_t i = 0; i < workerCount_; i++)
+        workers_.emplace_back(&ProbeJobRunner::workerLoop, this);
+}
+
+ProbeJobRunner::~ProbeJobRunner() {
+    stop();
+}
+
+uint64_t ProbeJobRunner::submit(const std::string& label, Task task, ProbeClass cls) {
+    auto job = std::make_shared<Job>();
+    job->label = label;
+    job->task = std::move(task);
+    job->cls = cls;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->id = nextId_++;
+        jobs_[job->id] = job;
+        ready_.push(cls, job, Clock::now());
+    }
+    cv_.notify_one();
+    return job->id;
+}
+
+uint64_t ProbeJobRunner::every(const std::string& label, int intervalMs, Task task, ProbeClass cls) {
+    auto job = std::make_shared<Job>();
+    job->label = label;
+    job->task = std::move(task);
+    job->cls = cls;
+    job->intervalMs = intervalMs > 0 ? intervalMs : 1;
+    job->due = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->id = nextId_++;
+        jobs_[job->id] = job;
+    }
+    cv_.notify_one();
+    return job->id;
+}
+
+bool ProbeJobRunner::cancel(uint64_t id, bool* discarded) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (discarded) *discarded = false;
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) return false;
+    it->second->cancelled.store(true);
+    // Queued copies are skipped by the workers; a running job is dropped when it returns
+    if (!it->second->running) {
+        if (discarded) *discarded = true;
+        jobs_.erase(it);
+    }
+    return true;
+}
+
+std::vector<std::string> ProbeJobRunner::describe() const {
+    std::vector<std::string> out;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& kv : jobs_) {
+        const Job& j = *kv.second;
+        std::string state = j.intervalMs ? "every " + std::to_string(j.intervalMs) + " ms"
+            : (j.running ? "running" : "queued");
+        out.push_back(std::to_string(j.id) + " " + j.label + " [" + probeClassName(j.cls) + "] " + state);
+    }
+    return out;
+}
+
+std::vector<std::string> ProbeJobRunner::describeQueues() const {
+    std::vector<std::string> out;
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t running[kProbeClasses] = {};
+    for (const auto& kv : jobs_)
+        if (kv.second->running) running[(size_t)kv.second->cls]++;
+    for (size_t i = 0; i < kProbeClasses; i++)
+        out.push_back(ready_.describe((ProbeClass)i) + ", " + std::to_string(running[i]) + " running");
+    out.push_back(std::string(dispatchPolicyName(ready_.policy())) + " dispatch over " + std::to_string(workerCount_) + " workers");
+    return out;
+}
+
+void ProbeJobRunner::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+        for (auto& kv : jobs_) kv.second->cancelled.store(true);
+    }
+    cv_.notify_all();
+    for (auto& w : workers_) w.join();
+    workers_.clear();
+}
+
+void ProbeJobRunner::workerLoop() {
+    const unsigned allClasses = (1u << kProbeClasses) - 1;
+    const unsigned noBulk = allClasses & ~(1u << (unsigned)ProbeClass::Bulk);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        // Periodic jobs that came due join their class queue, measured from their due time
+        Clock::time_point nextDue = Clock::time_point::max();
+        auto now = Clock::now();
+        for (auto& kv : jobs_) {
+            Job& j = *kv.second;
+            if (!j.intervalMs || j.running || j.queued) continue;
+            if (j.due <= now) {
+                j.queued = true;
+                ready_.push(j.cls, kv.second, j.due);
+            }
+            else if (j.due < nextDue) {
+                nextDue = j.due;
+            }
+        }
+
+        // Bulk may not take the last idle worker (unless there is only one); this worker is
+        // idle, so bulk needs one more besides it
+        bool bulkAllowed = workerCount_ < 2 || workerCount_ - running_ >= 2;
+        std::shared_ptr<Job> job;
+        while (!job && ready_.pop(job, nullptr, bulkAllowed ? allClasses : noBulk, now)) {
+            job->queued = false;
+            if (job->cancelled.load()) job.reset();
+        }
+        if (!job) {
+            if (nextDue == Clock::time_point::max()) cv_.wait(lock);
+            else cv_.wait_until(lock, nextDue);
+            continue;
+        }
+
+        job->running = true;
+        running_++;
+        lock.unlock();
+        job->task(job->cancelled);
+        lock.lock();
+        job->running = false;
+        running_--;
+
+        if (job->intervalMs && !job->cancelled.load()) {
+            job->due = Clock::now() + std::chrono::milliseconds(job->intervalMs);
+            cv_.notify_one();   // Another idle worker may now own the nearest deadline
+        }
+        else {
+            jobs_.erase(job->id);
+            if (!ready_.empty()) cv_.notify_one();     // A held-back bulk job may run now
+        }
+    }
+}
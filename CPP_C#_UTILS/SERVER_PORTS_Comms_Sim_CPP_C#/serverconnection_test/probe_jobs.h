@@ -0,0 +1,89 @@
+/*
+ * Probe Job Runner
+ * Author: Alushi
+ * Description:
+ *   - Small worker pool shared by the REPL and the control socket, so on-demand tests and
+ *     scans run next to each other and next to the monitor instead of blocking their caller.
+ *   - One-shot jobs (test, scan) and periodic jobs (watch), each with an id that can be
+ *     listed and cancelled. Jobs report through their own callbacks as results arrive.
+ *   - A cancelled job sees its flag set; scans pass it on to ProbeEngine, which then stops
+ *     launching new probes.
+ *   - Every job has a priority class (probe_priority.h): watches and housekeeping are monitor,
+ *     tests interactive, scans bulk. Runnable jobs wait in one queue per class and workers
+ *     take them strictly by class or weighted-fair. Bulk jobs never take the last free
+ *     worker, so even a full 0-65535 scan leaves room for the jobs above it.
+ *     Queue delay is tracked per class ("jobs").
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "probe_priority.h"
+
+class ProbeJobRunner {
+public:
+    using Task = std::function<void(const std::atomic<bool>& cancelled)>;
+
+    explicit ProbeJobRunner(int workers = 4, DispatchPolicy policy = DispatchPolicy::Strict);
+    ~ProbeJobRunner();
+
+    ProbeJobRunner(const ProbeJobRunner&) = delete;
+    ProbeJobRunner& operator=(const ProbeJobRunner&) = delete;
+
+    // Queues 'task' once; returns its job id
+    uint64_t submit(const std::string& label, Task task, ProbeClass cls = ProbeClass::Interactive);
+
+    // Runs 'task' now and then every intervalMs (never two runs at once) until cancelled
+    uint64_t every(const std::string& label, int intervalMs, Task task, ProbeClass cls = ProbeClass::Monitor);
+
+    // False if no such job is queued, running or scheduled. 'discarded' is set when the job
+    // was not running, so it was dropped on the spot and its task will not be called again.
+    bool cancel(uint64_t id, bool* discarded = nullptr);
+
+    // One line per live job: "<id> <label> [<class>] queued|running|every <n> ms"
+    std::vector<std::string> describe() const;
+    // One line per class: queued jobs, running jobs and queue delay
+    std::vector<std::string> describeQueues() const;
+
+    // Cancels everything and waits for running jobs to return
+    void stop();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        uint64_t id = 0;
+        std::string label;
+        Task task;
+        std::atomic<bool> cancelled{ false };
+        ProbeClass cls = ProbeClass::Interactive;
+        int intervalMs = 0;         // 0 = one-shot
+        Clock::time_point due;
+        bool queued = false;        // Periodic: due and waiting in ready_
+        bool running = false;
+    };
+
+    void workerLoop();
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<uint64_t, std::shared_ptr<Job>> jobs_;     // Every live job, by id
+    ClassQueues<std::shared_ptr<Job>> ready_;           // Runnable jobs, FIFO per class
+    size_t running_ = 0;                                // Jobs on a worker right now, any class
+    size_t workerCount_ = 1;
+    uint64_t nextId_ = 1;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
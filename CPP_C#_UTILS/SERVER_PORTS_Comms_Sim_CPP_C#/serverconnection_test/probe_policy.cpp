@@ -0,0 +1,115 @@
+/*
+ * Policy-Based Probe Core
+ * Author: Alushi
+ * Description:
+ *   - See probe_policy.h.
+ */
+
+#include "probe_policy.h"
+
+namespace {
+
+template <typename Transport, typename Check, typename Timeout, typename Instrument>
+class PolicyProbeRunner : public ProbeRunner {
+public:
+    explicit PolicyProbeRunner(Timeout timeout) : probe_(timeout) {}
+
+    void run(const ProbeTarget* targets, size_t count, const std::function<void(const ProbeResult&)>& onResult) override {
+        probe_.run(targets, count, onResult);
+    }
+
+    int timeoutMs() const override {
+        return probe_.timeout().budgetMs();
+    }
+
+    const ProbeCounts* counts() const override {
+        if constexpr (std::is_same<Instrument, TraceInstrumentation>::value)
+            return &probe_.instrument().counts();
+        else
+            return nullptr;
+    }
+
+private:
+    BasicProbe<Transport, Check, Timeout, Instrument> probe_;
+};
+
+// One level per policy: each picks a type from the variant and hands it to the next
+template <typename Transport, typename Check, typename Timeout>
+std::unique_ptr<ProbeRunner> pickInstrument(const ProbeVariant& v, Timeout timeout) {
+    if (v.instrumented) return std::unique_ptr<ProbeRunner>(new PolicyProbeRunner<Transport, Check, Timeout, TraceInstrumentation>(timeout));
+    return std::unique_ptr<ProbeRunner>(new PolicyProbeRunner<Transport, Check, Timeout, NoInstrumentation>(timeout));
+}
+
+template <typename Transport, typename Check>
+std::unique_ptr<ProbeRunner> pickTimeout(const ProbeVariant& v) {
+    if (v.adaptiveTimeout) return pickInstrument<Transport, Check>(v, AdaptiveTimeout(v.minTimeoutMs, v.timeoutMs));
+    return pickInstrument<Transport, Check>(v, FixedTimeout(v.timeoutMs));
+}
+
+template <typename Transport>
+std::unique_ptr<ProbeRunner> pickCheck(const ProbeVariant& v, std::string& error) {
+    if (v.completion == ProbeCompletion::Connect) return pickTimeout<Transport, ConnectOnly>(v);
+    if constexpr (Transport::kStream) {
+        if (v.completion == ProbeCompletion::Banner) return pickTimeout<Transport, BannerCheck>(v);
+        return pickTimeout<Transport, HttpHeadCheck>(v);
+    }
+    else {
+        error = std::string(probeCompletionName(v.completion)) + " check needs tcp, not " + probeTransportName(v.transport);
+        return nullptr;
+    }
+}
+
+} // namespace
+
+const char* probeTransportName(ProbeTransport transport) {
+    switch (transport) {
+    case ProbeTransport::Tcp: return "tcp";
+    case ProbeTransport::Udp: return "udp";
+    case ProbeTransport::Icmp: return "icmp";
+    }
+    return "?";
+}
+
+const char* probeCompletionName(ProbeCompletion completion) {
+    switch (completion) {
+    case ProbeCompletion::Connect: return "connect";
+    case ProbeCompletion::Banner: return "banner";
+    case ProbeCompletion::HttpHead: return "head";
+    }
+    return "?";
+}
+
+bool parseProbeTransport(const std::string& name, ProbeTransport& out) {
+    if (name == "tcp") out = ProbeTransport::Tcp;
+    else if (name == "udp") out = ProbeTransport::Udp;
+    else if (name == "icmp") out = ProbeTransport::Icmp;
+    else return false;
+    return true;
+}
+
+bool parseProbeCompletion(const std::string& name, ProbeCompletion& out) {
+    if (name == "connect") out = ProbeCompletion::Connect;
+    else if (name == "banner") out = ProbeCompletion::Banner;
+    else if (name == "head") out = ProbeCompletion::HttpHead;
+    else return false;
+    return true;
+}
+
+std::string describeProbeVariant(const ProbeVariant& variant) {
+    return std::string(probeTransportName(variant.transport)) + "/" + probeCompletionName(variant.completion)
+        + (variant.adaptiveTimeout ? "/adaptive" : "/fixed") + (variant.instrumented ? "/traced" : "");
+}
+
+std::unique_ptr<ProbeRunner> makeProbeRunner(const ProbeVariant& variant, std::string& error) {
+    if (variant.timeoutMs < 1 || variant.minTimeoutMs < 1 || variant.minTimeoutMs > variant.timeoutMs) {
+        error = "timeouts must satisfy 1 <= min <= max";
+        return nullptr;
+    }
+    switch (variant.transport) {
+    case ProbeTransport::Tcp: return pickCheck<TcpTransport>(variant, error);
+    case ProbeTransport::Udp: return pickCheck<UdpTransport>(variant, error);
+    case ProbeTransport::Icmp: return pickCheck<IcmpTransport>(variant, error);
+    }
+    error = "unknown transport";
+    return nullptr;
+}
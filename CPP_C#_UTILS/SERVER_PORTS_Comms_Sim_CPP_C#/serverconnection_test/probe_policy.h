@@ -0,0 +1,424 @@
+/*
+ * Policy-Based Probe Core
+ * Author: Alushi
+ * Description:
+ *   - One probe loop, BasicProbe<Transport, Check, Timeout, Instrument>, assembled from
+ *     policy types at compile time. Every combination is its own specialized loop: policy
+ *     calls are static or inline, so unused steps (an empty instrumentation hook, a connect-only
+ *     completion check) compile away and nothing is dispatched virtually per probe.
+ *       Transport:  TcpTransport (connect), UdpTransport (datagram, ICMP port-unreachable
+ *                   means Closed), IcmpTransport (echo request; Linux ping socket, raw socket
+ *                   elsewhere, which needs admin rights)
+ *       Check:      ConnectOnly, BannerCheck (service must speak first), HttpHeadCheck
+ *                   (HEAD / must answer 2xx or 3xx); the latter two need a stream transport
+ *       Timeout:    FixedTimeout, AdaptiveTimeout (srtt + 4 * rttvar, doubled after a timeout)
+ *       Instrument: NoInstrumentation, TraceInstrumentation (per-status counters, plus the
+ *                   PROBE_TRACE phase timings in trace builds)
+ *   - makeProbeRunner() picks the instantiation for a runtime ProbeVariant once, at
+ *     configuration time; the returned runner then probes whole batches in that loop.
+ *   - isHostReachable / testPortFast (port_probe.h) are the TCP / connect / fixed instance.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "probe_engine.h"
+#include "probe_trace.h"
+#include "socket_util.h"
+
+namespace probe_policy_detail {
+
+inline bool refused(int err) {
+#ifdef _WIN32
+    return err == WSAECONNREFUSED || err == WSAECONNRESET;     // UDP port unreachable shows as a reset
+#else
+    return err == ECONNREFUSED;
+#endif
+}
+
+inline int lastError() {
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+inline sockaddr_in toSockaddr(const ProbeTarget& t) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(t.port);
+    addr.sin_addr.s_addr = t.addr;
+    return addr;
+}
+
+inline uint16_t inetChecksum(const uint8_t* p, size_t n) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < n; i += 2) sum += (uint32_t)(p[i] << 8 | p[i + 1]);
+    if (n & 1) sum += (uint32_t)(p[n - 1] << 8);
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return htons((uint16_t)~sum);
+}
+
+} // namespace probe_policy_detail
+
+// ---------- TRANSPORTS ----------
+// start() opens a socket and sends the opening move; finish() turns readiness into a verdict,
+// with the rest of the budget for transports that may have to skip unrelated answers.
+// kStream transports leave the socket connected for the completion check.
+
+struct TcpTransport {
+    static constexpr bool kStream = true;
+    static constexpr bool kWaitWritable = true;
+
+    static socket_t start(const ProbeTarget& t, uint16_t /*seq*/) {
+        netInitOnce();
+        socket_t s = socket(AF_INET, SOCK_STREAM, 0);
+        if (s == kInvalidSocket) return s;
+        setNonBlocking(s);
+        sockaddr_in addr = probe_policy_detail::toSockaddr(t);
+        connect(s, (sockaddr*)&addr, sizeof(addr));
+        return s;
+    }
+
+    static ProbeStatus finish(socket_t s, bool ready, uint16_t /*seq*/, int /*remainingMs*/) {
+        if (!ready) return ProbeStatus::Timeout;
+        int soError = 0;
+        socklen_t len = sizeof(soError);
+        getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&soError, &len);
+        if (soError == 0) return ProbeStatus::Open;
+        return probe_policy_detail::refused(soError) ? ProbeStatus::Closed : ProbeStatus::Error;
+    }
+};
+
+// Silence within the deadline is Timeout ("open or filtered"); only an answer proves Open
+struct UdpTransport {
+    static constexpr bool kStream = false;
+    static constexpr bool kWaitWritable = false;
+
+    static socket_t start(const ProbeTarget& t, uint16_t /*seq*/) {
+        netInitOnce();
+        socket_t s = socket(AF_INET, SOCK_DGRAM, 0);
+        if (s == kInvalidSocket) return s;
+        setNonBlocking(s);
+        sockaddr_in addr = probe_policy_detail::toSockaddr(t);
+        // Connected, so the kernel reports the peer's port-unreachable on the next recv
+        if (connect(s, (sockaddr*)&addr, sizeof(addr)) != 0 || send(s, "", 0, kSendFlags) < 0) {
+            closeSocket(s);
+            return kInvalidSocket;
+        }
+        return s;
+    }
+
+    static ProbeStatus finish(socket_t s, bool ready, uint16_t /*seq*/, int /*remainingMs*/) {
+        if (!ready) return ProbeStatus::Timeout;
+        char buf[1];
+        if (recv(s, buf, sizeof(buf), 0) >= 0) return ProbeStatus::Open;
+        return probe_policy_detail::refused(probe_policy_detail::lastError()) ? ProbeStatus::Closed : ProbeStatus::Error;
+    }
+};
+
+// Host liveness; the target's port is ignored
+struct IcmpTransport {
+    static constexpr bool kStream = false;
+    static constexpr bool kWaitWritable = false;
+
+    static socket_t start(const ProbeTarget& t, uint16_t seq) {
+        netInitOnce();
+#ifdef __linux__
+        socket_t s = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);    // Unprivileged ping socket
+#else
+        socket_t s = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+#endif
+        if (s == kInvalidSocket) return s;
+        setNonBlocking(s);
+        uint8_t echo[8] = { 8, 0, 0, 0, 0x50, 0x52, (uint8_t)(seq >> 8), (uint8_t)seq };  // Type 8, id "PR"
+        uint16_t sum = probe_policy_detail::inetChecksum(echo, sizeof(echo));
+        std::memcpy(echo + 2, &sum, 2);
+        sockaddr_in addr = probe_policy_detail::toSockaddr(t);
+        addr.sin_port = 0;
+        if (sendto(s, (const char*)echo, sizeof(echo), 0, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            closeSocket(s);
+            return kInvalidSocket;
+        }
+        return s;
+    }
+
+    // Reads until this probe's own echo reply (or an unreachable quoting its request) or the
+    // deadline: a raw socket also sees every other ICMP packet addressed to this host
+    static ProbeStatus finish(socket_t s, bool ready, uint16_t seq, int remainingMs) {
+        using Clock = std::chrono::steady_clock;
+        const auto deadline = Clock::now() + std::chrono::milliseconds(remainingMs);
+        while (ready) {
+            uint8_t buf[128];
+            int n = (int)recv(s, (char*)buf, sizeof(buf), 0);
+            if (n < 0 && !wouldBlock()) return ProbeStatus::Error;
+            ProbeStatus status;
+            if (n > 0 && answers(buf, n, seq, status)) return status;
+            int leftMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (leftMs <= 0) break;
+            ready = waitSocket(s, false, leftMs);
+        }
+        return ProbeStatus::Timeout;
+    }
+
+private:
+    // Raw sockets hand back the IP header too; null if the packet is too short
+    static const uint8_t* icmpHeader(const uint8_t* p, int n) {
+        int ihl = (p[0] >> 4) == 4 ? (p[0] & 0x0F) * 4 : 0;
+        return n >= ihl + 8 ? p + ihl : nullptr;
+    }
+
+    // Id and sequence of an echo; a Linux ping socket rewrites the id, so only raw sockets check it
+    static bool ours(const uint8_t* echo, bool raw, uint16_t seq) {
+        if (raw && (echo[4] != 0x50 || echo[5] != 0x52)) return false;
+        return echo[6] == (uint8_t)(seq >> 8) && echo[7] == (uint8_t)seq;
+    }
+
+    static bool answers(const uint8_t* buf, int n, uint16_t seq, ProbeStatus& status) {
+        const uint8_t* icmp = icmpHeader(buf, n);
+        if (!icmp) return false;
+        const bool raw = icmp != buf;
+        if (icmp[0] == 0) {                 // Echo reply
+            status = ProbeStatus::Open;
+            return ours(icmp, raw, seq);
+        }
+        if (icmp[0] != 3) return false;     // 3 = destination unreachable, quoting the request
+        const uint8_t* quoted = icmpHeader(icmp + 8, n - (int)(icmp + 8 - buf));
+        status = ProbeStatus::Closed;
+        return quoted && quoted[0] == 8 && ours(quoted, raw, seq);
+    }
+};
+
+// ---------- COMPLETION CHECKS ----------
+// Run on a connected stream socket with the rest of the probe's time budget
+
+struct ConnectOnly {
+    static ProbeStatus complete(socket_t /*s*/, int /*remainingMs*/) { return ProbeStatus::Open; }
+};
+
+struct BannerCheck {
+    static ProbeStatus complete(socket_t s, int remainingMs) {
+        if (!waitSocket(s, false, remainingMs)) return ProbeStatus::Timeout;
+        char buf[64];
+        return recv(s, buf, sizeof(buf), 0) > 0 ? ProbeStatus::Open : ProbeStatus::Error;
+    }
+};
+
+struct HttpHeadCheck {
+    static ProbeStatus complete(socket_t s, int remainingMs) {
+        static const char kRequest[] = "HEAD / HTTP/1.0\r\n\r\n";
+        if (send(s, kRequest, sizeof(kRequest) - 1, kSendFlags) != (int)sizeof(kRequest) - 1) return ProbeStatus::Error;
+        // "HTTP/1.x 2xx" / "3xx"; the status line may arrive over several reads
+        using Clock = std::chrono::steady_clock;
+        const auto deadline = Clock::now() + std::chrono::milliseconds(remainingMs);
+        char buf[16];
+        int have = 0;
+        while (have < 12) {
+            int leftMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (leftMs <= 0 || !waitSocket(s, false, leftMs)) return ProbeStatus::Timeout;
+            int n = (int)recv(s, buf + have, (int)sizeof(buf) - have, 0);
+            if (n < 0 && wouldBlock()) continue;
+            if (n <= 0) return ProbeStatus::Error;
+            have += n;
+        }
+        if (std::memcmp(buf, "HTTP/", 5) != 0) return ProbeStatus::Error;
+        return (buf[9] == '2' || buf[9] == '3') ? ProbeStatus::Open : ProbeStatus::Error;
+    }
+};
+
+// ---------- TIMEOUT STRATEGIES ----------
+
+class FixedTimeout {
+public:
+    explicit FixedTimeout(int timeoutMs = 500) : timeoutMs_(timeoutMs) {}
+    int budgetMs() const { return timeoutMs_; }
+    void observe(ProbeStatus, float) {}
+
+private:
+    int timeoutMs_;
+};
+
+// RFC 6298-style retransmission timer over answered probes (Open / Closed); starts at maxMs
+class AdaptiveTimeout {
+public:
+    explicit AdaptiveTimeout(int minMs = 20, int maxMs = 500) : minMs_(minMs), maxMs_(maxMs), rtoMs_(maxMs) {}
+
+    int budgetMs() const { return (int)rtoMs_; }
+
+    void observe(ProbeStatus status, float rttMs) {
+        if (status == ProbeStatus::Timeout) {
+            rtoMs_ = clamp(rtoMs_ * 2.0);
+            return;
+        }
+        if (status != ProbeStatus::Open && status != ProbeStatus::Closed) return;
+        if (srttMs_ < 0.0) {
+            srttMs_ = rttMs;
+            rttVarMs_ = rttMs / 2.0;
+        }
+        else {
+            rttVarMs_ = 0.75 * rttVarMs_ + 0.25 * (srttMs_ > rttMs ? srttMs_ - rttMs : rttMs - srttMs_);
+            srttMs_ = 0.875 * srttMs_ + 0.125 * rttMs;
+        }
+        rtoMs_ = clamp(srttMs_ + 4.0 * rttVarMs_);
+    }
+
+private:
+    double clamp(double ms) const { return ms < minMs_ ? minMs_ : (ms > maxMs_ ? maxMs_ : ms); }
+
+    int minMs_;
+    int maxMs_;
+    double rtoMs_;
+    double srttMs_ = -1.0;
+    double rttVarMs_ = 0.0;
+};
+
+// ---------- INSTRUMENTATION ----------
+
+struct NoInstrumentation {
+    void begin() {}
+    void phase(TracePhase) {}
+    void end(ProbeStatus, float) {}
+};
+
+struct ProbeCounts {
+    uint64_t byStatus[4] = {};      // Indexed by ProbeStatus
+    double rttSumMs = 0.0;
+};
+
+class TraceInstrumentation {
+public:
+    void begin() {
+#ifdef PROBE_TRACE
+        id_ = traceNextProbeId();
+        mark_ = traceTicks();
+#endif
+    }
+    void phase(TracePhase p) {
+#ifdef PROBE_TRACE
+        uint64_t now = traceTicks();
+        traceRecord(p, id_, mark_, now);
+        mark_ = now;
+#else
+        (void)p;
+#endif
+    }
+    void end(ProbeStatus status, float rttMs) {
+        counts_.byStatus[(int)status]++;
+        counts_.rttSumMs += rttMs;
+    }
+    const ProbeCounts& counts() const { return counts_; }
+
+private:
+    ProbeCounts counts_;
+#ifdef PROBE_TRACE
+    uint64_t id_ = 0;
+    uint64_t mark_ = 0;
+#endif
+};
+
+// ---------- PROBE CORE ----------
+template <typename Transport, typename Check, typename Timeout, typename Instrument>
+class BasicProbe {
+    static_assert(Transport::kStream || std::is_same<Check, ConnectOnly>::value,
+        "banner / HTTP completion checks need a stream transport");
+
+public:
+    explicit BasicProbe(Timeout timeout = Timeout(), Instrument instrument = Instrument())
+        : timeout_(timeout), instrument_(instrument) {}
+
+    ProbeResult probe(const ProbeTarget& target) {
+        using Clock = std::chrono::steady_clock;
+        ProbeResult res;
+        res.target = target;
+        const int budgetMs = timeout_.budgetMs();
+        const auto start = Clock::now();
+        const uint16_t seq = ++seq_;
+
+        instrument_.begin();
+        socket_t s = Transport::start(target, seq);
+        instrument_.phase(TracePhase::Connect);
+        if (s == kInvalidSocket) {
+            res.status = ProbeStatus::Error;
+        }
+        else {
+            bool ready = waitSocket(s, Transport::kWaitWritable, budgetMs);
+            instrument_.phase(TracePhase::Wait);
+            res.status = Transport::finish(s, ready, seq, budgetMs - (int)elapsedMs(start));
+            instrument_.phase(TracePhase::SockOpt);
+            if constexpr (!std::is_same<Check, ConnectOnly>::value) {
+                if (res.status == ProbeStatus::Open) res.status = Check::complete(s, budgetMs - (int)elapsedMs(start));
+            }
+            closeSocket(s);
+            instrument_.phase(TracePhase::Close);
+        }
+        res.rttMs = (float)elapsedMs(start);
+        timeout_.observe(res.status, res.rttMs);
+        instrument_.end(res.status, res.rttMs);
+        return res;
+    }
+
+    // The specialized hot loop: one probe after another, no per-probe indirection
+    template <typename OnResult>
+    void run(const ProbeTarget* targets, size_t count, OnResult&& onResult) {
+        for (size_t i = 0; i < count; i++) {
+            ProbeResult res = probe(targets[i]);
+            res.index = i;
+            onResult(res);
+        }
+    }
+
+    const Timeout& timeout() const { return timeout_; }
+    const Instrument& instrument() const { return instrument_; }
+
+private:
+    Timeout timeout_;
+    Instrument instrument_;
+    uint16_t seq_ = 0;
+};
+
+// ---------- RUNTIME SELECTION ----------
+enum class ProbeTransport : uint8_t { Tcp, Udp, Icmp };
+enum class ProbeCompletion : uint8_t { Connect, Banner, HttpHead };
+
+struct ProbeVariant {
+    ProbeTransport transport = ProbeTransport::Tcp;
+    ProbeCompletion completion = ProbeCompletion::Connect;
+    bool adaptiveTimeout = false;
+    bool instrumented = false;
+    int timeoutMs = 500;            // Fixed budget, or the adaptive ceiling
+    int minTimeoutMs = 20;          // Adaptive floor
+};
+
+const char* probeTransportName(ProbeTransport transport);
+const char* probeCompletionName(ProbeCompletion completion);
+bool parseProbeTransport(const std::string& name, ProbeTransport& out);
+bool parseProbeCompletion(const std::string& name, ProbeCompletion& out);
+// "tcp/banner/adaptive/traced"
+std::string describeProbeVariant(const ProbeVariant& variant);
+
+// A chosen BasicProbe instantiation behind one virtual call per batch
+class ProbeRunner {
+public:
+    virtual ~ProbeRunner() = default;
+
+    virtual void run(const ProbeTarget* targets, size_t count, const std::function<void(const ProbeResult&)>& onResult) = 0;
+    virtual int timeoutMs() const = 0;          // Budget the next probe will get
+    virtual const ProbeCounts* counts() const = 0;  // Null without instrumentation
+
+    ProbeResult probe(const ProbeTarget& target) {
+        ProbeResult res;
+        run(&target, 1, [&](const ProbeResult& r) { res = r; });
+        return res;
+    }
+};
+
+// Null (and 'error' set) for combinations that cannot exist, e.g. a banner check over UDP
+std::unique_ptr<ProbeRunner> makeProbeRunner(const ProbeVariant& variant, std::string& error);
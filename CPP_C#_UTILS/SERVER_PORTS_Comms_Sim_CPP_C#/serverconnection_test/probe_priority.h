@@ -0,0 +1,180 @@
+/*
+ * Probe Priority Classes
+ * Author: Alushi
+ * Description:
+ *   - Every probe submission belongs to a class, most urgent first:
+ *       critical    - monitored targets marked priority=critical (target_config.h)
+ *       monitor     - other monitored targets, watches, housekeeping
+ *       interactive - on-demand tests from the REPL and the control socket
+ *       bulk        - range scans
+ *   - ClassQueues<T> holds one FIFO per class and decides which class is served next:
+ *       Strict   - always the most urgent non-empty class; bulk only runs when nothing else waits
+ *       Weighted - smooth weighted round robin (weights 16 / 8 / 4 / 1 by default), so lower
+ *                  classes keep a guaranteed share instead of starving under sustained load
+ *     A caller can also hold classes back per pop (the job runner keeps bulk off its last
+ *     free worker that way).
+ *   - Queue delay per class (enqueue or due time -> dequeue): count, mean, max and a p99 read
+ *     from log2 microsecond buckets.
+ *   - Not synchronized; owners call it under their own lock.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <utility>
+
+enum class ProbeClass : uint8_t { Critical = 0, Monitor = 1, Interactive = 2, Bulk = 3 };
+
+const size_t kProbeClasses = 4;
+
+inline const char* probeClassName(ProbeClass cls) {
+    static const char* names[kProbeClasses] = { "critical", "monitor", "interactive", "bulk" };
+    return names[(size_t)cls];
+}
+
+inline bool parseProbeClass(const std::string& s, ProbeClass& out) {
+    for (size_t i = 0; i < kProbeClasses; i++) {
+        if (s == probeClassName((ProbeClass)i)) {
+            out = (ProbeClass)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+enum class DispatchPolicy : uint8_t { Strict, Weighted };
+
+inline const char* dispatchPolicyName(DispatchPolicy policy) {
+    return policy == DispatchPolicy::Strict ? "strict" : "weighted";
+}
+
+inline bool parseDispatchPolicy(const std::string& s, DispatchPolicy& out) {
+    if (s == "strict") out = DispatchPolicy::Strict;
+    else if (s == "weighted") out = DispatchPolicy::Weighted;
+    else return false;
+    return true;
+}
+
+struct ClassQueueStats {
+    size_t queued = 0;
+    uint64_t dequeued = 0;
+    double avgDelayMs = 0.0;
+    double p99DelayMs = 0.0;        // Upper edge of the bucket holding the 99th percentile
+    double maxDelayMs = 0.0;
+};
+
+template <typename T>
+class ClassQueues {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ClassQueues(DispatchPolicy policy = DispatchPolicy::Strict, const int* weights = nullptr) : policy_(policy) {
+        static const int defaults[kProbeClasses] = { 16, 8, 4, 1 };
+        for (size_t i = 0; i < kProbeClasses; i++) weight_[i] = std::max(1, (weights ? weights : defaults)[i]);
+    }
+
+    // 'since' is when the item became runnable; its queue delay is measured from there
+    void push(ProbeClass cls, T item, Clock::time_point since) {
+        queues_[(size_t)cls].emplace_back(std::move(item), since);
+    }
+
+    // Next item by the dispatch policy, among the classes whose bit is set in 'allowed'
+    bool pop(T& out, ProbeClass* cls = nullptr, unsigned allowed = 0xF, Clock::time_point now = Clock::now()) {
+        int pick = -1;
+        if (policy_ == DispatchPolicy::Strict) {
+            for (size_t i = 0; i < kProbeClasses && pick < 0; i++)
+                if ((allowed >> i & 1) && !queues_[i].empty()) pick = (int)i;
+        }
+        else {
+            // Smooth weighted round robin: every eligible class earns its weight, the richest
+            // one is served and pays back the total
+            int total = 0;
+            for (size_t i = 0; i < kProbeClasses; i++) {
+                if (!(allowed >> i & 1) || queues_[i].empty()) continue;
+                credit_[i] += weight_[i];
+                total += weight_[i];
+                if (pick < 0 || credit_[i] > credit_[pick]) pick = (int)i;
+            }
+            if (pick >= 0) credit_[pick] -= total;
+        }
+        if (pick < 0) return false;
+
+        auto& q = queues_[pick];
+        out = std::move(q.front().first);
+        recordDelay((size_t)pick, now - q.front().second);
+        q.pop_front();
+        if (q.empty()) credit_[pick] = 0;       // An idle class does not bank credit
+        if (cls) *cls = (ProbeClass)pick;
+        return true;
+    }
+
+    bool empty(unsigned allowed = 0xF) const {
+        for (size_t i = 0; i < kProbeClasses; i++)
+            if ((allowed >> i & 1) && !queues_[i].empty()) return false;
+        return true;
+    }
+
+    size_t size(ProbeClass cls) const { return queues_[(size_t)cls].size(); }
+    DispatchPolicy policy() const { return policy_; }
+
+    ClassQueueStats stats(ProbeClass cls) const {
+        const Delay& d = delay_[(size_t)cls];
+        ClassQueueStats s;
+        s.queued = queues_[(size_t)cls].size();
+        s.dequeued = d.count;
+        if (!d.count) return s;
+        s.avgDelayMs = d.sumUs / d.count / 1000.0;
+        s.maxDelayMs = d.maxUs / 1000.0;
+        uint64_t seen = 0, rank = d.count - d.count / 100;
+        for (size_t b = 0; b < kDelayBuckets; b++) {
+            seen += d.buckets[b];
+            if (seen >= rank) {
+                s.p99DelayMs = std::min(s.maxDelayMs, (double)(1ull << b) / 1000.0);
+                break;
+            }
+        }
+        return s;
+    }
+
+    // "critical: 0 queued, 120 dequeued, delay avg 0.02 / p99 0.06 / max 0.3 ms"
+    std::string describe(ProbeClass cls) const {
+        ClassQueueStats s = stats(cls);
+        char line[160];
+        std::snprintf(line, sizeof(line), "%s: %zu queued, %llu dequeued, delay avg %.2f / p99 %.2f / max %.2f ms",
+            probeClassName(cls), s.queued, (unsigned long long)s.dequeued, s.avgDelayMs, s.p99DelayMs, s.maxDelayMs);
+        return line;
+    }
+
+private:
+    static const size_t kDelayBuckets = 40;     // Bucket b: below 2^b us
+
+    struct Delay {
+        uint64_t count = 0;
+        double sumUs = 0.0;
+        double maxUs = 0.0;
+        uint64_t buckets[kDelayBuckets] = {};
+    };
+
+    void recordDelay(size_t cls, Clock::duration waited) {
+        double us = std::max(0.0, std::chrono::duration<double, std::micro>(waited).count());
+        Delay& d = delay_[cls];
+        d.count++;
+        d.sumUs += us;
+        d.maxUs = std::max(d.maxUs, us);
+        size_t b = 0;
+        while (b + 1 < kDelayBuckets && (double)(1ull << b) <= us) b++;
+        d.buckets[b]++;
+    }
+
+    DispatchPolicy policy_;
+    int weight_[kProbeClasses];
+    int credit_[kProbeClasses] = {};
+    std::deque<std::pair<T, Clock::time_point>> queues_[kProbeClasses];
+    Delay delay_[kProbeClasses];
+};
@@ -0,0 +1,216 @@
+/*
+ * Probe Hot-Path Tracing
+ * Author: Alushi
+ * Description:
+ *   - See probe_trace.h. Empty translation unit unless PROBE_TRACE is defined.
+ */
+
+#include "probe_trace.h"
+
+#ifdef PROBE_TRACE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Log-linear buckets: 4 sub-buckets per power of two, so percentiles are within 25%
+const int kBuckets = 256;
+const size_t kMaxEvents = 200000;
+const int kPhases = (int)TracePhase::Count;
+
+struct PhaseHistogram {
+    std::atomic<uint64_t> buckets[kBuckets];
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<uint64_t> sumTicks{ 0 };
+    std::atomic<uint64_t> maxTicks{ 0 };
+
+    PhaseHistogram() {
+        for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+    }
+};
+
+struct TraceEvent {
+    uint64_t start;
+    uint64_t end;
+    uint64_t probeId;
+    uint32_t tid;
+    TracePhase phase;
+};
+
+PhaseHistogram histograms[kPhases];
+std::atomic<uint64_t> nextProbeId{ 1 };
+std::atomic<uint64_t> loopCounter{ 0 };
+std::atomic<uint32_t> sampleEvery{ 64 };
+std::atomic<uint32_t> nextTid{ 1 };
+
+std::mutex eventsMutex;
+std::vector<TraceEvent> events;
+uint64_t droppedEvents = 0;
+
+int highestBit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse64(&idx, v);
+    return (int)idx;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+int bucketOf(uint64_t ticks) {
+    if (ticks < 4) return (int)ticks;
+    int msb = highestBit(ticks);
+    int sub = (int)((ticks >> (msb - 2)) & 3);
+    return msb * 4 + sub - 4;
+}
+
+// Exclusive upper bound of a bucket, in ticks
+uint64_t bucketLimit(int idx) {
+    if (idx < 4) return (uint64_t)idx + 1;
+    int msb = (idx + 4) / 4;
+    int sub = (idx + 4) % 4;
+    return (uint64_t)(4 + sub + 1) << (msb - 2);
+}
+
+// Measured once against steady_clock; the TSC is invariant on anything we run on
+double ticksPerUs() {
+    static const double rate = []() {
+        using Clock = std::chrono::steady_clock;
+        auto t0 = Clock::now();
+        uint64_t c0 = traceTicks();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t c1 = traceTicks();
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+        return (c1 - c0) / us;
+    }();
+    return rate;
+}
+
+uint32_t threadTraceId() {
+    thread_local uint32_t tid = nextTid.fetch_add(1, std::memory_order_relaxed);
+    return tid;
+}
+
+uint64_t percentileTicks(const PhaseHistogram& h, double p) {
+    uint64_t total = h.count.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(p * total), seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += h.buckets[i].load(std::memory_order_relaxed);
+        if (seen > rank) return std::min(bucketLimit(i), h.maxTicks.load(std::memory_order_relaxed));
+    }
+    return h.maxTicks.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+const char* tracePhaseName(TracePhase phase) {
+    switch (phase) {
+    case TracePhase::Socket: return "socket";
+    case TracePhase::Connect: return "connect";
+    case TracePhase::Wait: return "wait";
+    case TracePhase::SockOpt: return "getsockopt";
+    case TracePhase::Close: return "close";
+    case TracePhase::Count: break;
+    }
+    return "?";
+}
+
+uint64_t traceNextProbeId() {
+    return nextProbeId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void traceRecord(TracePhase phase, uint64_t probeId, uint64_t startTicks, uint64_t endTicks) {
+    uint64_t ticks = endTicks > startTicks ? endTicks - startTicks : 0;
+    PhaseHistogram& h = histograms[(int)phase];
+    h.buckets[bucketOf(ticks)].fetch_add(1, std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    h.sumTicks.fetch_add(ticks, std::memory_order_relaxed);
+    uint64_t prevMax = h.maxTicks.load(std::memory_order_relaxed);
+    while (ticks > prevMax && !h.maxTicks.compare_exchange_weak(prevMax, ticks, std::memory_order_relaxed)) {}
+
+    uint32_t every = sampleEvery.load(std::memory_order_relaxed);
+    if (every == 0) return;
+    uint64_t key = probeId ? probeId : loopCounter.fetch_add(1, std::memory_order_relaxed);
+    if (key % every != 0) return;
+
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    if (events.size() >= kMaxEvents) {
+        droppedEvents++;
+        return;
+    }
+    events.push_back({ startTicks, endTicks, probeId, threadTraceId(), phase });
+}
+
+void traceSetSampleEvery(uint32_t n) {
+    sampleEvery.store(n, std::memory_order_relaxed);
+}
+
+void tracePrintStats(std::ostream& out) {
+    const double perUs = ticksPerUs();
+    out << "[TRACE] per-phase latency in us (clock " << std::fixed << std::setprecision(0) << perUs
+        << " ticks/us, sampling 1/" << sampleEvery.load() << ")\n"
+        << "  phase          count       avg       p50       p99       max\n";
+    for (int p = 0; p < kPhases; p++) {
+        const PhaseHistogram& h = histograms[p];
+        uint64_t n = h.count.load(std::memory_order_relaxed);
+        double avg = n ? h.sumTicks.load(std::memory_order_relaxed) / perUs / n : 0.0;
+        out << "  " << std::left << std::setw(10) << tracePhaseName((TracePhase)p) << std::right
+            << std::setw(10) << n << std::setprecision(2)
+            << std::setw(10) << avg
+            << std::setw(10) << percentileTicks(h, 0.50) / perUs
+            << std::setw(10) << percentileTicks(h, 0.99) / perUs
+            << std::setw(10) << h.maxTicks.load(std::memory_order_relaxed) / perUs << "\n";
+    }
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    out << "  trace events " << events.size() << " (dropped " << droppedEvents << ")\n";
+    out << std::defaultfloat;
+}
+
+bool traceExportChrome(const std::string& path) {
+    std::vector<TraceEvent> copy;
+    {
+        std::lock_guard<std::mutex> lock(eventsMutex);
+        copy = events;
+    }
+    std::ofstream out(path);
+    if (!out) return false;
+
+    const double perUs = ticksPerUs();
+    uint64_t base = copy.empty() ? 0 : copy.front().start;
+    for (const TraceEvent& e : copy) base = std::min(base, e.start);
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < copy.size(); i++) {
+        const TraceEvent& e = copy[i];
+        out << "{\"name\":\"" << tracePhaseName(e.phase) << "\",\"cat\":\"probe\",\"ph\":\"X\""
+            << ",\"ts\":" << (e.start - base) / perUs
+            << ",\"dur\":" << (e.end > e.start ? e.end - e.start : 0) / perUs
+            << ",\"pid\":1,\"tid\":" << e.tid
+            << ",\"args\":{\"probe\":" << e.probeId << "}}" << (i + 1 < copy.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+    return (bool)out;
+}
+
+void traceReset() {
+    for (PhaseHistogram& h : histograms) {
+        for (auto& b : h.buckets) b.store(0, std::memory_order_relaxed);
+        h.count.store(0, std::memory_order_relaxed);
+        h.sumTicks.store(0, std::memory_order_relaxed);
+        h.maxTicks.store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    events.clear();
+    droppedEvents = 0;
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Probe Hot-Path Tracing
+ * Author: Alushi
+ * Description:
+ *   - Per-phase timestamps for connect probes: socket(), connect(), the select/epoll wait,
+ *     getsockopt(SO_ERROR) and close().
+ *   - Timed with the TSC where available (one rdtsc per phase boundary), aggregated into
+ *     per-phase log-linear histograms with relaxed atomics.
+ *   - Every Nth probe is also kept as trace events, exportable as Chrome trace JSON
+ *     (load in chrome://tracing or Perfetto).
+ *   - Only built with PROBE_TRACE defined; otherwise every PROBE_TRACE_* macro expands to
+ *     nothing and its arguments are never evaluated.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+enum class TracePhase : uint8_t { Socket, Connect, Wait, SockOpt, Close, Count };
+
+#ifdef PROBE_TRACE
+
+#include <ostream>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+inline uint64_t traceTicks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+const char* tracePhaseName(TracePhase phase);
+
+// Probe ids start at 1; id 0 marks engine-loop phases (the shared wait) that belong to no probe
+uint64_t traceNextProbeId();
+
+// Adds one phase sample to the histogram and, if the probe is sampled, to the trace buffer
+void traceRecord(TracePhase phase, uint64_t probeId, uint64_t startTicks, uint64_t endTicks);
+
+// Keep trace events for one probe in every n (0 = histograms only). Default 64.
+void traceSetSampleEvery(uint32_t n);
+
+void tracePrintStats(std::ostream& out);
+bool traceExportChrome(const std::string& path);
+void traceReset();
+
+#define PROBE_TRACE_ID(var) const uint64_t var = traceNextProbeId()
+#define PROBE_TRACE_MARK(var) uint64_t var = traceTicks()
+// Records [mark, now) as 'phase' and moves the mark to now, so consecutive steps tile the probe
+#define PROBE_TRACE_STEP(phase, probeId, var) \
+    do { uint64_t traceNow_ = traceTicks(); traceRecord(TracePhase::phase, probeId, var, traceNow_); var = traceNow_; } while (0)
+
+#else
+
+#define PROBE_TRACE_ID(var)
+#define PROBE_TRACE_MARK(var)
+#define PROBE_TRACE_STEP(phase, probeId, var) ((void)0)
+
+#endif
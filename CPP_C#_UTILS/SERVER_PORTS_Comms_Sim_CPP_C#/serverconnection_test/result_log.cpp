@@ -0,0 +1,407 @@
+/*
+ * Binary Result Log
+ * Author: Alushi
+ * Description:
+ *   - See result_log.h.
+ */
+
+#include "result_log.h"
+
+#include <chrono>
+#include <climits>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+uint32_t fnv1a(const uint8_t* p, size_t n, uint32_t h = 2166136261u) {
+    for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+void putVarint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool seekTo(FILE* f, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+bool truncateTo(FILE* f, uint64_t size) {
+#ifdef _WIN32
+    return _chsize_s(_fileno(f), (long long)size) == 0;
+#else
+    return ftruncate(fileno(f), (off_t)size) == 0;
+#endif
+}
+
+} // namespace
+
+// ---------- READER ----------
+bool ResultLogReader::open(const std::string& path) {
+    close();
+    if (!file_.open(path) || file_.size() < sizeof(ResultLogFileHeader)) {
+        close();
+        return false;
+    }
+    base_ = file_.data();
+    bytes_ = file_.size();
+
+    ResultLogFileHeader fh;
+    std::memcpy(&fh, base_, sizeof(fh));
+    if (fh.magic != kResultLogMagic || fh.version != kResultLogVersion || fh.headerSize < sizeof(fh)) {
+        close();
+        return false;
+    }
+
+    if (!loadFooter()) walkBlocks();
+    for (uint32_t id = 0; id < targets_.size(); id++) targetIds_[targets_[id]] = id;
+    for (const auto& e : index_) records_ += e.records;
+    return true;
+}
+
+void ResultLogReader::close() {
+    file_.close();
+    base_ = nullptr;
+    bytes_ = 0;
+    index_.clear();
+    targets_.clear();
+    targetIds_.clear();
+    records_ = 0;
+    dataEnd_ = 0;
+    recovered_ = false;
+}
+
+bool ResultLogReader::loadFooter() {
+    if (bytes_ < sizeof(ResultLogFileHeader) + sizeof(ResultLogTrailer)) return false;
+    ResultLogTrailer t;
+    std::memcpy(&t, base_ + bytes_ - sizeof(t), sizeof(t));
+    if (t.magic != kResultLogIndexMagic || t.version != kResultLogVersion) return false;
+    uint64_t footerBytes = (uint64_t)t.blocks * sizeof(ResultLogIndexEntry) + (uint64_t)t.targets * 4 + sizeof(t);
+    if (t.indexOffset < sizeof(ResultLogFileHeader) || t.indexOffset + footerBytes != bytes_) return false;
+
+    index_.resize(t.blocks);
+    if (t.blocks) std::memcpy(index_.data(), base_ + t.indexOffset, t.blocks * sizeof(ResultLogIndexEntry));
+    targets_.resize(t.targets);
+    if (t.targets) std::memcpy(targets_.data(), base_ + t.indexOffset + t.blocks * sizeof(ResultLogIndexEntry), t.targets * 4);
+    dataEnd_ = t.indexOffset;
+    return true;
+}
+
+// No usable footer: rebuild the index from the block headers, stopping at the first
+// block that is cut short or fails its checksum (the tail of a crashed writer)
+void ResultLogReader::walkBlocks() {
+    recovered_ = true;
+    index_.clear();
+    targets_.clear();
+    uint64_t offset = ((const ResultLogFileHeader*)base_)->headerSize;
+    while (offset + sizeof(ResultLogBlockHeader) <= bytes_) {
+        ResultLogBlockHeader h;
+        std::memcpy(&h, base_ + offset, sizeof(h));
+        uint64_t tail = (uint64_t)h.newTargets * 4 + h.payloadBytes;
+        if (h.magic != kResultLogBlockMagic || h.firstNewTarget != targets_.size()
+            || offset + sizeof(h) + tail > bytes_
+            || fnv1a(base_ + offset + sizeof(h), (size_t)tail) != h.checksum)
+            break;
+
+        size_t first = targets_.size();
+        targets_.resize(first + h.newTargets);
+        if (h.newTargets) std::memcpy(&targets_[first], base_ + offset + sizeof(h), h.newTargets * 4);
+
+        ResultLogIndexEntry e{};
+        e.offset = offset;
+        e.minUnixMs = h.minUnixMs;
+        e.maxUnixMs = h.maxUnixMs;
+        e.targetMask = h.targetMask;
+        e.minTarget = h.minTarget;
+        e.maxTarget = h.maxTarget;
+        e.records = h.records;
+        index_.push_back(e);
+        offset += sizeof(h) + tail;
+    }
+    dataEnd_ = offset;
+}
+
+bool ResultLogReader::decodeBlock(uint64_t offset, ResultLogBlockHeader& h, std::vector<ResultLogRecord>& out) const {
+    if (offset + sizeof(h) > dataEnd_) return false;
+    std::memcpy(&h, base_ + offset, sizeof(h));     // Blocks are not aligned in the file
+    uint64_t tail = (uint64_t)h.newTargets * 4 + h.payloadBytes;
+    if (h.magic != kResultLogBlockMagic || offset + sizeof(h) + tail > dataEnd_) return false;
+
+    const uint8_t* p = base_ + offset + sizeof(h) + (size_t)h.newTargets * 4;
+    const uint8_t* end = p + h.payloadBytes;
+    out.resize(h.records);
+    uint32_t target = 0, port = 0;
+    int32_t ts = 0;
+    for (uint32_t i = 0; i < h.records; i++) {
+        uint32_t dTarget, dPort, dTs, rtt;
+        if (!getVarint(p, end, dTarget) || !getVarint(p, end, dPort) || !getVarint(p, end, dTs) || p >= end)
+            return false;
+        uint8_t status = *p++;
+        if (!getVarint(p, end, rtt)) return false;
+        target += (uint32_t)unzigzag(dTarget);
+        port += (uint32_t)unzigzag(dPort);
+        ts += unzigzag(dTs);
+        ResultLogRecord& r = out[i];
+        r.target = target;
+        r.port = (uint16_t)port;
+        r.status = status;
+        r.reserved = 0;
+        r.tsDeltaMs = ts;
+        r.rttUs = rtt;
+    }
+    return true;
+}
+
+uint64_t ResultLogReader::query(const ResultLogQuery& q, const std::function<void(const ResultLogEntry&)>& onEntry) const {
+    blocksDecoded_ = 0;
+    if (!base_) return 0;
+
+    uint32_t id = 0;
+    if (q.addr) {
+        auto it = targetIds_.find(q.addr);
+        if (it == targetIds_.end()) return 0;
+        id = it->second;
+    }
+
+    std::vector<ResultLogRecord> records;
+    uint64_t matches = 0;
+    for (const auto& e : index_) {
+        if (e.maxUnixMs < q.fromUnixMs || e.minUnixMs > q.toUnixMs) continue;
+        if (q.addr && (id < e.minTarget || id > e.maxTarget || !(e.targetMask & (1ull << (id % 64))))) continue;
+
+        ResultLogBlockHeader h;
+        if (!decodeBlock(e.offset, h, records)) continue;
+        blocksDecoded_++;
+
+        for (const auto& r : records) {
+            if (q.addr && r.target != id) continue;
+            if (q.port && r.port != q.port) continue;
+            int64_t ts = h.baseUnixMs + r.tsDeltaMs;
+            if (ts < q.fromUnixMs || ts > q.toUnixMs || r.target >= targets_.size()) continue;
+            ResultLogEntry out;
+            out.addr = targets_[r.target];
+            out.port = r.port;
+            out.status = (ProbeStatus)r.status;
+            out.rttMs = r.rttUs / 1000.0f;
+            out.unixMs = ts;
+            onEntry(out);
+            matches++;
+        }
+    }
+    return matches;
+}
+
+// ---------- WRITER ----------
+ResultLogWriter::ResultLogWriter(uint32_t blockRecords, int64_t maxBlockAgeMs)
+    : blockRecords_(blockRecords ? blockRecords : 1),
+      maxBlockAgeMs_(maxBlockAgeMs > 0 && maxBlockAgeMs < INT_MAX ? maxBlockAgeMs : INT_MAX) {}
+
+bool ResultLogWriter::open(const std::string& path) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint64_t keep = 0;
+    {
+        ResultLogReader existing;
+        if (existing.open(path)) {
+            index_ = existing.index();
+            targets_ = existing.targets();
+            keep = existing.dataEnd();
+        }
+    }
+    for (uint32_t id = 0; id < targets_.size(); id++) targetIds_[targets_[id]] = id;
+    blockFirstNewTarget_ = (uint32_t)targets_.size();
+
+    if (keep) {
+        // Continue after the last intact block; the old footer is rewritten on close()
+        file_ = std::fopen(path.c_str(), "r+b");
+        if (!file_ || !truncateTo(file_, keep) || !seekTo(file_, keep)) {
+            if (file_) std::fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+        offset_ = keep;
+        return true;
+    }
+
+    // Missing, empty or unreadable: refuse to overwrite anything that is not empty
+    FILE* probe = std::fopen(path.c_str(), "rb");
+    if (probe) {
+        bool empty = std::fgetc(probe) == EOF;
+        std::fclose(probe);
+        if (!empty) return false;
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+
+    ResultLogFileHeader fh{};
+    fh.magic = kResultLogMagic;
+    fh.version = kResultLogVersion;
+    fh.headerSize = sizeof(fh);
+    fh.createdUnixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::fwrite(&fh, sizeof(fh), 1, file_);
+    std::fflush(file_);
+    offset_ = sizeof(fh);
+    return true;
+}
+
+bool ResultLogWriter::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_ != nullptr;
+}
+
+uint64_t ResultLogWriter::records() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_;
+}
+
+void ResultLogWriter::append(uint32_t addr, uint16_t port, ProbeStatus status, float rttMs, int64_t unixMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) return;
+
+    if (!pending_.empty()) {
+        int64_t delta = unixMs - pendingBaseMs_;
+        if (delta >= maxBlockAgeMs_ || delta <= -maxBlockAgeMs_) writeBlock();
+    }
+    if (pending_.empty()) {
+        pendingBaseMs_ = pendingMinMs_ = pendingMaxMs_ = unixMs;
+    }
+
+    uint32_t id;
+    auto it = targetIds_.find(addr);
+    if (it != targetIds_.end()) {
+        id = it->second;
+    }
+    else {
+        id = (uint32_t)targets_.size();
+        targets_.push_back(addr);
+        targetIds_[addr] = id;
+    }
+
+    ResultLogRecord r;
+    r.target = id;
+    r.port = port;
+    r.status = (uint8_t)status;
+    r.reserved = 0;
+    r.tsDeltaMs = (int32_t)(unixMs - pendingBaseMs_);
+    r.rttUs = rttMs > 0.0f ? (uint32_t)(rttMs * 1000.0f + 0.5f) : 0;
+    pending_.push_back(r);
+    if (unixMs < pendingMinMs_) pendingMinMs_ = unixMs;
+    if (unixMs > pendingMaxMs_) pendingMaxMs_ = unixMs;
+    records_++;
+
+    if (pending_.size() >= blockRecords_) writeBlock();
+}
+
+void ResultLogWriter::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) writeBlock();
+}
+
+// Encodes and writes the pending records as one block; caller holds mutex_
+void ResultLogWriter::writeBlock() {
+    if (pending_.empty()) return;
+
+    ResultLogBlockHeader h{};
+    h.magic = kResultLogBlockMagic;
+    h.records = (uint32_t)pending_.size();
+    h.firstNewTarget = blockFirstNewTarget_;
+    h.newTargets = (uint32_t)targets_.size() - blockFirstNewTarget_;
+    h.minTarget = UINT32_MAX;
+    h.baseUnixMs = pendingBaseMs_;
+    h.minUnixMs = pendingMinMs_;
+    h.maxUnixMs = pendingMaxMs_;
+
+    // Column deltas, zigzag + varint: steady monitoring of one target costs ~5-7 bytes a result
+    scratch_.assign((const uint8_t*)(targets_.data() + blockFirstNewTarget_),
+        (const uint8_t*)(targets_.data() + targets_.size()));
+    size_t payloadStart = scratch_.size();
+    uint32_t prevTarget = 0, prevPort = 0;
+    int32_t prevTs = 0;
+    for (const auto& r : pending_) {
+        putVarint(scratch_, zigzag((int32_t)(r.target - prevTarget)));
+        putVarint(scratch_, zigzag((int32_t)(r.port - prevPort)));
+        putVarint(scratch_, zigzag(r.tsDeltaMs - prevTs));
+        scratch_.push_back(r.status);
+        putVarint(scratch_, r.rttUs);
+        prevTarget = r.target;
+        prevPort = r.port;
+        prevTs = r.tsDeltaMs;
+        if (r.target < h.minTarget) h.minTarget = r.target;
+        if (r.target > h.maxTarget) h.maxTarget = r.target;
+        h.targetMask |= 1ull << (r.target % 64);
+    }
+    h.payloadBytes = (uint32_t)(scratch_.size() - payloadStart);
+    h.checksum = fnv1a(scratch_.data(), scratch_.size());
+
+    std::fwrite(&h, sizeof(h), 1, file_);
+    std::fwrite(scratch_.data(), 1, scratch_.size(), file_);
+    std::fflush(file_);     // A crash loses at most the block being filled
+
+    ResultLogIndexEntry e{};
+    e.offset = offset_;
+    e.minUnixMs = h.minUnixMs;
+    e.maxUnixMs = h.maxUnixMs;
+    e.targetMask = h.targetMask;
+    e.minTarget = h.minTarget;
+    e.maxTarget = h.maxTarget;
+    e.records = h.records;
+    index_.push_back(e);
+
+    offset_ += sizeof(h) + scratch_.size();
+    blockFirstNewTarget_ = (uint32_t)targets_.size();
+    pending_.clear();
+}
+
+void ResultLogWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) return;
+    writeBlock();
+
+    ResultLogTrailer t{};
+    t.indexOffset = offset_;
+    t.blocks = (uint32_t)index_.size();
+    t.targets = (uint32_t)targets_.size();
+    t.version = kResultLogVersion;
+    t.magic = kResultLogIndexMagic;
+    if (!index_.empty()) std::fwrite(index_.data(), sizeof(ResultLogIndexEntry), index_.size(), file_);
+    if (!targets_.empty()) std::fwrite(targets_.data(), 4, targets_.size(), file_);
+    std::fwrite(&t, sizeof(t), 1, file_);
+    std::fclose(file_);
+    file_ = nullptr;
+
+    index_.clear();
+    targets_.clear();
+    targetIds_.clear();
+    blockFirstNewTarget_ = 0;
+    records_ = 0;
+    offset_ = 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * Binary Result Log
+ * Author: Alushi
+ * Description:
+ *   - Append-only file of probe results for long-term history (monitor checks, batch runs),
+ *     a fraction of the size of the NDJSON text and far faster to re-read.
+ *   - Layout:
+ *       file header | block | block | ... | index footer | trailer
+ *     Results are buffered as fixed 16-byte records (target id, port, timestamp delta, status,
+ *     RTT) and written in blocks. A block stores them column-delta + varint encoded, typically
+ *     5-8 bytes per record, behind a header with its time range, target id range/mask and a
+ *     checksum. Target ids index the IPv4 addresses introduced by each block.
+ *   - close() appends the footer: one index entry per block plus the target table, so a reader
+ *     picks the blocks it needs without touching the others. A log that was never closed (crash)
+ *     is recovered by walking the block headers up to the first torn block; open() for append
+ *     does the same and drops the old footer before continuing.
+ *   - ResultLogReader maps the file (mapped_file.h) and answers target / time-range
+ *     queries by skipping blocks on their index entry and decoding only the rest.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+#include "probe_engine.h"
+
+const uint32_t kResultLogMagic = 0x314C5250;        // "PRL1"
+const uint32_t kResultLogBlockMagic = 0x424C5250;   // "PRLB"
+const uint32_t kResultLogIndexMagic = 0x494C5250;   // "PRLI"
+const uint16_t kResultLogVersion = 1;
+
+struct ResultLogFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    int64_t createdUnixMs;
+    uint8_t pad[16];
+};
+
+struct ResultLogBlockHeader {
+    uint32_t magic;
+    uint32_t payloadBytes;          // Encoded records after the new-target table
+    uint32_t records;
+    uint32_t newTargets;            // IPv4 addresses (uint32 each) following this header
+    uint32_t firstNewTarget;        // Id of the first of them
+    uint32_t minTarget;
+    uint32_t maxTarget;
+    uint32_t checksum;              // FNV-1a over new-target table + payload
+    uint64_t targetMask;            // Bit (id % 64) set for every target in the block
+    int64_t baseUnixMs;             // Timestamp of the first record; deltas are relative to it
+    int64_t minUnixMs;              // Time range covered (the wall clock may step backwards)
+    int64_t maxUnixMs;
+};
+
+struct ResultLogIndexEntry {
+    uint64_t offset;                // Of the block header
+    int64_t minUnixMs;
+    int64_t maxUnixMs;
+    uint64_t targetMask;
+    uint32_t minTarget;
+    uint32_t maxTarget;
+    uint32_t records;
+    uint32_t pad;
+};
+
+struct ResultLogTrailer {
+    uint64_t indexOffset;
+    uint32_t blocks;
+    uint32_t targets;               // Address table (uint32 each) follows the index entries
+    uint32_t version;
+    uint32_t magic;
+};
+
+static_assert(sizeof(ResultLogFileHeader) == 32, "result log header layout changed");
+static_assert(sizeof(ResultLogBlockHeader) == 64, "result log block layout changed");
+static_assert(sizeof(ResultLogIndexEntry) == 48, "result log index layout changed");
+static_assert(sizeof(ResultLogTrailer) == 24, "result log trailer layout changed");
+
+// Fixed-size form of one result inside a block (in the writer's buffer and after decoding)
+struct ResultLogRecord {
+    uint32_t target;
+    uint16_t port;
+    uint8_t status;                 // ProbeStatus
+    uint8_t reserved;
+    int32_t tsDeltaMs;              // From the block's baseUnixMs
+    uint32_t rttUs;
+};
+
+static_assert(sizeof(ResultLogRecord) == 16, "result log record layout changed");
+
+// One result as handed to query callbacks
+struct ResultLogEntry {
+    uint32_t addr;                  // IPv4, network byte order
+    uint16_t port;
+    ProbeStatus status;
+    float rttMs;
+    int64_t unixMs;
+};
+
+struct ResultLogQuery {
+    uint32_t addr = 0;              // 0 = every target
+    uint16_t port = 0;              // 0 = every port
+    int64_t fromUnixMs = INT64_MIN;
+    int64_t toUnixMs = INT64_MAX;   // Inclusive
+};
+
+// ---------- READER ----------
+class ResultLogReader {
+public:
+    ResultLogReader() = default;
+    ~ResultLogReader() { close(); }
+
+    ResultLogReader(const ResultLogReader&) = delete;
+    ResultLogReader& operator=(const ResultLogReader&) = delete;
+
+    // Maps the log read-only; false if missing, empty or not a result log
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file_.isOpen(); }
+
+    // Calls 'onEntry' for every matching result in file order; returns the number of matches
+    uint64_t query(const ResultLogQuery& q, const std::function<void(const ResultLogEntry&)>& onEntry) const;
+
+    uint64_t records() const { return records_; }
+    size_t blocks() const { return index_.size(); }
+    bool recovered() const { return recovered_; }       // No footer; index rebuilt by walking blocks
+    uint64_t dataEnd() const { return dataEnd_; }       // End of the last intact block
+    uint64_t fileBytes() const { return bytes_; }
+    uint64_t blocksDecoded() const { return blocksDecoded_; }   // By the last query()
+
+    const std::vector<ResultLogIndexEntry>& index() const { return index_; }
+    const std::vector<uint32_t>& targets() const { return targets_; }
+
+private:
+    bool loadFooter();
+    void walkBlocks();
+    bool decodeBlock(uint64_t offset, ResultLogBlockHeader& h, std::vector<ResultLogRecord>& out) const;
+
+    MappedFile file_;
+    const uint8_t* base_ = nullptr;
+    uint64_t bytes_ = 0;
+
+    std::vector<ResultLogIndexEntry> index_;
+    std::vector<uint32_t> targets_;                     // Id -> address
+    std::unordered_map<uint32_t, uint32_t> targetIds_;  // Address -> id
+    uint64_t records_ = 0;
+    uint64_t dataEnd_ = 0;
+    bool recovered_ = false;
+    mutable uint64_t blocksDecoded_ = 0;
+};
+
+// ---------- WRITER ----------
+class ResultLogWriter {
+public:
+    // A block is written once it holds 'blockRecords' results or spans 'maxBlockAgeMs';
+    // the age bound caps what a crash can lose from a slow monitor
+    explicit ResultLogWriter(uint32_t blockRecords = 4096, int64_t maxBlockAgeMs = 10 * 60 * 1000);
+    ~ResultLogWriter() { close(); }
+
+    ResultLogWriter(const ResultLogWriter&) = delete;
+    ResultLogWriter& operator=(const ResultLogWriter&) = delete;
+
+    // Creates the file, or continues an existing log after its last intact block
+    bool open(const std::string& path);
+    // Writes the pending block and the index footer
+    void close();
+    bool isOpen() const;
+
+    // Thread-safe; addr in network byte order
+    void append(uint32_t addr, uint16_t port, ProbeStatus status, float rttMs, int64_t unixMs);
+    void flush();
+
+    uint64_t records() const;
+
+private:
+    void writeBlock();
+
+    mutable std::mutex mutex_;
+    FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    uint32_t blockRecords_;
+    int64_t maxBlockAgeMs_;
+
+    std::vector<ResultLogIndexEntry> index_;
+    std::vector<uint32_t> targets_;
+    std::unordered_map<uint32_t, uint32_t> targetIds_;
+    uint32_t blockFirstNewTarget_ = 0;                  // Ids from here on are new in the pending block
+    std::vector<ResultLogRecord> pending_;
+    int64_t pendingBaseMs_ = 0;
+    int64_t pendingMinMs_ = 0;
+    int64_t pendingMaxMs_ = 0;
+    uint64_t records_ = 0;
+    std::vector<uint8_t> scratch_;
+};
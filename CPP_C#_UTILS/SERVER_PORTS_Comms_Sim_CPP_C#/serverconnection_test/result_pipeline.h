@@ -0,0 +1,345 @@
+/*
+ * Lock-Free Result Pipeline
+ * Author: Alushi
+ * Description:
+ *   - Carries probe results from probe threads to aggregation without a shared mutex.
+ *     Each probe thread pushes into its own bounded queue; one aggregator thread drains all
+ *     queues in batches and runs every registered stage (state table, history, log,
+ *     subscribers) over each batch.
+ *   - MpscRing is a bounded array queue with a sequence number per cell (Vyukov): push and pop
+ *     are one CAS each, never a lock. The enqueue and dequeue counters sit on their own cache
+ *     lines, and so does every cell, so producers and the consumer do not false-share.
+ *   - Overflow policy per pipeline:
+ *       DropOldest   - a producer facing a full queue discards the oldest result and retries,
+ *                      so probing never waits on aggregation (drops are counted). Results the
+ *                      pipeline's keep predicate marks (state transitions) are never discarded:
+ *                      an evicted one moves to a small locked side list of its queue instead,
+ *                      which the aggregator drains ahead of the ring
+ *       Backpressure - the producer yields until the aggregator makes room (stalls are counted)
+ *   - The aggregator spins briefly when it runs dry, then blocks on a condition variable; a
+ *     producer only takes the lock to wake it when it is actually asleep.
+ *   - Depth metrics per queue: current depth, high-water mark, pushed / dropped / kept /
+ *     stalled, plus time spent per stage.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class OverflowPolicy : uint8_t { DropOldest, Backpressure };
+
+inline const char* overflowPolicyName(OverflowPolicy policy) {
+    return policy == OverflowPolicy::DropOldest ? "drop-oldest" : "backpressure";
+}
+
+const size_t kCacheLine = 64;
+
+// ---------- BOUNDED QUEUE ----------
+template <typename T>
+class MpscRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit MpscRing(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        mask_ = n - 1;
+        cells_.reset(new Cell[n]);
+        for (size_t i = 0; i < n; i++) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    bool tryPush(T& value) {
+        size_t pos = enqueue_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;                       // Full
+            }
+            else {
+                pos = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Safe from any thread: the aggregator, or a producer evicting the oldest entry
+    bool tryPop(T& out) {
+        size_t pos = dequeue_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;                       // Empty
+            }
+            else {
+                pos = dequeue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Approximate while producers are active
+    size_t depth() const {
+        size_t e = enqueue_.load(std::memory_order_relaxed), d = dequeue_.load(std::memory_order_relaxed);
+        return e > d ? e - d : 0;
+    }
+
+private:
+    struct alignas(kCacheLine) Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(kCacheLine) std::atomic<size_t> enqueue_{ 0 };
+    alignas(kCacheLine) std::atomic<size_t> dequeue_{ 0 };
+};
+
+// ---------- PIPELINE ----------
+struct ResultQueueStats {
+    size_t depth = 0;
+    size_t highWater = 0;
+    size_t capacity = 0;
+    uint64_t pushed = 0;
+    uint64_t dropped = 0;       // DropOldest: results evicted unaggregated
+    uint64_t kept = 0;          // DropOldest: evictions moved to the side list (keep predicate)
+    uint64_t stalls = 0;        // Backpressure: pushes that had to wait
+};
+
+struct ResultStageStats {
+    std::string name;
+    uint64_t batches = 0;
+    uint64_t results = 0;
+    double busyMs = 0.0;
+};
+
+template <typename T>
+class ResultPipeline {
+public:
+    using Stage = std::function<void(const T* batch, size_t count)>;
+    using Keep = std::function<bool(const T& value)>;
+
+    // 'keep' marks results DropOldest must never discard
+    ResultPipeline(size_t producers, size_t capacity, OverflowPolicy policy, Keep keep = nullptr, size_t batchMax = 256)
+        : policy_(policy), keep_(std::move(keep)), batchMax_(batchMax ? batchMax : 1) {
+        for (size_t i = 0; i < std::max<size_t>(producers, 1); i++) queues_.emplace_back(new Queue(capacity));
+    }
+
+    ~ResultPipeline() { stop(); }
+
+    ResultPipeline(const ResultPipeline&) = delete;
+    ResultPipeline& operator=(const ResultPipeline&) = delete;
+
+    // Stages run in registration order on the aggregator thread; add them before start()
+    void addStage(const std::string& name, Stage stage) {
+        stages_.emplace_back(new StageSlot{ name, std::move(stage) });
+    }
+
+    void start() {
+        if (running_.exchange(true)) return;
+        thread_ = std::thread(&ResultPipeline::aggregate, this);
+    }
+
+    // Drains what is queued, then stops the aggregator. Producers must be stopped first.
+    void stop() {
+        if (!running_.exchange(false)) return;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            wake_ = true;
+        }
+        wakeCv_.notify_one();
+        thread_.join();
+    }
+
+    // Called by probe thread 'producer' (its own queue; any index works, sharing is safe)
+    void push(size_t producer, T value) {
+        Queue& q = *queues_[producer % queues_.size()];
+        bool stalled = false;
+        while (!q.ring.tryPush(value)) {
+            if (policy_ == OverflowPolicy::DropOldest || !running_.load(std::memory_order_relaxed)) {
+                T victim;
+                if (!q.ring.tryPop(victim)) continue;
+                if (keep_ && keep_(victim)) {
+                    std::lock_guard<std::mutex> lock(q.sideMutex);
+                    q.side.push_back(std::move(victim));
+                    q.sideCount.store(q.side.size(), std::memory_order_release);
+                    q.kept.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    q.dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            else {
+                if (!stalled) q.stalls.fetch_add(1, std::memory_order_relaxed);
+                stalled = true;
+                std::this_thread::yield();
+            }
+        }
+        q.pushed.fetch_add(1, std::memory_order_relaxed);
+        size_t depth = q.ring.depth();
+        size_t high = q.highWater.load(std::memory_order_relaxed);
+        while (depth > high && !q.highWater.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {}
+
+        // Pairs with the fence in aggregate(): either it sees this result or this sees it asleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                wake_ = true;
+            }
+            wakeCv_.notify_one();
+        }
+    }
+
+    std::vector<ResultQueueStats> queueStats() const {
+        std::vector<ResultQueueStats> out;
+        for (const auto& q : queues_) {
+            ResultQueueStats s;
+            s.depth = q->ring.depth();
+            s.highWater = q->highWater.load(std::memory_order_relaxed);
+            s.capacity = q->ring.capacity();
+            s.pushed = q->pushed.load(std::memory_order_relaxed);
+            s.dropped = q->dropped.load(std::memory_order_relaxed);
+            s.kept = q->kept.load(std::memory_order_relaxed);
+            s.stalls = q->stalls.load(std::memory_order_relaxed);
+            out.push_back(s);
+        }
+        return out;
+    }
+
+    std::vector<ResultStageStats> stageStats() const {
+        std::vector<ResultStageStats> out;
+        for (const auto& st : stages_) {
+            ResultStageStats s;
+            s.name = st->name;
+            s.batches = st->batches.load(std::memory_order_relaxed);
+            s.results = st->results.load(std::memory_order_relaxed);
+            s.busyMs = st->busyUs.load(std::memory_order_relaxed) / 1000.0;
+            out.push_back(s);
+        }
+        return out;
+    }
+
+    OverflowPolicy policy() const { return policy_; }
+
+private:
+    struct Queue {
+        explicit Queue(size_t capacity) : ring(capacity) {}
+        MpscRing<T> ring;
+        alignas(kCacheLine) std::atomic<uint64_t> pushed{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<uint64_t> kept{ 0 };
+        std::atomic<uint64_t> stalls{ 0 };
+        std::atomic<size_t> highWater{ 0 };
+        std::mutex sideMutex;
+        std::vector<T> side;                        // Evicted results the keep predicate marked, oldest first
+        std::atomic<size_t> sideCount{ 0 };
+    };
+
+    struct StageSlot {
+        std::string name;
+        Stage run;
+        std::atomic<uint64_t> batches{ 0 };
+        std::atomic<uint64_t> results{ 0 };
+        std::atomic<uint64_t> busyUs{ 0 };
+    };
+
+    void aggregate() {
+        using Clock = std::chrono::steady_clock;
+        std::vector<T> batch;
+        batch.reserve(batchMax_);
+        int idle = 0;
+        while (true) {
+            bool stopping = !running_.load(std::memory_order_acquire);
+            size_t drained = 0;
+            for (auto& q : queues_) {
+                batch.clear();
+                if (q->sideCount.load(std::memory_order_acquire)) {
+                    std::lock_guard<std::mutex> lock(q->sideMutex);
+                    batch.swap(q->side);            // Older than anything left in the ring
+                    q->side.clear();
+                    q->sideCount.store(0, std::memory_order_relaxed);
+                }
+                T value;
+                while (batch.size() < batchMax_ && q->ring.tryPop(value)) batch.push_back(std::move(value));
+                if (batch.empty()) continue;
+                drained += batch.size();
+                for (auto& st : stages_) {
+                    auto t0 = Clock::now();
+                    st->run(batch.data(), batch.size());
+                    st->busyUs.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count(),
+                        std::memory_order_relaxed);
+                    st->batches.fetch_add(1, std::memory_order_relaxed);
+                    st->results.fetch_add(batch.size(), std::memory_order_relaxed);
+                }
+            }
+            if (drained) {
+                idle = 0;
+                continue;
+            }
+            if (stopping) return;               // Everything queued before stop() is aggregated
+            // Nothing queued: spin briefly, then sleep until a producer or stop() wakes us
+            if (++idle < 64) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!queued()) wakeCv_.wait(lock, [&]() { return wake_ || !running_.load(); });
+            sleeping_.store(false, std::memory_order_relaxed);
+            wake_ = false;
+            idle = 0;
+        }
+    }
+
+    bool queued() const {
+        for (const auto& q : queues_)
+            if (q->ring.depth() || q->sideCount.load(std::memory_order_relaxed)) return true;
+        return false;
+    }
+
+    OverflowPolicy policy_;
+    Keep keep_;
+    size_t batchMax_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::unique_ptr<StageSlot>> stages_;
+    std::atomic<bool> running_{ false };
+    std::thread thread_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    bool wake_ = false;                             // Guarded by wakeMutex_
+    std::atomic<bool> sleeping_{ false };
+};
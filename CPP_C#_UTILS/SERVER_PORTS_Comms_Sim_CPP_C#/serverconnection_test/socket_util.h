@@ -0,0 +1,137 @@
+/*
+ * Socket Utilities
+ * Author: Alushi
+ * Description:
+ *   - Thin cross-platform wrappers (Winsock / POSIX) shared by the probe modules.
+ *   - Non-blocking connect with a deadline and readiness waits (poll() on POSIX, select() on
+ *     Windows).
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib") // Link Winsock library
+typedef SOCKET socket_t;
+const socket_t kInvalidSocket = INVALID_SOCKET;
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+typedef int socket_t;
+const socket_t kInvalidSocket = -1;
+#endif
+
+// Writes to a peer-closed socket must fail with EPIPE rather than kill the process
+#ifdef MSG_NOSIGNAL
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+// Winsock needs one WSAStartup per process; POSIX needs nothing
+inline void netInitOnce() {
+#ifdef _WIN32
+    static bool done = [] {
+        WSADATA wsa;
+        return WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+    }();
+    (void)done;
+#endif
+}
+
+inline void closeSocket(socket_t s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+inline void setNonBlocking(socket_t s) {
+#ifdef _WIN32
+    u_long mode = 1;
+    ioctlsocket(s, FIONBIO, &mode);
+#else
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+inline bool wouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+inline double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Waits until s is readable (forWrite = false) or writable; false on timeout/error
+inline bool waitSocket(socket_t s, bool forWrite, int timeoutMs) {
+    if (timeoutMs < 0) timeoutMs = 0;
+
+#ifdef _WIN32
+    // Winsock's fd_set is a list of handles, so any socket fits
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(s, &set);
+
+    struct timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+
+    int res = forWrite ? select((int)s + 1, nullptr, &set, nullptr, &tv)
+        : select((int)s + 1, &set, nullptr, nullptr, &tv);
+    return res > 0;
+#else
+    // POSIX fd_set is a bitmap of FD_SETSIZE bits; poll() has no such ceiling on the fd number
+    pollfd pfd{ s, (short)(forWrite ? POLLOUT : POLLIN), 0 };
+    int res;
+    do res = poll(&pfd, 1, timeoutMs);
+    while (res < 0 && errno == EINTR);
+    return res > 0;     // Errors and hangups count as ready, as with select(): the next call reports them
+#endif
+}
+
+// Non-blocking connect with a deadline; returns a connected non-blocking socket or kInvalidSocket
+inline socket_t connectWithTimeout(const std::string& ip, int port, int timeoutMs) {
+    netInitOnce();
+
+    socket_t s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == kInvalidSocket) return kInvalidSocket;
+    setNonBlocking(s);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+        closeSocket(s);
+        return kInvalidSocket;
+    }
+
+    connect(s, (sockaddr*)&addr, sizeof(addr));
+
+    int so_error = -1;
+    if (waitSocket(s, true, timeoutMs)) {
+        socklen_t len = sizeof(so_error);
+        getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&so_error, &len);
+    }
+    if (so_error != 0) {
+        closeSocket(s);
+        return kInvalidSocket;
+    }
+    return s;
+}
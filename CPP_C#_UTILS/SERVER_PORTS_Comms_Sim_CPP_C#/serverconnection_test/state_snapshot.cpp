@@ -0,0 +1,166 @@
+/*
+ * State Snapshot File
+ * Author: Alushi
+ * Description:
+ *   - See state_snapshot.h.
+ */
+
+#include "state_snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint32_t kFnvBasis = 2166136261u;
+
+uint32_t fnv1a(const uint8_t* p, size_t n, uint32_t h = kFnvBasis) {
+    for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+// Pushes the file's data to the device before the rename makes it visible
+bool syncFile(FILE* f) {
+    if (std::fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+} // namespace
+
+// ---------- WRITER ----------
+SnapshotWriter::~SnapshotWriter() {
+    discard();
+}
+
+void SnapshotWriter::discard() {
+    if (!file_) return;
+    std::fclose(file_);
+    file_ = nullptr;
+    std::remove((path_ + ".tmp").c_str());
+}
+
+bool SnapshotWriter::open(const std::string& path) {
+    discard();
+    path_ = path;
+    body_ = 0;
+    sectionLeft_ = 0;
+    sections_ = 0;
+    checksum_ = kFnvBasis;
+    file_ = std::fopen((path_ + ".tmp").c_str(), "wb");
+    // Header placeholder; commit() rewrites it once the body is complete
+    SnapshotFileHeader fh{};
+    ok_ = file_ && std::fwrite(&fh, sizeof(fh), 1, file_) == 1;
+    return ok_;
+}
+
+void SnapshotWriter::put(const void* data, size_t bytes) {
+    if (!ok_ || bytes == 0) return;
+    if (std::fwrite(data, 1, bytes, file_) != bytes) {
+        ok_ = false;
+        return;
+    }
+    checksum_ = fnv1a((const uint8_t*)data, bytes, checksum_);
+    body_ += bytes;
+}
+
+void SnapshotWriter::begin(SnapshotSection tag, uint64_t bytes) {
+    if (sectionLeft_ != 0) ok_ = false;    // The previous section came up short
+    SnapshotSectionHeader sh{};
+    sh.tag = (uint32_t)tag;
+    sh.bytes = bytes;
+    put(&sh, sizeof(sh));
+    sectionLeft_ = bytes;
+    sections_++;
+}
+
+void SnapshotWriter::write(const void* data, size_t bytes) {
+    if (bytes > sectionLeft_) ok_ = false;  // More than begin() announced
+    put(data, bytes);
+    sectionLeft_ -= std::min<uint64_t>(bytes, sectionLeft_);
+}
+
+void SnapshotWriter::add(SnapshotSection tag, const void* data, size_t bytes) {
+    begin(tag, bytes);
+    write(data, bytes);
+}
+
+bool SnapshotWriter::commit(int64_t savedUnixMs) {
+    if (!file_) return false;
+    SnapshotFileHeader fh{};
+    fh.magic = kSnapshotMagic;
+    fh.version = kSnapshotVersion;
+    fh.headerSize = sizeof(fh);
+    fh.sections = sections_;
+    fh.checksum = checksum_;
+    fh.savedUnixMs = savedUnixMs;
+    fh.bodyBytes = body_;
+
+    bool ok = ok_ && sectionLeft_ == 0
+        && std::fseek(file_, 0, SEEK_SET) == 0
+        && std::fwrite(&fh, sizeof(fh), 1, file_) == 1
+        && syncFile(file_);
+    ok = (std::fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    std::string tmp = path_ + ".tmp";
+    if (!ok || !replaceFile(tmp, path_)) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ---------- READER ----------
+bool SnapshotReader::open(const std::string& path) {
+    close();
+    if (!file_.open(path) || file_.size() < sizeof(SnapshotFileHeader)) {
+        close();
+        return false;
+    }
+    std::memcpy(&header_, file_.data(), sizeof(header_));
+    const uint8_t* body = file_.data() + header_.headerSize;
+    if (header_.magic != kSnapshotMagic || header_.version != kSnapshotVersion
+        || header_.headerSize < sizeof(header_) || header_.headerSize + header_.bodyBytes != file_.size()
+        || fnv1a(body, (size_t)header_.bodyBytes) != header_.checksum) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::section(SnapshotSection tag, const uint8_t*& data, size_t& bytes) const {
+    if (!file_.isOpen()) return false;
+    const uint8_t* p = file_.data() + header_.headerSize;
+    const uint8_t* end = file_.data() + file_.size();
+    for (uint32_t i = 0; i < header_.sections && (size_t)(end - p) >= sizeof(SnapshotSectionHeader); i++) {
+        SnapshotSectionHeader sh;
+        std::memcpy(&sh, p, sizeof(sh));
+        p += sizeof(sh);
+        if (sh.bytes > (uint64_t)(end - p)) return false;
+        if (sh.tag == (uint32_t)tag) {
+            data = p;
+            bytes = (size_t)sh.bytes;
+            return true;
+        }
+        p += sh.bytes;
+    }
+    return false;
+}
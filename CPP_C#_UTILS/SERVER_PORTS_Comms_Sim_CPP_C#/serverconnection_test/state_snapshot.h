@@ -0,0 +1,104 @@
+/*
+ * State Snapshot File
+ * Author: Alushi
+ * Description:
+ *   - Compact file of tagged binary sections (monitor state, target histories, scheduler
+ *     targets, ...) so a restarted monitor resumes with warm estimators instead of starting
+ *     from zero.
+ *   - Layout: 32-byte header (magic, version, section count, save time, checksum over the
+ *     rest), then sections of { tag, bytes, payload }.
+ *   - Crash-safe: SnapshotWriter streams sections into "<path>.tmp" as they are added (only the
+ *     running checksum is kept in memory); commit() fills in the header, flushes the file to
+ *     disk and renames it over the old snapshot, so a reader sees either the previous snapshot
+ *     or the new one, never a torn mix.
+ *   - SnapshotReader maps the file (mapped_file.h) and hands out sections in place; anything
+ *     with a bad magic, version or checksum is rejected as a whole.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+const uint32_t kSnapshotMagic = 0x31535350;     // "PSS1"
+const uint16_t kSnapshotVersion = 1;
+
+enum class SnapshotSection : uint32_t { Monitor = 1, History = 2, PortMap = 3, Targets = 4 };
+
+struct SnapshotFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t sections;
+    uint32_t checksum;              // FNV-1a over everything after the header
+    int64_t savedUnixMs;
+    uint64_t bodyBytes;
+};
+
+struct SnapshotSectionHeader {
+    uint32_t tag;                   // SnapshotSection
+    uint32_t reserved;
+    uint64_t bytes;
+};
+
+static_assert(sizeof(SnapshotFileHeader) == 32, "snapshot header layout changed");
+static_assert(sizeof(SnapshotSectionHeader) == 16, "snapshot section layout changed");
+
+// ---------- WRITER ----------
+class SnapshotWriter {
+public:
+    SnapshotWriter() = default;
+    ~SnapshotWriter();              // An uncommitted snapshot is discarded
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    // Starts "<path>.tmp"; false if it cannot be created
+    bool open(const std::string& path);
+
+    // Starts a section of exactly 'bytes', filled by write() calls
+    void begin(SnapshotSection tag, uint64_t bytes);
+    void write(const void* data, size_t bytes);
+    // Whole section in one call
+    void add(SnapshotSection tag, const void* data, size_t bytes);
+
+    // Atomically replaces 'path' with the sections written so far; false on any I/O error or
+    // a section shorter or longer than announced (the previous snapshot is then left untouched)
+    bool commit(int64_t savedUnixMs);
+
+    uint64_t bytes() const { return body_ + sizeof(SnapshotFileHeader); }
+
+private:
+    void put(const void* data, size_t bytes);
+    void discard();
+
+    std::string path_;
+    FILE* file_ = nullptr;
+    bool ok_ = false;
+    uint64_t body_ = 0;
+    uint64_t sectionLeft_ = 0;      // Bytes the current section still needs
+    uint32_t sections_ = 0;
+    uint32_t checksum_ = 0;
+};
+
+// ---------- READER ----------
+class SnapshotReader {
+public:
+    bool open(const std::string& path);
+    void close() { file_.close(); }
+
+    // First section with 'tag'; false if the snapshot has none
+    bool section(SnapshotSection tag, const uint8_t*& data, size_t& bytes) const;
+
+    int64_t savedUnixMs() const { return header_.savedUnixMs; }
+    uint64_t fileBytes() const { return file_.size(); }
+
+private:
+    MappedFile file_;
+    SnapshotFileHeader header_{};
+};
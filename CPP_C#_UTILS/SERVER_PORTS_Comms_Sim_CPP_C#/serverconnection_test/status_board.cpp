@@ -0,0 +1,128 @@
+/*
+ * Shared-Memory Status Board
+ * Author: Alushi
+ * Description:
+ *   - Writer side of status_board.h.
+ */
+
+#include "status_board.h"
+
+#include <chrono>
+
+#include "socket_util.h"
+
+namespace {
+
+uint64_t unixMs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+bool StatusBoardWriter::open(const std::string& name, uint32_t capacity) {
+    close();
+    if (capacity == 0) return false;
+    bytes_ = statusBoardBytes(capacity);
+    void* p = nullptr;
+
+#ifdef _WIN32
+    std::string full = "Local\\" + name;
+    mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        (DWORD)((uint64_t)bytes_ >> 32), (DWORD)bytes_, full.c_str());
+    if (!mapping_) return false;
+    p = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, bytes_);
+    if (!p) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+        return false;
+    }
+#else
+    std::string full = "/" + name;
+    shm_unlink(full.c_str());       // A board left by a crashed run may have another size
+    int fd = shm_open(full.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)bytes_) != 0) {
+        ::close(fd);
+        shm_unlink(full.c_str());
+        return false;
+    }
+    p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(full.c_str());
+        return false;
+    }
+#endif
+
+    name_ = name;
+    std::memset(p, 0, bytes_);
+    header_ = (StatusBoardHeader*)p;
+    entries_ = (StatusBoardEntry*)((char*)p + sizeof(StatusBoardHeader));
+
+    header_->version = kStatusBoardVersion;
+    header_->headerSize = sizeof(StatusBoardHeader);
+    header_->entrySize = sizeof(StatusBoardEntry);
+    header_->capacity = capacity;
+#ifdef _WIN32
+    header_->writerPid = (uint32_t)GetCurrentProcessId();
+#else
+    header_->writerPid = (uint32_t)getpid();
+#endif
+    header_->startedUnixMs = unixMs();
+    header_->heartbeatUnixMs.store(header_->startedUnixMs, std::memory_order_relaxed);
+    // Magic last: a reader that sees it also sees a complete header
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = kStatusBoardMagic;
+    return true;
+}
+
+void StatusBoardWriter::close() {
+    if (!header_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(header_);
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+#else
+    munmap(header_, bytes_);
+    shm_unlink(("/" + name_).c_str());  // Readers already attached keep their mapping
+#endif
+    header_ = nullptr;
+    entries_ = nullptr;
+}
+
+int StatusBoardWriter::addTarget(const std::string& ip, int port) {
+    if (!header_ || port <= 0 || port > 65535) return -1;
+    in_addr a{};
+    if (inet_pton(AF_INET, ip.c_str(), &a) != 1) return -1;
+
+    uint32_t n = header_->count.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < n; i++)
+        if (entries_[i].status.addr == a.s_addr && entries_[i].status.port == (uint16_t)port) return (int)i;
+    if (n >= header_->capacity) return -1;
+
+    StatusBoardEntry& e = entries_[n];
+    e.seq.store(0, std::memory_order_relaxed);
+    e.status = TargetStatus();
+    e.status.addr = a.s_addr;
+    e.status.port = (uint16_t)port;
+    header_->count.store(n + 1, std::memory_order_release);
+    return (int)n;
+}
+
+void StatusBoardWriter::publish(int slot, const TargetStatus& status) {
+    if (!header_ || slot < 0 || (uint32_t)slot >= header_->count.load(std::memory_order_relaxed)) return;
+    StatusBoardEntry& e = entries_[slot];
+
+    uint32_t seq = e.seq.load(std::memory_order_relaxed);
+    e.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    TargetStatus copy = status;
+    copy.addr = e.status.addr;
+    copy.port = e.status.port;
+    std::memcpy((void*)&e.status, &copy, sizeof(copy));
+
+    e.seq.store(seq + 2, std::memory_order_release);
+    header_->heartbeatUnixMs.store(unixMs(), std::memory_order_relaxed);
+}
@@ -0,0 +1,205 @@
+/*
+ * Shared-Memory Status Board
+ * Author: Alushi
+ * Description:
+ *   - Publishes the per-target status table in a named shared-memory segment
+ *     (POSIX shm_open "/<name>", Windows "Local\<name>").
+ *   - Fixed, versioned layout: one 64-byte header, then 'capacity' 64-byte entries.
+ *     Readers must check magic, version and entrySize before trusting anything else.
+ *   - Each entry is a seqlock: the writer makes 'seq' odd, updates the payload, makes it even.
+ *     A reader copies the payload between two equal, even reads of 'seq', so a status check
+ *     is a handful of loads with no syscall and no lock.
+ *   - Single writer (the monitor process). StatusBoardReader is header-only so other tools
+ *     only need this file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>   // Before windows.h, which would otherwise pull in the old winsock.h
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const uint32_t kStatusBoardMagic = 0x31425350;     // "PSB1"
+const uint16_t kStatusBoardVersion = 1;
+const char* const kStatusBoardDefaultName = "serverconnection_status";
+
+enum class TargetHealth : uint8_t { Unknown = 0, Online = 1, Offline = 2 };
+
+// Entry payload as readers see it; plain data, copied out under the seqlock
+struct TargetStatus {
+    uint32_t addr = 0;                  // IPv4, network byte order
+    uint16_t port = 0;
+    TargetHealth health = TargetHealth::Unknown;
+    uint8_t reserved = 0;
+    uint32_t consecutiveFailures = 0;
+    float phi = 0.0f;                   // 0 when phi-accrual is off
+    float rttMs = 0.0f;                 // Last probe / smoothed RTT, 0 when unknown
+    uint64_t lastCheckUnixMs = 0;
+    uint64_t lastChangeUnixMs = 0;      // Last Online <-> Offline transition
+    uint64_t probes = 0;
+    uint64_t failures = 0;
+};
+
+struct StatusBoardHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t entrySize;
+    uint32_t capacity;
+    std::atomic<uint32_t> count;        // Entries in use; only grows
+    uint32_t writerPid;
+    uint64_t startedUnixMs;
+    std::atomic<uint64_t> heartbeatUnixMs;  // Updated every publish; stale means the writer died
+    uint8_t pad[24];
+};
+
+struct StatusBoardEntry {
+    std::atomic<uint32_t> seq;          // Odd while the writer is mid-update
+    uint32_t pad;
+    TargetStatus status;                // 56 bytes; grow only together with kStatusBoardVersion
+};
+
+static_assert(sizeof(StatusBoardHeader) == 64, "status board header layout changed");
+static_assert(sizeof(StatusBoardEntry) == 64, "status board entry layout changed");
+static_assert(sizeof(std::atomic<uint32_t>) == 4 && std::atomic<uint32_t>::is_always_lock_free,
+    "seqlock needs lock-free 32-bit atomics in shared memory");
+
+inline size_t statusBoardBytes(uint32_t capacity) {
+    return sizeof(StatusBoardHeader) + (size_t)capacity * sizeof(StatusBoardEntry);
+}
+
+// ---------- WRITER ----------
+class StatusBoardWriter {
+public:
+    StatusBoardWriter() = default;
+    ~StatusBoardWriter() { close(); }
+
+    StatusBoardWriter(const StatusBoardWriter&) = delete;
+    StatusBoardWriter& operator=(const StatusBoardWriter&) = delete;
+
+    // Creates (or replaces) the segment; false if shared memory is unavailable
+    bool open(const std::string& name, uint32_t capacity = 1024);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    // Claims an entry for ip:port (or returns the existing one); -1 when full or ip is invalid
+    int addTarget(const std::string& ip, int port);
+
+    // Seqlocked update of one entry; addr/port in 'status' are ignored
+    void publish(int slot, const TargetStatus& status);
+
+private:
+    std::string name_;
+    StatusBoardHeader* header_ = nullptr;
+    StatusBoardEntry* entries_ = nullptr;
+    size_t bytes_ = 0;
+#ifdef _WIN32
+    HANDLE mapping_ = nullptr;
+#endif
+};
+
+// ---------- READER ----------
+class StatusBoardReader {
+public:
+    StatusBoardReader() = default;
+    ~StatusBoardReader() { close(); }
+
+    StatusBoardReader(const StatusBoardReader&) = delete;
+    StatusBoardReader& operator=(const StatusBoardReader&) = delete;
+
+    // Maps an existing board read-only; false if absent or of another layout version
+    bool open(const std::string& name = kStatusBoardDefaultName) {
+        close();
+#ifdef _WIN32
+        std::string full = "Local\\" + name;
+        mapping_ = OpenFileMappingA(FILE_MAP_READ, FALSE, full.c_str());
+        if (!mapping_) return false;
+        void* p = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        MEMORY_BASIC_INFORMATION info{};
+        if (p) VirtualQuery(p, &info, sizeof(info));
+        bytes_ = info.RegionSize;
+#else
+        std::string full = "/" + name;
+        int fd = shm_open(full.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat st {};
+        fstat(fd, &st);
+        bytes_ = (size_t)st.st_size;
+        void* p = bytes_ >= sizeof(StatusBoardHeader) ? mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (p == MAP_FAILED) p = nullptr;
+#endif
+        if (!p) {
+            close();
+            return false;
+        }
+        header_ = (const StatusBoardHeader*)p;
+        if (header_->magic != kStatusBoardMagic || header_->version != kStatusBoardVersion
+            || header_->entrySize != sizeof(StatusBoardEntry)
+            || bytes_ < statusBoardBytes(header_->capacity)) {
+            close();
+            return false;
+        }
+        entries_ = (const StatusBoardEntry*)((const char*)p + header_->headerSize);
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (header_) UnmapViewOfFile(header_);
+        if (mapping_) CloseHandle(mapping_);
+        mapping_ = nullptr;
+#else
+        if (header_) munmap((void*)header_, bytes_);
+#endif
+        header_ = nullptr;
+        entries_ = nullptr;
+    }
+
+    bool isOpen() const { return header_ != nullptr; }
+    uint32_t count() const { return header_ ? header_->count.load(std::memory_order_acquire) : 0; }
+    const StatusBoardHeader* header() const { return header_; }
+
+    // Consistent snapshot of one entry; false if out of range or the writer kept it busy
+    bool read(uint32_t slot, TargetStatus& out, int maxSpins = 1000) const {
+        if (slot >= count()) return false;
+        const StatusBoardEntry& e = entries_[slot];
+        for (int spin = 0; spin < maxSpins; spin++) {
+            uint32_t before = e.seq.load(std::memory_order_acquire);
+            if (before & 1u) continue;
+            std::memcpy(&out, (const void*)&e.status, sizeof(out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (e.seq.load(std::memory_order_relaxed) == before) return true;
+        }
+        return false;
+    }
+
+    // Slot of ip:port (addr in network byte order), -1 if not on the board
+    int find(uint32_t addr, uint16_t port) const {
+        uint32_t n = count();
+        TargetStatus s;
+        for (uint32_t i = 0; i < n; i++)
+            if (read(i, s) && s.addr == addr && s.port == port) return (int)i;
+        return -1;
+    }
+
+private:
+    const StatusBoardHeader* header_ = nullptr;
+    const StatusBoardEntry* entries_ = nullptr;
+    size_t bytes_ = 0;
+#ifdef _WIN32
+    HANDLE mapping_ = nullptr;
+#endif
+};
@@ -0,0 +1,242 @@
+/*
+ * Target Configuration File
+ * Author: Alushi
+ * Description:
+ *   - See target_config.h.
+ */
+
+#include "target_config.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "probe_engine.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool parseInt(const std::string& s, int lo, int hi, int& out) {
+    char* end = nullptr;
+    long v = std::strtol(s.c_str(), &end, 10);
+    if (s.empty() || *end != '\0' || v < lo || v > hi) return false;
+    out = (int)v;
+    return true;
+}
+
+// Applies one "key=value" to 'cfg'; false if the key or value is unknown
+bool applySetting(TargetConfig& cfg, const std::string& item) {
+    size_t eq = item.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = item.substr(0, eq), value = item.substr(eq + 1);
+    if (key == "interval") return parseInt(value, 10, 86400000, cfg.intervalMs);
+    if (key == "timeout") return parseInt(value, 1, 600000, cfg.timeoutMs);
+    if (key == "threshold") return parseInt(value, 1, 1000000, cfg.failureThreshold);
+    if (key == "path") {
+        cfg.httpPath = value;
+        return !value.empty() && value[0] == '/';
+    }
+    if (key == "sni") {
+        cfg.sni = value;
+        return true;
+    }
+    if (key == "priority") {
+        if (value == "critical") cfg.priority = ProbeClass::Critical;
+        else if (value == "normal") cfg.priority = ProbeClass::Monitor;
+        else return false;
+        return true;
+    }
+    if (key == "probe") {
+        if (value == "connect") cfg.kind = ProbeKind::Connect;
+        else if (value == "http") cfg.kind = ProbeKind::Http;
+        else if (value == "tls") cfg.kind = ProbeKind::Tls;
+        else return false;
+        return true;
+    }
+    return false;
+}
+
+int64_t mtimeOf(const std::string& path) {
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0) return -1;
+    return (int64_t)st.st_mtime * 1000000000LL
+#ifdef __linux__
+        + st.st_mtim.tv_nsec
+#endif
+        + st.st_size;   // Same-second rewrites on coarse clocks usually change the size
+}
+
+} // namespace
+
+const char* probeKindName(ProbeKind kind) {
+    switch (kind) {
+    case ProbeKind::Connect: return "connect";
+    case ProbeKind::Http: return "http";
+    case ProbeKind::Tls: return "tls";
+    }
+    return "?";
+}
+
+bool loadTargetConfig(const std::string& path, std::vector<TargetConfig>& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::vector<TargetConfig> targets;
+    std::unordered_map<std::string, size_t> seen;
+    TargetConfig defaults;
+    std::string line;
+    for (int lineNo = 1; std::getline(in, line); lineNo++) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream words(line);
+        std::string first;
+        if (!(words >> first)) continue;
+
+        auto fail = [&](const std::string& what) {
+            error = path + ":" + std::to_string(lineNo) + ": " + what;
+            return false;
+        };
+
+        if (first == "default") {
+            std::string item;
+            while (words >> item)
+                if (!applySetting(defaults, item)) return fail("bad setting '" + item + "'");
+            continue;
+        }
+
+        TargetConfig cfg = defaults;
+        size_t colon = first.find(':');
+        cfg.ip = first.substr(0, colon);
+        int port = 80;
+        if (colon != std::string::npos && !parseInt(first.substr(colon + 1), 1, 65535, port))
+            return fail("bad port in '" + first + "'");
+        ProbeTarget target;
+        if (!makeProbeTarget(cfg.ip, port, target)) return fail("bad address '" + first + "'");
+        cfg.port = (uint16_t)port;
+        cfg.addr = target.addr;
+
+        std::string item;
+        while (words >> item)
+            if (!applySetting(cfg, item)) return fail("bad setting '" + item + "'");
+
+        auto it = seen.find(cfg.key());
+        if (it != seen.end()) {
+            targets[it->second] = cfg;
+        }
+        else {
+            seen.emplace(cfg.key(), targets.size());
+            targets.push_back(std::move(cfg));
+        }
+    }
+
+    out.swap(targets);
+    return true;
+}
+
+TargetConfigDiff diffTargetConfigs(std::unordered_map<std::string, TargetConfig>& current, const std::vector<TargetConfig>& next) {
+    TargetConfigDiff diff;
+    std::unordered_map<std::string, const TargetConfig*> wanted;
+    wanted.reserve(next.size());
+    for (const TargetConfig& cfg : next) wanted[cfg.key()] = &cfg;
+
+    for (auto it = current.begin(); it != current.end();) {
+        if (wanted.count(it->first)) {
+            ++it;
+            continue;
+        }
+        diff.removed.push_back(it->first);
+        it = current.erase(it);
+    }
+    for (const auto& kv : wanted) {
+        auto it = current.find(kv.first);
+        if (it == current.end()) {
+            diff.added.push_back(*kv.second);
+            current.emplace(kv.first, *kv.second);
+        }
+        else if (!it->second.sameSettings(*kv.second)) {
+            diff.changed.push_back(*kv.second);
+            it->second = *kv.second;
+        }
+        else {
+            diff.unchanged++;
+        }
+    }
+    return diff;
+}
+
+// ---------- WATCHER ----------
+bool TargetConfigWatcher::start(const std::string& path, std::function<void()> onChange) {
+    stop();
+    path_ = path;
+    onChange_ = std::move(onChange);
+#ifdef __linux__
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0 || inotify_add_watch(inotifyFd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        if (inotifyFd_ >= 0) close(inotifyFd_);
+        inotifyFd_ = -1;    // Fall back to polling
+    }
+#endif
+    running_.store(true);
+    thread_ = std::thread(&TargetConfigWatcher::loop, this);
+    return true;
+}
+
+void TargetConfigWatcher::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+#ifdef __linux__
+    if (inotifyFd_ >= 0) close(inotifyFd_);
+#endif
+    inotifyFd_ = -1;
+}
+
+void TargetConfigWatcher::loop() {
+    int64_t lastMtime = mtimeOf(path_);
+#ifdef __linux__
+    size_t slash = path_.rfind('/');
+    std::string name = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+#endif
+    while (running_.load()) {
+        bool touched = false;
+#ifdef __linux__
+        if (inotifyFd_ >= 0) {
+            pollfd pfd{ inotifyFd_, POLLIN, 0 };
+            if (poll(&pfd, 1, 250) <= 0) continue;   // Timeout doubles as the stop check
+            alignas(inotify_event) char buf[4096];
+            ssize_t n;
+            while ((n = read(inotifyFd_, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + n;) {
+                    const inotify_event* ev = (const inotify_event*)p;
+                    if (ev->len && name == ev->name) touched = true;
+                    p += sizeof(inotify_event) + ev->len;
+                }
+            }
+        }
+        else
+#endif
+        {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            touched = mtimeOf(path_) != lastMtime;
+        }
+        if (!touched) continue;
+
+        // Let a burst of writes settle, then reload once
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        int64_t mtime = mtimeOf(path_);
+        if (mtime < 0 || mtime == lastMtime) continue;
+        lastMtime = mtime;
+        if (running_.load()) onChange_();
+    }
+}
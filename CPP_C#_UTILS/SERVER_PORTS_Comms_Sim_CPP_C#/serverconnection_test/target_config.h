@@ -0,0 +1,90 @@
+/*
+ * Target Configuration File
+ * Author: Alushi
+ * Description:
+ *   - Lists the targets to monitor, one per line, with optional per-target settings:
+ *       # comment
+ *       default interval=5000 timeout=500 threshold=3 probe=connect
+ *       10.0.0.1:443 probe=tls sni=example.com interval=1000
+ *       10.0.0.2:8080 probe=http path=/healthz
+ *       10.0.0.3                                (port 80)
+ *     "default" lines change the settings of every target line after them.
+ *     Keys: interval (ms), timeout (ms), threshold (failures before Offline),
+ *     probe (connect | http | tls), path (http), sni (tls), priority (critical | normal;
+ *     critical targets are probed first when the scheduler falls behind).
+ *   - A file with any bad line is rejected as a whole, so a half-edited file never replaces
+ *     a good configuration.
+ *   - diffTargetConfigs() compares the running set with a freshly loaded file by "ip:port";
+ *     only added, removed and changed targets come out of it.
+ *   - TargetConfigWatcher calls back when the file is rewritten: inotify on its directory
+ *     (Linux, so editors that save by rename are caught), mtime polling elsewhere.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "probe_priority.h"
+
+enum class ProbeKind : uint8_t { Connect, Http, Tls };
+
+const char* probeKindName(ProbeKind kind);
+
+struct TargetConfig {
+    std::string ip;
+    uint16_t port = 80;
+    uint32_t addr = 0;              // IPv4, network byte order
+    int intervalMs = 5000;
+    int timeoutMs = 500;
+    int failureThreshold = 3;
+    ProbeKind kind = ProbeKind::Connect;
+    std::string httpPath = "/health";
+    std::string sni;
+    ProbeClass priority = ProbeClass::Monitor;      // Critical or Monitor
+
+    std::string key() const { return ip + ":" + std::to_string(port); }
+    bool sameSettings(const TargetConfig& o) const {
+        return intervalMs == o.intervalMs && timeoutMs == o.timeoutMs && failureThreshold == o.failureThreshold
+            && kind == o.kind && httpPath == o.httpPath && sni == o.sni && priority == o.priority;
+    }
+};
+
+// Parses the whole file; on failure 'error' names the first bad line and 'out' is untouched.
+// Later lines for the same ip:port replace earlier ones.
+bool loadTargetConfig(const std::string& path, std::vector<TargetConfig>& out, std::string& error);
+
+struct TargetConfigDiff {
+    std::vector<TargetConfig> added;
+    std::vector<TargetConfig> changed;      // Same ip:port, new settings
+    std::vector<std::string> removed;       // Keys
+    size_t unchanged = 0;
+
+    bool empty() const { return added.empty() && changed.empty() && removed.empty(); }
+};
+
+// 'current' (keyed by TargetConfig::key()) is updated to match 'next'
+TargetConfigDiff diffTargetConfigs(std::unordered_map<std::string, TargetConfig>& current, const std::vector<TargetConfig>& next);
+
+class TargetConfigWatcher {
+public:
+    ~TargetConfigWatcher() { stop(); }
+
+    // 'onChange' runs on the watcher thread, at most once per burst of writes
+    bool start(const std::string& path, std::function<void()> onChange);
+    void stop();
+
+private:
+    void loop();
+
+    std::string path_;
+    std::function<void()> onChange_;
+    std::atomic<bool> running_{ false };
+    std::thread thread_;
+    int inotifyFd_ = -1;
+};
@@ -0,0 +1,225 @@
+/*
+ * Per-Target Time-Series History
+ * Author: Alushi
+ * Description:
+ *   - See target_history.h.
+ */
+
+#include "target_history.h"
+
+#include <cstring>
+
+namespace {
+
+const int64_t kMinuteMs = 60 * 1000;
+const int64_t kHourMs = 60 * kMinuteMs;
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+template <typename T>
+void putPod(SnapshotWriter& w, const T* v, size_t n = 1) {
+    w.write(v, sizeof(T) * n);
+}
+
+template <typename T>
+bool getPod(const uint8_t*& p, const uint8_t* end, T* v, size_t n = 1) {
+    if ((size_t)(end - p) < sizeof(T) * n) return false;
+    std::memcpy((void*)v, p, sizeof(T) * n);
+    p += sizeof(T) * n;
+    return true;
+}
+
+} // namespace
+
+void HistoryBucket::add(bool ok, float rttMs) {
+    checks++;
+    if (!ok) return;
+    if (up == 0 || rttMs < minRttMs) minRttMs = rttMs;
+    if (up == 0 || rttMs > maxRttMs) maxRttMs = rttMs;
+    sumRttMs += rttMs;
+    up++;
+}
+
+TargetHistory::TargetHistory(size_t rawCapacity, size_t minuteBuckets, size_t hourBuckets)
+    : raw_(rawCapacity ? rawCapacity : 1), minutes_(minuteBuckets ? minuteBuckets : 1), hours_(hourBuckets ? hourBuckets : 1) {}
+
+void TargetHistory::record(int64_t unixMs, bool up, float rttMs) {
+    HistorySample& s = raw_[rawNext_];
+    s.unixMs = unixMs;
+    s.rttMs = rttMs;
+    s.up = up ? 1 : 0;
+    rawNext_ = (rawNext_ + 1) % raw_.size();
+    if (rawCount_ < raw_.size()) rawCount_++;
+
+    addToRing(minutes_, kMinuteMs, unixMs, up, rttMs);
+    addToRing(hours_, kHourMs, unixMs, up, rttMs);
+}
+
+void TargetHistory::addToRing(std::vector<HistoryBucket>& ring, int64_t bucketMs, int64_t unixMs, bool up, float rttMs) {
+    int64_t bucket = floorDiv(unixMs, bucketMs);
+    HistoryBucket& b = ring[(size_t)(bucket % (int64_t)ring.size() + (int64_t)ring.size()) % ring.size()];
+    int64_t start = bucket * bucketMs;
+    if (b.startUnixMs != start) {
+        // Older than what the slot holds: that bucket has already been overwritten, drop it
+        if (b.startUnixMs > start) return;
+        b = HistoryBucket();
+        b.startUnixMs = start;
+    }
+    b.add(up, rttMs);
+}
+
+void TargetHistory::sumRing(const std::vector<HistoryBucket>& ring, int64_t bucketMs, int64_t from, int64_t to, HistorySummary& out) {
+    out.bucketMs = bucketMs;
+    int64_t first = floorDiv(from, bucketMs);
+    int64_t last = floorDiv(to, bucketMs);
+    // Never walk more than one lap of the ring
+    if (last - first >= (int64_t)ring.size()) first = last - (int64_t)ring.size() + 1;
+
+    for (int64_t bucket = first; bucket <= last; bucket++) {
+        const HistoryBucket& b = ring[(size_t)(bucket % (int64_t)ring.size() + (int64_t)ring.size()) % ring.size()];
+        out.buckets++;
+        if (b.startUnixMs != bucket * bucketMs || b.checks == 0) continue;
+        if (out.oldestUnixMs == 0) out.oldestUnixMs = b.startUnixMs;
+        if (b.up) {
+            if (out.up == 0 || b.minRttMs < out.minRttMs) out.minRttMs = b.minRttMs;
+            if (out.up == 0 || b.maxRttMs > out.maxRttMs) out.maxRttMs = b.maxRttMs;
+        }
+        out.checks += b.checks;
+        out.up += b.up;
+        out.sumRttMs += b.sumRttMs;
+    }
+}
+
+HistorySummary TargetHistory::summarize(int64_t nowUnixMs, int64_t windowMs) const {
+    HistorySummary out;
+    int64_t from = nowUnixMs - (windowMs > 0 ? windowMs : 0);
+    if (windowMs <= (int64_t)minutes_.size() * kMinuteMs)
+        sumRing(minutes_, kMinuteMs, from, nowUnixMs, out);
+    else
+        sumRing(hours_, kHourMs, from, nowUnixMs, out);
+    return out;
+}
+
+std::vector<HistorySample> TargetHistory::recent(size_t n) const {
+    if (n > rawCount_) n = rawCount_;
+    std::vector<HistorySample> out;
+    out.reserve(n);
+    size_t start = (rawNext_ + raw_.size() - n) % raw_.size();
+    for (size_t i = 0; i < n; i++) out.push_back(raw_[(start + i) % raw_.size()]);
+    return out;
+}
+
+size_t TargetHistory::memoryBytes() const {
+    return sizeof(*this) + raw_.capacity() * sizeof(HistorySample)
+        + (minutes_.capacity() + hours_.capacity()) * sizeof(HistoryBucket);
+}
+
+uint64_t TargetHistory::savedBytes() const {
+    return 5 * sizeof(uint64_t) + raw_.size() * sizeof(HistorySample)
+        + (minutes_.size() + hours_.size()) * sizeof(HistoryBucket);
+}
+
+void TargetHistory::save(SnapshotWriter& out) const {
+    uint64_t sizes[5] = { raw_.size(), minutes_.size(), hours_.size(), rawNext_, rawCount_ };
+    putPod(out, sizes, 5);
+    putPod(out, raw_.data(), raw_.size());
+    putPod(out, minutes_.data(), minutes_.size());
+    putPod(out, hours_.data(), hours_.size());
+}
+
+bool TargetHistory::load(const uint8_t*& p, const uint8_t* end) {
+    uint64_t sizes[5];
+    if (!getPod(p, end, sizes, 5)) return false;
+    if (sizes[0] != raw_.size() || sizes[1] != minutes_.size() || sizes[2] != hours_.size()
+        || sizes[3] >= raw_.size() || sizes[4] > raw_.size())
+        return false;
+    if (!getPod(p, end, raw_.data(), raw_.size()) || !getPod(p, end, minutes_.data(), minutes_.size())
+        || !getPod(p, end, hours_.data(), hours_.size()))
+        return false;
+    rawNext_ = (size_t)sizes[3];
+    rawCount_ = (size_t)sizes[4];
+    return true;
+}
+
+// ---------- TABLE ----------
+void TargetHistoryTable::setSizes(const TargetHistorySizes& sizes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sizes_ = sizes;
+}
+
+TargetHistorySizes TargetHistoryTable::sizes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sizes_;
+}
+
+void TargetHistoryTable::record(const std::string& target, int64_t unixMs, bool up, float rttMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& h = histories_[target];
+    if (!h) h.reset(new TargetHistory(sizes_.raw, sizes_.minutes, sizes_.hours));
+    h->record(unixMs, up, rttMs);
+}
+
+bool TargetHistoryTable::summarize(const std::string& target, int64_t nowUnixMs, int64_t windowMs, HistorySummary& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = histories_.find(target);
+    if (it == histories_.end()) return false;
+    out = it->second->summarize(nowUnixMs, windowMs);
+    return true;
+}
+
+std::vector<HistorySample> TargetHistoryTable::recent(const std::string& target, size_t n) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = histories_.find(target);
+    return it == histories_.end() ? std::vector<HistorySample>() : it->second->recent(n);
+}
+
+std::vector<std::string> TargetHistoryTable::targets() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> out;
+    for (const auto& kv : histories_) out.push_back(kv.first);
+    return out;
+}
+
+size_t TargetHistoryTable::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    for (const auto& kv : histories_) total += kv.second->memoryBytes();
+    return total;
+}
+
+void TargetHistoryTable::save(SnapshotWriter& out, SnapshotSection tag) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t bytes = sizeof(uint32_t);
+    for (const auto& kv : histories_) bytes += sizeof(uint32_t) + kv.first.size() + kv.second->savedBytes();
+    out.begin(tag, bytes);
+    uint32_t count = (uint32_t)histories_.size();
+    putPod(out, &count);
+    for (const auto& kv : histories_) {
+        uint32_t len = (uint32_t)kv.first.size();
+        putPod(out, &len);
+        putPod(out, kv.first.data(), len);
+        kv.second->save(out);
+    }
+}
+
+size_t TargetHistoryTable::load(const uint8_t* p, size_t bytes) {
+    const uint8_t* end = p + bytes;
+    uint32_t count;
+    if (!getPod(p, end, &count)) return 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t restored = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t len;
+        if (!getPod(p, end, &len) || (size_t)(end - p) < len) break;
+        std::string target((const char*)p, len);
+        p += len;
+        std::unique_ptr<TargetHistory> h(new TargetHistory(sizes_.raw, sizes_.minutes, sizes_.hours));
+        if (!h->load(p, end)) break;    // Sizes changed or file cut short: keep what loaded so far
+        histories_[target] = std::move(h);
+        restored++;
+    }
+    return restored;
+}
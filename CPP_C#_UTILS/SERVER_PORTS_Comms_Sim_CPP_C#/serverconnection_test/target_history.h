@@ -0,0 +1,132 @@
+/*
+ * Per-Target Time-Series History
+ * Author: Alushi
+ * Description:
+ *   - Fixed-memory history of one target's checks: a ring of the most recent raw samples
+ *     plus minute and hour rollups (checks, up count, min / avg / max RTT).
+ *   - Every record() updates the raw ring and both rollups in place, O(1), so nothing is ever
+ *     rescanned. Rollup rings are indexed by bucket number; a slot whose start time is stale is
+ *     reset on reuse, so gaps (monitor stopped) simply read as empty buckets.
+ *   - summarize() over a window walks minute buckets while the window fits in the minute ring
+ *     (24 h by default) and hour buckets beyond that (30 days), i.e. O(buckets in the window).
+ *   - Defaults: 1024 raw + 1440 minute + 720 hour slots = about 85 KB per target, allocated
+ *     once up front. A table can be given smaller rings (TargetHistorySizes) when it holds
+ *     many targets; the scheduler's targets get rollup-sized ones.
+ *   - save() / load() copy the rings as-is for warm restarts; save() streams them straight
+ *     into the snapshot file (state_snapshot.h) instead of staging a copy.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "state_snapshot.h"
+
+struct HistorySample {
+    int64_t unixMs = 0;
+    float rttMs = 0.0f;
+    uint8_t up = 0;
+};
+
+struct HistoryBucket {
+    int64_t startUnixMs = -1;       // -1 = never used
+    uint32_t checks = 0;
+    uint32_t up = 0;
+    float minRttMs = 0.0f;          // RTT aggregates cover successful checks only
+    float maxRttMs = 0.0f;
+    double sumRttMs = 0.0;
+
+    void add(bool ok, float rttMs);
+};
+
+struct HistorySummary {
+    uint64_t checks = 0;
+    uint64_t up = 0;
+    float minRttMs = 0.0f;
+    float maxRttMs = 0.0f;
+    double sumRttMs = 0.0;
+    int64_t bucketMs = 0;           // Resolution used: 60000 or 3600000
+    size_t buckets = 0;             // Buckets walked
+    int64_t oldestUnixMs = 0;       // Start of the oldest bucket with data, 0 if none
+
+    double uptime() const { return checks ? (double)up / checks : 0.0; }
+    double avgRttMs() const { return up ? sumRttMs / up : 0.0; }
+};
+
+// Ring sizes of the histories in one table
+struct TargetHistorySizes {
+    size_t raw = 1024;
+    size_t minutes = 1440;
+    size_t hours = 720;
+
+    size_t bytes() const { return raw * sizeof(HistorySample) + (minutes + hours) * sizeof(HistoryBucket); }
+};
+
+class TargetHistory {
+public:
+    TargetHistory(size_t rawCapacity = 1024, size_t minuteBuckets = 1440, size_t hourBuckets = 720);
+
+    void record(int64_t unixMs, bool up, float rttMs);
+
+    // Aggregate of the last 'windowMs' before 'nowUnixMs', at bucket granularity
+    HistorySummary summarize(int64_t nowUnixMs, int64_t windowMs) const;
+
+    // Up to 'n' newest raw samples, oldest first
+    std::vector<HistorySample> recent(size_t n) const;
+
+    size_t memoryBytes() const;
+
+    // Writes the rings into the writer's current section (savedBytes() of it); load() reads
+    // them back (advancing 'p') and fails on a truncated buffer or a ring size other than
+    // this history's
+    uint64_t savedBytes() const;
+    void save(SnapshotWriter& w) const;
+    bool load(const uint8_t*& p, const uint8_t* end);
+
+private:
+    static void addToRing(std::vector<HistoryBucket>& ring, int64_t bucketMs, int64_t unixMs, bool up, float rttMs);
+    static void sumRing(const std::vector<HistoryBucket>& ring, int64_t bucketMs, int64_t from, int64_t to, HistorySummary& out);
+
+    std::vector<HistorySample> raw_;
+    size_t rawNext_ = 0;
+    size_t rawCount_ = 0;
+    std::vector<HistoryBucket> minutes_;
+    std::vector<HistoryBucket> hours_;
+};
+
+// Histories keyed by "ip:port", created on first record; thread-safe
+class TargetHistoryTable {
+public:
+    explicit TargetHistoryTable(TargetHistorySizes sizes = TargetHistorySizes()) : sizes_(sizes) {}
+
+    // Ring sizes of histories created (or loaded) from now on
+    void setSizes(const TargetHistorySizes& sizes);
+    TargetHistorySizes sizes() const;
+
+    void record(const std::string& target, int64_t unixMs, bool up, float rttMs);
+
+    // False if nothing was ever recorded for 'target'
+    bool summarize(const std::string& target, int64_t nowUnixMs, int64_t windowMs, HistorySummary& out) const;
+
+    // Newest raw samples of 'target', oldest first; empty if unknown
+    std::vector<HistorySample> recent(const std::string& target, size_t n) const;
+
+    std::vector<std::string> targets() const;
+    size_t memoryBytes() const;
+
+    // Every history, keyed, as one 'tag' section of 'w'; load() merges into the table and
+    // returns the targets restored
+    void save(SnapshotWriter& w, SnapshotSection tag) const;
+    size_t load(const uint8_t* p, size_t bytes);
+
+private:
+    mutable std::mutex mutex_;
+    TargetHistorySizes sizes_;
+    std::map<std::string, std::unique_ptr<TargetHistory>> histories_;
+};
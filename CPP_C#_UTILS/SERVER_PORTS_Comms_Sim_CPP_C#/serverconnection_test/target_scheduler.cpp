@@ -0,0 +1,409 @@
+/*
+ * Multi-Target Scheduler
+ * Author: Alushi
+ * Description:
+ *   - See target_scheduler.h. Without PROBE_WITH_OPENSSL, probe=tls targets get connect checks.
+ */
+
+#include "target_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+
+#include "http_probe.h"
+#include "tls_probe.h"
+
+namespace {
+
+const size_t kApplyChunk = 1024;    // Diff operations per lock hold
+const size_t kSlowChecksPerBatch = 16;  // http / tls checks per worker batch, one helper thread each
+
+int64_t unixMsNow() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64_t hashKey(const std::string& key) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : key) h = (h ^ c) * 1099511628211ull;
+    return h;
+}
+
+// Checks that run a blocking probe of their own instead of going through the engine
+bool slowCheck(ProbeKind kind) {
+#ifdef PROBE_WITH_OPENSSL
+    if (kind == ProbeKind::Tls) return true;
+#endif
+    return kind == ProbeKind::Http;
+}
+
+void runSlowCheck(const TargetConfig& cfg, ProbeStatus& status, float& rttMs) {
+#ifdef PROBE_WITH_OPENSSL
+    if (cfg.kind == ProbeKind::Tls) {
+        TlsProbeOptions o;
+        o.serverName = cfg.sni;
+        o.connectTimeoutMs = cfg.timeoutMs;
+        o.reuseSession = false;
+        TlsHandshakeProbe probe(cfg.ip, cfg.port, o);
+        TlsProbeResult r = probe.probe();
+        status = r.ok ? ProbeStatus::Open : ProbeStatus::Error;
+        rttMs = (float)(r.connectMs + r.handshakeMs);
+        return;
+    }
+#endif
+    HttpProbeOptions o;
+    o.path = cfg.httpPath;
+    o.connectTimeoutMs = cfg.timeoutMs;
+    o.maxIdleConnections = 0;
+    HttpHealthProbe probe(cfg.ip, cfg.port, o);
+    HttpProbeResult r = probe.probe();
+    status = r.healthy ? ProbeStatus::Open : ProbeStatus::Error;
+    rttMs = (float)(r.connectMs + r.completeMs);
+}
+
+} // namespace
+
+TargetScheduler::TargetScheduler(TargetSchedulerOptions opts)
+    : opts_(opts),
+      results_((size_t)std::max(opts.workers, 1), opts.resultQueue, opts.overflow, [](const TargetCheck& c) { return c.changed; }),
+      due_(opts.dispatch) {
+    if (opts_.tickMs < 1) opts_.tickMs = 1;
+    if (opts_.wheelSlots < 1) opts_.wheelSlots = 1;
+    if (opts_.workers < 1) opts_.workers = 1;
+    if (opts_.window < 1) opts_.window = 1;
+    wheel_.resize(opts_.wheelSlots);
+    for (int i = 0; i < opts_.workers; i++) perf_.emplace_back(new PerfAccumulator());
+}
+
+TargetScheduler::~TargetScheduler() {
+    stop();
+}
+
+void TargetScheduler::start() {
+    if (running_.exchange(true)) return;
+    results_.start();
+    epoch_ = std::chrono::steady_clock::now();
+    tickThread_ = std::thread(&TargetScheduler::tickLoop, this);
+    for (int i = 0; i < opts_.workers; i++) workers_.emplace_back(&TargetScheduler::workerLoop, this, (size_t)i);
+}
+
+void TargetScheduler::stop() {
+    if (!running_.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);   // No worker may be between its check and its wait
+    }
+    workCv_.notify_all();
+    if (tickThread_.joinable()) tickThread_.join();
+    for (auto& w : workers_) w.join();
+    workers_.clear();
+    results_.stop();                    // After the workers: it drains what they queued
+}
+
+// ---------- CONFIG ----------
+uint64_t TargetScheduler::initialTick(const TargetConfig& cfg) const {
+    uint64_t interval = std::max<uint64_t>(1, (uint64_t)cfg.intervalMs / opts_.tickMs);
+    return tick_ + 1 + hashKey(cfg.key()) % interval;
+}
+
+void TargetScheduler::schedule(TargetId id, uint64_t dueTick) {
+    store_.setDueTick(id, dueTick);
+    wheel_[dueTick % wheel_.size()].push_back({ id, store_.generation(id), dueTick });
+}
+
+void TargetScheduler::apply(const TargetConfigDiff& diff) {
+    size_t i = 0;
+    while (i < diff.removed.size()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t end = std::min(diff.removed.size(), i + kApplyChunk); i < end; i++) {
+            auto it = byKey_.find(diff.removed[i]);
+            if (it == byKey_.end()) continue;
+            if (store_.health(it->second) == TargetHealth::Online) online_--;
+            store_.remove(it->second);  // Its wheel / queue references are now stale
+            byKey_.erase(it);
+        }
+    }
+
+    i = 0;
+    while (i < diff.changed.size()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t end = std::min(diff.changed.size(), i + kApplyChunk); i < end; i++) {
+            auto it = byKey_.find(diff.changed[i].key());
+            if (it == byKey_.end()) continue;
+            store_.reconfigure(it->second, diff.changed[i]);  // Health and counters carry over
+            schedule(it->second, initialTick(diff.changed[i]));
+        }
+    }
+
+    i = 0;
+    while (i < diff.added.size()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t end = std::min(diff.added.size(), i + kApplyChunk); i < end; i++) {
+            const TargetConfig& cfg = diff.added[i];
+            if (byKey_.count(cfg.key())) continue;
+            TargetId id = store_.add(cfg);
+            byKey_[cfg.key()] = id;
+            auto saved = resume_.find(cfg.key());
+            if (saved == resume_.end()) {
+                schedule(id, initialTick(cfg));
+                continue;
+            }
+            // Warm restart: saved health and the old phase, at most one interval out
+            const TargetResume& r = saved->second;
+            store_.restore(id, r.health <= (uint8_t)TargetHealth::Offline ? (TargetHealth)r.health : TargetHealth::Unknown,
+                r.failures, r.srttMs);
+            if (store_.health(id) == TargetHealth::Online) online_++;
+            uint64_t interval = std::max<uint64_t>(1, (uint64_t)cfg.intervalMs / opts_.tickMs);
+            schedule(id, tick_ + 1 + std::min<uint64_t>(interval - 1, (uint64_t)std::max<int64_t>(0, r.dueInMs) / opts_.tickMs));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    resume_.clear();                    // Targets added by later edits start fresh
+}
+
+std::vector<TargetResume> TargetScheduler::saveState() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<TargetResume> out;
+    out.reserve(byKey_.size());
+    for (const auto& kv : byKey_) {
+        if (kv.first.size() >= sizeof(TargetResume::key)) continue;
+        TargetId id = kv.second;
+        TargetResume r{};
+        std::memcpy(r.key, kv.first.c_str(), kv.first.size());
+        r.health = (uint8_t)store_.health(id);
+        r.failures = store_.failures(id);
+        r.srttMs = store_.srttMs(id);
+        uint64_t due = store_.dueTick(id);
+        r.dueInMs = due > tick_ ? (int64_t)((due - tick_) * opts_.tickMs) : 0;
+        out.push_back(r);
+    }
+    return out;
+}
+
+void TargetScheduler::restoreState(const TargetResume* saved, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    resume_.clear();
+    for (size_t i = 0; i < count; i++) {
+        TargetResume r = saved[i];
+        r.key[sizeof(r.key) - 1] = '\0';
+        resume_[r.key] = r;
+    }
+}
+
+size_t TargetScheduler::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return byKey_.size();
+}
+
+size_t TargetScheduler::online() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return online_;
+}
+
+size_t TargetScheduler::overdue() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return store_.countOverdue(tick_, (uint64_t)std::max(1, 1000 / opts_.tickMs));
+}
+
+std::string TargetScheduler::summary() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return "targets=" + std::to_string(byKey_.size())
+        + " online=" + std::to_string(online_)
+        + " offline=" + std::to_string(store_.countHealth(TargetHealth::Offline))
+        + " unknown=" + std::to_string(store_.countHealth(TargetHealth::Unknown))
+        + " overdue=" + std::to_string(store_.countOverdue(tick_, (uint64_t)std::max(1, 1000 / opts_.tickMs)));
+}
+
+std::vector<std::string> TargetScheduler::describe(size_t max) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, TargetId> sorted(byKey_.begin(), byKey_.end());
+    std::vector<std::string> out;
+    for (const auto& kv : sorted) {
+        if (out.size() >= max) break;
+        TargetId id = kv.second;
+        const TargetColdInfo& c = store_.cold(id);
+        const char* health = store_.health(id) == TargetHealth::Online ? "online"
+            : store_.health(id) == TargetHealth::Offline ? "offline" : "unknown";
+        out.push_back(kv.first + " " + health + " " + probeKindName(c.cfg.kind)
+            + (c.cfg.priority == ProbeClass::Critical ? " critical" : "")
+            + " every " + std::to_string(c.cfg.intervalMs) + " ms"
+            + " srtt=" + std::to_string(store_.srttMs(id)) + "ms"
+            + " failures=" + std::to_string(store_.failures(id))
+            + " probes=" + std::to_string(c.probes));
+    }
+    return out;
+}
+
+std::vector<std::string> TargetScheduler::describePipeline() const {
+    std::vector<std::string> out;
+    std::vector<ResultQueueStats> queues = results_.queueStats();
+    for (size_t i = 0; i < queues.size(); i++) {
+        const ResultQueueStats& q = queues[i];
+        out.push_back("queue " + std::to_string(i) + ": depth " + std::to_string(q.depth) + " (high " + std::to_string(q.highWater)
+            + " of " + std::to_string(q.capacity) + ") pushed " + std::to_string(q.pushed)
+            + (results_.policy() == OverflowPolicy::DropOldest
+                ? " dropped " + std::to_string(q.dropped) + " kept " + std::to_string(q.kept)
+                : " stalls " + std::to_string(q.stalls)));
+    }
+    for (const ResultStageStats& st : results_.stageStats()) {
+        out.push_back("stage " + st.name + ": " + std::to_string(st.results) + " results in " + std::to_string(st.batches)
+            + " batches, " + std::to_string(st.busyMs) + " ms");
+    }
+    return out;
+}
+
+std::vector<PerfTotals> TargetScheduler::perfTotals() const {
+    std::vector<PerfTotals> out;
+    for (const auto& p : perf_) out.push_back(p->snapshot());
+    return out;
+}
+
+std::vector<std::string> TargetScheduler::describeQueues() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return { due_.describe(ProbeClass::Critical), due_.describe(ProbeClass::Monitor) };
+}
+
+// ---------- TIMING WHEEL ----------
+void TargetScheduler::tickLoop() {
+    using Clock = std::chrono::steady_clock;
+    const auto start = epoch_;
+    while (running_.load()) {
+        uint64_t next;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            next = tick_ + 1;
+        }
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(next * opts_.tickMs));
+
+        bool any = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            uint64_t nowTick = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count() / opts_.tickMs;
+            while (tick_ < nowTick) {
+                tick_++;
+                std::vector<WheelRef>& slot = wheel_[tick_ % wheel_.size()];
+                for (size_t i = 0; i < slot.size();) {
+                    const WheelRef& ref = slot[i];
+                    bool dead = stale(ref);
+                    if (!dead && ref.dueTick > tick_) {
+                        i++;                    // Due on a later lap
+                        continue;
+                    }
+                    if (!dead) due_.push(store_.priority(ref.id), ref, start + std::chrono::milliseconds(ref.dueTick * opts_.tickMs));
+                    slot[i] = slot.back();
+                    slot.pop_back();
+                }
+            }
+            any = !due_.empty();
+        }
+        if (any) workCv_.notify_all();
+    }
+}
+
+// ---------- PROBING ----------
+void TargetScheduler::workerLoop(size_t worker) {
+    struct Job {
+        WheelRef ref;
+        TargetConfig cfg;
+        ProbeStatus status;
+        float rttMs;
+    };
+    std::vector<Job> jobs;
+    std::vector<TargetCheck> events;
+    std::vector<size_t> connects;
+    std::vector<size_t> slow;
+    std::vector<std::thread> helpers;
+    std::vector<ProbeTarget> targets;
+    ProbeEngine engine(ProbeBackend::Epoll, opts_.window, 500);    // Reused: its contexts are pooled
+    engine.setPerfSink(perf_[worker].get());
+
+    while (true) {
+        jobs.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workCv_.wait(lock, [&]() { return !running_.load() || !due_.empty(); });
+            if (!running_.load()) return;
+            // Most urgent class first, so a batch fills with critical targets before normal ones
+            WheelRef ref{};
+            size_t slowJobs = 0;
+            while (jobs.size() < opts_.window && slowJobs < kSlowChecksPerBatch && due_.pop(ref)) {
+                if (stale(ref)) continue;
+                jobs.push_back({ ref, store_.cold(ref.id).cfg, ProbeStatus::Error, 0.0f });
+                if (slowCheck(jobs.back().cfg.kind)) slowJobs++;
+            }
+            if (!due_.empty()) workCv_.notify_one();    // More than one batch is due
+        }
+
+        // http / tls checks block for up to their timeout each: they run side by side on helper
+        // threads while this thread drives the connect probes, and a batch holds at most
+        // kSlowChecksPerBatch of them
+        connects.clear();
+        slow.clear();
+        for (size_t i = 0; i < jobs.size(); i++) {
+            if (slowCheck(jobs[i].cfg.kind)) slow.push_back(i);
+            else connects.push_back(i);
+        }
+        helpers.clear();
+        for (size_t s : slow) helpers.emplace_back([&jobs, s]() { runSlowCheck(jobs[s].cfg, jobs[s].status, jobs[s].rttMs); });
+
+        // Connect probes share one engine run per distinct timeout
+        std::sort(connects.begin(), connects.end(),
+            [&](size_t a, size_t b) { return jobs[a].cfg.timeoutMs < jobs[b].cfg.timeoutMs; });
+        for (size_t g = 0; g < connects.size();) {
+            const int timeoutMs = jobs[connects[g]].cfg.timeoutMs;
+            size_t end = g;
+            targets.clear();
+            for (; end < connects.size() && jobs[connects[end]].cfg.timeoutMs == timeoutMs; end++) {
+                ProbeTarget t;
+                t.addr = jobs[connects[end]].cfg.addr;
+                t.port = jobs[connects[end]].cfg.port;
+                targets.push_back(t);
+            }
+            engine.setTimeoutMs(timeoutMs);
+            const size_t* group = connects.data() + g;
+            engine.run(targets, [&jobs, group](const ProbeResult& r) {
+                Job& j = jobs[group[r.index]];
+                j.status = r.status;
+                j.rttMs = r.rttMs;
+            });
+            g = end;
+        }
+        for (auto& h : helpers) h.join();
+
+        events.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const Job& j : jobs) record(j.ref, j.status, j.rttMs, events);
+        }
+        for (TargetCheck& ev : events) results_.push(worker, std::move(ev));
+    }
+}
+
+// Folds one result into its target and puts the target back on the wheel; caller holds mutex_
+void TargetScheduler::record(const WheelRef& ref, ProbeStatus status, float rttMs, std::vector<TargetCheck>& events) {
+    if (stale(ref)) return;             // Removed or changed meanwhile
+
+    bool up = (status == ProbeStatus::Open);
+    TargetHealth before = store_.health(ref.id);
+    bool changed = store_.record(ref.id, up, rttMs, (uint64_t)unixMsNow());
+    if (changed) {
+        if (before == TargetHealth::Online) online_--;
+        if (store_.health(ref.id) == TargetHealth::Online) online_++;
+    }
+
+    // Fixed rate: stay on the original phase, skipping checks that are already overdue
+    uint64_t interval = std::max<uint64_t>(1, (uint64_t)store_.intervalMs(ref.id) / opts_.tickMs);
+    uint64_t next = ref.dueTick + interval;
+    if (next <= tick_) next += ((tick_ - next) / interval + 1) * interval;
+    schedule(ref.id, next);
+
+    TargetCheck ev;
+    ev.key = store_.cold(ref.id).cfg.key();
+    ev.status = status;
+    ev.up = up;
+    ev.state = store_.status(ref.id);
+    ev.changed = changed;
+    events.push_back(std::move(ev));
+}
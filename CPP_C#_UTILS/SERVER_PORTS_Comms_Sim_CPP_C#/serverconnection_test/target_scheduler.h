@@ -0,0 +1,157 @@
+/*
+ * Multi-Target Scheduler
+ * Author: Alushi
+ * Description:
+ *   - Checks every configured target (target_config.h) on its own interval. Due times live in
+ *     a hashed timing wheel: one tick thread moves due targets onto a run queue, probe workers
+ *     drain it in batches: connect probes through the concurrent engine, http / tls checks (at
+ *     most 16 per batch) each on a helper thread alongside it, so a slow http target costs one
+ *     timeout per batch instead of one per check.
+ *   - Fixed-rate per target: the next check is due one interval after the previous due time,
+ *     not after the probe finished, so phases never drift. New targets start at a phase hashed
+ *     from ip:port, spreading a large file over the interval instead of probing it all at once.
+ *   - apply() takes a config diff: unchanged targets are not touched at all; removed and
+ *     changed ones only bump a generation counter, which makes their old wheel entries stale
+ *     (dropped lazily when the wheel reaches them); added and changed ones get a new entry.
+ *     Work is done in chunks, releasing the lock in between, so probing continues during a
+ *     large reload.
+ *   - Health per target is strike counting: 'threshold' consecutive failures -> Offline.
+ *   - The run queue has one FIFO per priority class (probe_priority.h): priority=critical targets
+ *     are taken before normal ones whenever checks pile up, strictly or weighted-fair
+ *     (TargetSchedulerOptions::dispatch). Queue delay (due time -> picked up by a worker) is
+ *     tracked per class.
+ *   - That ordering only applies within this scheduler's own queue and workers. Scans and
+ *     on-demand tests never enter it: they run on the separate ProbeJobRunner pool
+ *     (probe_jobs.h). A large scan cannot delay outage detection because of that separation,
+ *     not because of any dispatch priority shared between the two.
+ *   - Per-target state lives in a struct-of-arrays TargetStore (target_store.h) under dense
+ *     ids; the wheel and run queue only carry ids.
+ *   - saveState() / restoreState() carry health, failures, srtt and the due phase of every
+ *     target across a restart (--snapshot); the first apply() after a restore seeds the targets
+ *     it adds from them instead of starting Unknown at a hashed phase.
+ *   - Results leave the workers through a lock-free queue per worker (result_pipeline.h); the
+ *     stages added with addStage() run in batches on the pipeline's aggregator thread, so slow
+ *     consumers never hold up probing.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "perf_counters.h"
+#include "probe_engine.h"
+#include "probe_priority.h"
+#include "result_pipeline.h"
+#include "status_board.h"
+#include "target_config.h"
+#include "target_store.h"
+
+struct TargetSchedulerOptions {
+    int tickMs = 10;
+    size_t wheelSlots = 4096;       // Entries further out than slots * tick wait for extra laps
+    int workers = 4;
+    size_t window = 256;            // Connect probes in flight per worker
+    size_t resultQueue = 4096;      // Results buffered per worker before the overflow policy applies
+    OverflowPolicy overflow = OverflowPolicy::DropOldest;   // Never drops Online <-> Offline transitions
+    DispatchPolicy dispatch = DispatchPolicy::Strict;
+};
+
+// Outcome of one scheduled check, handed to the pipeline stages
+struct TargetCheck {
+    std::string key;                // "ip:port"
+    ProbeStatus status = ProbeStatus::Error;
+    bool up = false;
+    TargetStatus state;             // After this check
+    bool changed = false;           // Online <-> Offline transition
+};
+
+// One target's hot state as saved in a snapshot (state_snapshot.h)
+struct TargetResume {
+    char key[48];                   // "ip:port"; longer keys are not saved
+    uint8_t health;                 // TargetHealth
+    uint8_t reserved;
+    uint16_t failures;              // Consecutive
+    float srttMs;
+    int64_t dueInMs;                // Until the next check, at save time; restart downtime is not counted
+};
+
+static_assert(sizeof(TargetResume) == 64, "target snapshot layout changed");
+
+class TargetScheduler {
+public:
+    explicit TargetScheduler(TargetSchedulerOptions opts);
+    ~TargetScheduler();
+
+    TargetScheduler(const TargetScheduler&) = delete;
+    TargetScheduler& operator=(const TargetScheduler&) = delete;
+
+    // Consumers of check results, run on the aggregator thread in registration order; before start()
+    void addStage(const std::string& name, ResultPipeline<TargetCheck>::Stage stage) { results_.addStage(name, std::move(stage)); }
+
+    void start();
+    void stop();
+
+    void apply(const TargetConfigDiff& diff);
+
+    // Saved state of every target, and seeds for the next apply() from such a list
+    std::vector<TargetResume> saveState() const;
+    void restoreState(const TargetResume* saved, size_t count);
+
+    size_t size() const;
+    size_t online() const;
+    // "targets=<n> online=<n> offline=<n> unknown=<n> overdue=<n>"
+    std::string summary() const;
+    // Targets whose check is more than a second behind schedule (sweeps the due-time array)
+    size_t overdue() const;
+    // Up to 'max' "ip:port online|offline probe rtt=.. failures=.." lines, in key order
+    std::vector<std::string> describe(size_t max) const;
+    // Per-worker queue depth / drops and per-stage time
+    std::vector<std::string> describePipeline() const;
+    // Run queue depth and queue delay of the critical and monitor classes
+    std::vector<std::string> describeQueues() const;
+    // Counters of each worker's connect-probe engine loop (--perf)
+    std::vector<PerfTotals> perfTotals() const;
+
+private:
+    struct WheelRef {
+        TargetId id;
+        uint32_t generation;
+        uint64_t dueTick;
+    };
+
+    void tickLoop();
+    void workerLoop(size_t worker);
+    void schedule(TargetId id, uint64_t dueTick);
+    bool stale(const WheelRef& ref) const { return !store_.live(ref.id) || store_.generation(ref.id) != ref.generation; }
+    uint64_t initialTick(const TargetConfig& cfg) const;
+    void record(const WheelRef& ref, ProbeStatus status, float rttMs, std::vector<TargetCheck>& events);
+
+    TargetSchedulerOptions opts_;
+    ResultPipeline<TargetCheck> results_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCv_;
+    TargetStore store_;
+    std::unordered_map<std::string, TargetId> byKey_;
+    std::vector<std::vector<WheelRef>> wheel_;
+    ClassQueues<WheelRef> due_;
+    std::chrono::steady_clock::time_point epoch_;   // Tick 0
+    uint64_t tick_ = 0;
+    size_t online_ = 0;
+    std::unordered_map<std::string, TargetResume> resume_;  // From restoreState(), until the next apply()
+
+    std::atomic<bool> running_{ false };
+    std::thread tickThread_;
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<PerfAccumulator>> perf_;   // One per worker
+};
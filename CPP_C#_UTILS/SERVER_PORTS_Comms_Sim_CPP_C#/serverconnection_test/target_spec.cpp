@@ -0,0 +1,142 @@
+/*
+ * Target Spec Reader
+ * Author: Alushi
+ * Description:
+ *   - See target_spec.h.
+ */
+
+#include "target_spec.h"
+
+#include <cctype>
+#include <cstdlib>
+
+#include "socket_util.h"
+
+namespace {
+
+bool parseIp(const std::string& s, uint32_t& hostOrder) {
+    in_addr a{};
+    if (inet_pton(AF_INET, s.c_str(), &a) != 1) return false;
+    hostOrder = ntohl(a.s_addr);
+    return true;
+}
+
+bool parseNumber(const std::string& s, long lo, long hi, long& out) {
+    if (s.empty() || s.size() > 10) return false;
+    for (char c : s)
+        if (!std::isdigit((unsigned char)c)) return false;
+    out = std::strtol(s.c_str(), nullptr, 10);
+    return out >= lo && out <= hi;
+}
+
+} // namespace
+
+bool parsePortList(const std::string& spec, std::vector<std::pair<uint16_t, uint16_t>>& out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t comma = spec.find(',', pos);
+        std::string item = spec.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t dash = item.find('-');
+        long lo, hi;
+        if (!parseNumber(item.substr(0, dash), 1, 65535, lo)) return false;
+        hi = lo;
+        if (dash != std::string::npos && !parseNumber(item.substr(dash + 1), lo, 65535, hi)) return false;
+        out.emplace_back((uint16_t)lo, (uint16_t)hi);
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return !out.empty();
+}
+
+TargetSpecReader::TargetSpecReader(std::istream& in, std::vector<std::pair<uint16_t, uint16_t>> defaultPorts)
+    : in_(in), defaultPorts_(std::move(defaultPorts)) {}
+
+bool TargetSpecReader::next(ProbeTarget& out) {
+    while (!active_) {
+        if (!loadSpec()) return false;
+    }
+
+    out.addr = htonl(hostCur_);
+    out.port = (uint16_t)portCur_;
+
+    // Advance: ports inner, hosts outer
+    if (portCur_ < ports_[portRange_].second) {
+        portCur_++;
+    }
+    else if (++portRange_ < ports_.size()) {
+        portCur_ = ports_[portRange_].first;
+    }
+    else if (hostCur_ < hostEnd_) {
+        hostCur_++;
+        portRange_ = 0;
+        portCur_ = ports_[0].first;
+    }
+    else {
+        active_ = false;
+    }
+    return true;
+}
+
+// Pulls the next whitespace-separated token (reading lines as needed) and parses it
+bool TargetSpecReader::loadSpec() {
+    while (true) {
+        while (linePos_ < line_.size() && std::isspace((unsigned char)line_[linePos_])) linePos_++;
+        if (linePos_ >= line_.size() || line_[linePos_] == '#') {
+            if (!std::getline(in_, line_)) return false;
+            linePos_ = 0;
+            continue;
+        }
+        size_t end = linePos_;
+        while (end < line_.size() && !std::isspace((unsigned char)line_[end]) && line_[end] != '#') end++;
+        std::string token = line_.substr(linePos_, end - linePos_);
+        linePos_ = end;
+
+        specs_++;
+        if (parseSpec(token)) return true;
+        badSpecs_++;
+        lastError_ = "bad target spec: " + token;
+    }
+}
+
+bool TargetSpecReader::parseSpec(const std::string& token) {
+    size_t colon = token.find(':');
+    std::string hosts = token.substr(0, colon);
+    if (colon == std::string::npos) ports_ = defaultPorts_;
+    else if (!parsePortList(token.substr(colon + 1), ports_)) return false;
+    if (ports_.empty()) return false;
+
+    size_t slash = hosts.find('/');
+    size_t dash = hosts.find('-');
+    if (slash != std::string::npos) {
+        uint32_t base;
+        long bits;
+        if (!parseIp(hosts.substr(0, slash), base) || !parseNumber(hosts.substr(slash + 1), 0, 32, bits)) return false;
+        uint32_t mask = bits == 0 ? 0 : ~0u << (32 - bits);
+        hostCur_ = base & mask;
+        hostEnd_ = hostCur_ | ~mask;
+        if (bits < 31) {
+            hostCur_++;
+            hostEnd_--;
+        }
+    }
+    else if (dash != std::string::npos) {
+        if (!parseIp(hosts.substr(0, dash), hostCur_)) return false;
+        std::string last = hosts.substr(dash + 1);
+        long octet;
+        if (parseNumber(last, 0, 255, octet)) hostEnd_ = (hostCur_ & 0xFFFFFF00u) | (uint32_t)octet;
+        else if (!parseIp(last, hostEnd_)) return false;
+        if (hostEnd_ < hostCur_) return false;
+    }
+    else if (!parseIp(hosts, hostCur_)) {
+        return false;
+    }
+    else {
+        hostEnd_ = hostCur_;
+    }
+
+    portRange_ = 0;
+    portCur_ = ports_[0].first;
+    active_ = true;
+    return true;
+}
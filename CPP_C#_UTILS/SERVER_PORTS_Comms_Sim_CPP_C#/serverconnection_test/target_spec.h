@@ -0,0 +1,60 @@
+/*
+ * Target Spec Reader
+ * Author: Alushi
+ * Description:
+ *   - Turns a stream of target specs into probe targets one at a time, so a file
+ *     of /16s expands lazily instead of into a giant vector.
+ *   - Spec grammar (whitespace separated, '#' starts a comment):
+ *       <hosts>[:<ports>]
+ *       hosts: 10.0.0.1 | 10.0.0.0/24 | 10.0.0.1-10.0.0.50 | 10.0.0.1-50
+ *       ports: 80 | 8000-8100 | 22,80,443,8000-8010
+ *     Hosts without ports use the default port list.
+ *   - /31 and /32 include every address; larger CIDR blocks skip the network and
+ *     broadcast addresses.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "probe_engine.h"
+
+// Parses "22,80,8000-8010"; false on any malformed or out-of-range entry
+bool parsePortList(const std::string& spec, std::vector<std::pair<uint16_t, uint16_t>>& out);
+
+class TargetSpecReader {
+public:
+    TargetSpecReader(std::istream& in, std::vector<std::pair<uint16_t, uint16_t>> defaultPorts);
+
+    // Next target in spec order (hosts outer, ports inner); false at end of input
+    bool next(ProbeTarget& out);
+
+    uint64_t specs() const { return specs_; }
+    uint64_t badSpecs() const { return badSpecs_; }
+    const std::string& lastError() const { return lastError_; }
+
+private:
+    bool loadSpec();
+    bool parseSpec(const std::string& token);
+
+    std::istream& in_;
+    std::vector<std::pair<uint16_t, uint16_t>> defaultPorts_;
+    std::string line_;
+    size_t linePos_ = 0;
+
+    // Expansion state of the current spec; addresses in host byte order
+    uint32_t hostCur_ = 0;
+    uint32_t hostEnd_ = 0;
+    std::vector<std::pair<uint16_t, uint16_t>> ports_;
+    size_t portRange_ = 0;
+    uint32_t portCur_ = 0;
+    bool active_ = false;
+
+    uint64_t specs_ = 0;
+    uint64_t badSpecs_ = 0;
+    std::string lastError_;
+};
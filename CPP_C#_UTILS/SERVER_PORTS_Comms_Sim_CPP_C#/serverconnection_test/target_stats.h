@@ -0,0 +1,51 @@
+/*
+ * Per-Target Probe Statistics
+ * Author: Alushi
+ * Description:
+ *   - Running latency aggregates (count / min / avg / max / last) per probe phase.
+ *   - Fixed size, updated in place; no history is kept here.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+struct PhaseStats {
+    uint64_t count = 0;
+    double sumMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    double lastMs = 0.0;
+
+    void record(double ms) {
+        if (count == 0 || ms < minMs) minMs = ms;
+        if (count == 0 || ms > maxMs) maxMs = ms;
+        sumMs += ms;
+        lastMs = ms;
+        count++;
+    }
+
+    double avgMs() const { return count ? sumMs / count : 0.0; }
+};
+
+struct TargetStats {
+    uint64_t probes = 0;
+    uint64_t failures = 0;
+    uint64_t reusedConnections = 0;
+
+    PhaseStats connect;     // TCP connect (skipped when a pooled connection is reused)
+    PhaseStats firstByte;   // Request sent -> first response byte
+    PhaseStats complete;    // Request sent -> full response received
+
+    // TLS probes
+    uint64_t resumedSessions = 0;
+    PhaseStats serverHello; // ClientHello sent -> ServerHello received
+    PhaseStats handshake;   // ClientHello sent -> handshake complete
+    double certDaysLeft = 0.0;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const PhaseStats& p) {
+    return os << "n=" << p.count << " last=" << p.lastMs << " min=" << p.minMs
+        << " avg=" << p.avgMs() << " max=" << p.maxMs << " ms";
+}
@@ -0,0 +1,192 @@
+/*
+ * Struct-of-Arrays Target Store
+ * Author: Alushi
+ * Description:
+ *   - See target_store.h.
+ */
+
+#include "target_store.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const uint64_t kNever = UINT64_MAX;    // Due tick of free and unscheduled ids: no sweep picks them up
+const uint64_t kOnes = 0x0101010101010101ull;
+
+uint16_t clampThreshold(int threshold) {
+    return (uint16_t)std::min(std::max(threshold, 1), 65535);
+}
+
+size_t stringHeap(const std::string& s) {
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;     // Beyond the small-string buffer
+}
+
+} // namespace
+
+TargetId TargetStore::add(const TargetConfig& cfg) {
+    TargetId id;
+    if (!free_.empty()) {
+        id = free_.back();
+        free_.pop_back();
+    }
+    else {
+        id = (TargetId)dueTick_.size();
+        dueTick_.push_back(kNever);
+        state_.push_back(0);
+        failures_.push_back(0);
+        threshold_.push_back(0);
+        srttMs_.push_back(0.0f);
+        generation_.push_back(0);
+        addr_.push_back(0);
+        port_.push_back(0);
+        intervalMs_.push_back(0);
+        cold_.emplace_back();
+    }
+    dueTick_[id] = kNever;
+    state_[id] = (uint8_t)(kLive | (uint8_t)cfg.priority << kClassShift | (uint8_t)TargetHealth::Unknown);
+    failures_[id] = 0;
+    threshold_[id] = clampThreshold(cfg.failureThreshold);
+    srttMs_[id] = 0.0f;
+    generation_[id]++;
+    addr_[id] = cfg.addr;
+    port_[id] = cfg.port;
+    intervalMs_[id] = (uint32_t)cfg.intervalMs;
+    cold_[id] = TargetColdInfo();
+    cold_[id].cfg = cfg;
+    live_++;
+    return id;
+}
+
+void TargetStore::remove(TargetId id) {
+    if (!live(id)) return;
+    state_[id] = 0;
+    dueTick_[id] = kNever;
+    generation_[id]++;
+    cold_[id] = TargetColdInfo();   // Drop the strings now, not when the id is reused
+    free_.push_back(id);
+    live_--;
+}
+
+void TargetStore::reconfigure(TargetId id, const TargetConfig& cfg) {
+    state_[id] = (uint8_t)((state_[id] & ~kClassMask) | (uint8_t)cfg.priority << kClassShift);
+    threshold_[id] = clampThreshold(cfg.failureThreshold);
+    intervalMs_[id] = (uint32_t)cfg.intervalMs;
+    generation_[id]++;
+    cold_[id].cfg = cfg;
+}
+
+void TargetStore::reserve(size_t targets) {
+    dueTick_.reserve(targets);
+    state_.reserve(targets);
+    failures_.reserve(targets);
+    threshold_.reserve(targets);
+    srttMs_.reserve(targets);
+    generation_.reserve(targets);
+    addr_.reserve(targets);
+    port_.reserve(targets);
+    intervalMs_.reserve(targets);
+    cold_.reserve(targets);
+}
+
+void TargetStore::restore(TargetId id, TargetHealth health, uint16_t failures, float srttMs) {
+    setHealth(id, health);
+    failures_[id] = failures;
+    srttMs_[id] = srttMs;
+}
+
+bool TargetStore::record(TargetId id, bool up, float rttMs, uint64_t nowUnixMs) {
+    TargetColdInfo& c = cold_[id];
+    TargetHealth before = health(id);
+    c.probes++;
+    c.lastCheckUnixMs = nowUnixMs;
+    if (up) {
+        failures_[id] = 0;
+        // RFC 6298 smoothing (alpha 1/8); the first answer seeds it
+        srttMs_[id] = srttMs_[id] == 0.0f ? rttMs : srttMs_[id] + (rttMs - srttMs_[id]) / 8.0f;
+        setHealth(id, TargetHealth::Online);
+    }
+    else {
+        c.failures++;
+        if (failures_[id] < 65535) failures_[id]++;
+        if (failures_[id] >= threshold_[id]) setHealth(id, TargetHealth::Offline);
+    }
+    if (health(id) == before) return false;
+    c.lastChangeUnixMs = nowUnixMs;
+    return true;
+}
+
+TargetStatus TargetStore::status(TargetId id) const {
+    const TargetColdInfo& c = cold_[id];
+    TargetStatus s;
+    s.addr = addr_[id];
+    s.port = port_[id];
+    s.health = health(id);
+    s.consecutiveFailures = failures_[id];
+    s.rttMs = srttMs_[id];
+    s.lastCheckUnixMs = c.lastCheckUnixMs;
+    s.lastChangeUnixMs = c.lastChangeUnixMs;
+    s.probes = c.probes;
+    s.failures = c.failures;
+    return s;
+}
+
+// ---------- SWEEPS ----------
+// Free ids are due at kNever, so the due-time sweeps read nothing but the due array
+size_t TargetStore::collectDue(uint64_t tick, std::vector<TargetId>& out) const {
+    const size_t n = dueTick_.size();
+    const uint64_t* due = dueTick_.data();
+    size_t found = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (due[i] <= tick) {
+            out.push_back((TargetId)i);
+            found++;
+        }
+    }
+    return found;
+}
+
+size_t TargetStore::countOverdue(uint64_t tick, uint64_t lagTicks) const {
+    if (tick <= lagTicks) return 0;
+    const uint64_t limit = tick - lagTicks;
+    const size_t n = dueTick_.size();
+    const uint64_t* due = dueTick_.data();
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) count += due[i] < limit;
+    return count;
+}
+
+// Eight state bytes per step: XOR with the wanted value, then count the bytes that became zero
+size_t TargetStore::countHealth(TargetHealth h) const {
+    const uint8_t mask = kLive | kHealthMask;
+    const uint8_t want = kLive | (uint8_t)h;
+    const uint8_t* state = state_.data();
+    const size_t n = state_.size();
+    size_t count = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, state + i, 8);
+        uint64_t x = (word & (mask * kOnes)) ^ (want * kOnes);
+        uint64_t zero = ~(((x & (0x7F * kOnes)) + 0x7F * kOnes) | x | (0x7F * kOnes));  // 0x80 per zero byte
+        count += (size_t)(((zero >> 7) * kOnes) >> 56);
+    }
+    for (; i < n; i++) count += ((state[i] & mask) == want);
+    return count;
+}
+
+size_t TargetStore::hotBytesPerTarget() {
+    return sizeof(uint64_t) + sizeof(uint8_t) + 2 * sizeof(uint16_t) + sizeof(float)
+        + 2 * sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint32_t);
+}
+
+size_t TargetStore::memoryBytes() const {
+    size_t bytes = dueTick_.capacity() * sizeof(uint64_t) + state_.capacity() + failures_.capacity() * sizeof(uint16_t)
+        + threshold_.capacity() * sizeof(uint16_t) + srttMs_.capacity() * sizeof(float)
+        + generation_.capacity() * sizeof(uint32_t) + addr_.capacity() * sizeof(uint32_t)
+        + port_.capacity() * sizeof(uint16_t) + intervalMs_.capacity() * sizeof(uint32_t)
+        + cold_.capacity() * sizeof(TargetColdInfo) + free_.capacity() * sizeof(TargetId);
+    for (const TargetColdInfo& c : cold_)
+        bytes += stringHeap(c.cfg.ip) + stringHeap(c.cfg.httpPath) + stringHeap(c.cfg.sni);
+    return bytes;
+}
@@ -0,0 +1,104 @@
+/*
+ * Struct-of-Arrays Target Store
+ * Author: Alushi
+ * Description:
+ *   - Registry of monitored host:port targets with dense integer ids, sized for about a
+ *     million entries. Freed ids are reused, so id space stays as small as the live set.
+ *   - Hot fields - next due tick, state bits (live, health, priority class), consecutive failures, smoothed RTT, generation,
+ *     address, port, interval, threshold - each live in their own contiguous array (31 bytes
+ *     per target together). Sweeps over one field (due times, health) read only
+ *     that array, front to back, a cache line of targets at a time.
+ *   - Cold fields - the configuration with the target's name and probe settings, and the
+ *     lifetime counters - sit in a separate array only touched when a target is probed,
+ *     reconfigured or printed.
+ *   - Not synchronized; the owner (TargetScheduler) holds its lock around every call.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "status_board.h"
+#include "target_config.h"
+
+using TargetId = uint32_t;
+
+struct TargetColdInfo {
+    TargetConfig cfg;
+    uint64_t lastCheckUnixMs = 0;
+    uint64_t lastChangeUnixMs = 0;
+    uint64_t probes = 0;
+    uint64_t failures = 0;
+};
+
+class TargetStore {
+public:
+    // Reuses a freed id when there is one; the target starts Unknown, not scheduled
+    TargetId add(const TargetConfig& cfg);
+    // The id becomes free; its generation changes, so references held elsewhere go stale
+    void remove(TargetId id);
+    // New settings for a live target; health and counters are kept, the generation changes
+    void reconfigure(TargetId id, const TargetConfig& cfg);
+
+    size_t size() const { return live_; }
+    size_t idLimit() const { return dueTick_.size(); }   // Every id is below this
+    void reserve(size_t targets);
+
+    bool live(TargetId id) const { return (state_[id] & kLive) != 0; }
+    TargetHealth health(TargetId id) const { return (TargetHealth)(state_[id] & kHealthMask); }
+    ProbeClass priority(TargetId id) const { return (ProbeClass)((state_[id] & kClassMask) >> kClassShift); }
+    uint32_t generation(TargetId id) const { return generation_[id]; }
+    uint64_t dueTick(TargetId id) const { return dueTick_[id]; }
+    void setDueTick(TargetId id, uint64_t tick) { dueTick_[id] = tick; }
+    uint32_t intervalMs(TargetId id) const { return intervalMs_[id]; }
+    uint16_t failures(TargetId id) const { return failures_[id]; }
+    float srttMs(TargetId id) const { return srttMs_[id]; }
+    const TargetColdInfo& cold(TargetId id) const { return cold_[id]; }
+
+    // Saved health, consecutive failures and srtt carried over to a live target (warm restart)
+    void restore(TargetId id, TargetHealth health, uint16_t failures, float srttMs);
+
+    // Folds one check into the target; true when its health changed
+    bool record(TargetId id, bool up, float rttMs, uint64_t nowUnixMs);
+
+    // Hot and cold fields reassembled into the status-board layout
+    TargetStatus status(TargetId id) const;
+
+    // ---------- SWEEPS ----------
+    // Scheduled live targets due at or before 'tick', appended to 'out' in id order
+    size_t collectDue(uint64_t tick, std::vector<TargetId>& out) const;
+    // Live targets due more than 'lagTicks' before 'tick' (the scheduler is falling behind)
+    size_t countOverdue(uint64_t tick, uint64_t lagTicks) const;
+    size_t countHealth(TargetHealth health) const;
+
+    // Bytes held per id slot by the hot arrays, and everything including cold strings
+    static size_t hotBytesPerTarget();
+    size_t memoryBytes() const;
+
+private:
+    static const uint8_t kHealthMask = 0x03;
+    static const uint8_t kClassMask = 0x0C;
+    static const uint8_t kClassShift = 2;
+    static const uint8_t kLive = 0x80;
+
+    void setHealth(TargetId id, TargetHealth h) { state_[id] = (uint8_t)((state_[id] & ~kHealthMask) | (uint8_t)h); }
+
+    // Hot, one array per field
+    std::vector<uint64_t> dueTick_;
+    std::vector<uint8_t> state_;            // kLive | ProbeClass << kClassShift | TargetHealth
+    std::vector<uint16_t> failures_;        // Consecutive, saturating
+    std::vector<uint16_t> threshold_;
+    std::vector<float> srttMs_;             // 0 until the first answered check
+    std::vector<uint32_t> generation_;
+    std::vector<uint32_t> addr_;
+    std::vector<uint16_t> port_;
+    std::vector<uint32_t> intervalMs_;
+
+    // Cold
+    std::vector<TargetColdInfo> cold_;
+
+    std::vector<TargetId> free_;
+    size_t live_ = 0;
+};
@@ -0,0 +1,207 @@
+/*
+ * TLS Handshake Timing Probe
+ * Author: Alushi
+ * Description:
+ *   - See tls_probe.h. Without PROBE_WITH_OPENSSL only the stats helper is compiled.
+ */
+
+#include "tls_probe.h"
+
+void recordTlsProbe(TargetStats& stats, const TlsProbeResult& res) {
+    stats.probes++;
+    if (!res.ok) stats.failures++;
+    if (res.resumed) stats.resumedSessions++;
+    if (res.connectMs > 0.0) stats.connect.record(res.connectMs);
+    if (res.serverHelloMs > 0.0) stats.serverHello.record(res.serverHelloMs);
+    if (res.ok) stats.handshake.record(res.handshakeMs);
+    if (res.hasCert) stats.certDaysLeft = res.certDaysLeft;
+}
+
+#ifdef PROBE_WITH_OPENSSL
+
+#include <chrono>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include "socket_util.h"
+
+#ifdef _WIN32
+#pragma comment(lib, "libssl.lib")
+#pragma comment(lib, "libcrypto.lib")
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Filled from the message callback while the handshake is in flight
+struct HandshakeTimeline {
+    Clock::time_point clientHello;
+    Clock::time_point serverHello;
+    bool sawClientHello = false;
+    bool sawServerHello = false;
+};
+
+void onTlsMessage(int writeP, int /*version*/, int contentType, const void* buf, size_t len, SSL* /*ssl*/, void* arg) {
+    if (contentType != SSL3_RT_HANDSHAKE || len == 0) return;
+    auto* t = static_cast<HandshakeTimeline*>(arg);
+    unsigned char msgType = static_cast<const unsigned char*>(buf)[0];
+
+    if (writeP && msgType == SSL3_MT_CLIENT_HELLO && !t->sawClientHello) {
+        t->clientHello = Clock::now();
+        t->sawClientHello = true;
+    }
+    else if (!writeP && msgType == SSL3_MT_SERVER_HELLO && !t->sawServerHello) {
+        t->serverHello = Clock::now();
+        t->sawServerHello = true;
+    }
+}
+
+int onNewSession(SSL* ssl, SSL_SESSION* session) {
+    auto* probe = static_cast<TlsHandshakeProbe*>(SSL_get_app_data(ssl));
+    if (!probe) return 0;
+    probe->storeSession(session);
+    return 1;   // We now own the reference
+}
+
+std::string lastSslError() {
+    unsigned long code = ERR_get_error();
+    if (code == 0) return "handshake failed";
+    char buf[256];
+    ERR_error_string_n(code, buf, sizeof(buf));
+    ERR_clear_error();
+    return buf;
+}
+
+double msBetween(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+} // namespace
+
+TlsHandshakeProbe::TlsHandshakeProbe(const std::string& ip, int port, TlsProbeOptions opts)
+    : ip_(ip), port_(port), opts_(std::move(opts)) {
+    ctx_ = SSL_CTX_new(TLS_client_method());
+    if (!ctx_) return;
+
+    // Timing only: the chain is not validated, so self-signed stand-ins work too
+    SSL_CTX_set_verify(ctx_, SSL_VERIFY_NONE, nullptr);
+
+    // Capture tickets through the callback; TLS 1.3 sends them after the handshake completes
+    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx_, onNewSession);
+}
+
+TlsHandshakeProbe::~TlsHandshakeProbe() {
+    if (session_) SSL_SESSION_free(session_);
+    if (ctx_) SSL_CTX_free(ctx_);
+}
+
+void TlsHandshakeProbe::storeSession(SSL_SESSION* session) {
+    if (!opts_.reuseSession || !SSL_SESSION_is_resumable(session)) {
+        SSL_SESSION_free(session);
+        return;
+    }
+    if (session_) SSL_SESSION_free(session_);
+    session_ = session;
+}
+
+TlsProbeResult TlsHandshakeProbe::probe(TargetStats* stats) {
+    TlsProbeResult res;
+    auto finish = [&]() {
+        if (stats) recordTlsProbe(*stats, res);
+        return res;
+    };
+
+    if (!ctx_) {
+        res.error = "SSL_CTX_new failed";
+        return finish();
+    }
+
+    // ---- TCP connect ----
+    auto start = Clock::now();
+    socket_t s = connectWithTimeout(ip_, port_, opts_.connectTimeoutMs);
+    res.connectMs = elapsedMs(start);
+    if (s == kInvalidSocket) {
+        res.error = "connect failed";
+        res.connectMs = 0.0;
+        return finish();
+    }
+
+    SSL* ssl = SSL_new(ctx_);
+    SSL_set_fd(ssl, (int)s);
+    SSL_set_app_data(ssl, this);
+    if (!opts_.serverName.empty()) SSL_set_tlsext_host_name(ssl, opts_.serverName.c_str());
+    if (opts_.reuseSession && session_) SSL_set_session(ssl, session_);
+
+    HandshakeTimeline timeline;
+    SSL_set_msg_callback(ssl, onTlsMessage);
+    SSL_set_msg_callback_arg(ssl, &timeline);
+
+    // ---- Handshake ----
+    const auto handshakeStart = Clock::now();
+    auto remaining = [&]() { return opts_.handshakeTimeoutMs - (int)elapsedMs(handshakeStart); };
+
+    while (true) {
+        int r = SSL_connect(ssl);
+        if (r == 1) {
+            res.ok = true;
+            break;
+        }
+        int err = SSL_get_error(ssl, r);
+        bool ready = false;
+        if (err == SSL_ERROR_WANT_READ) ready = waitSocket(s, false, remaining());
+        else if (err == SSL_ERROR_WANT_WRITE) ready = waitSocket(s, true, remaining());
+        if (!ready) {
+            res.error = (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) ? "handshake timeout" : lastSslError();
+            break;
+        }
+    }
+    auto done = Clock::now();
+
+    if (timeline.sawClientHello && timeline.sawServerHello)
+        res.serverHelloMs = msBetween(timeline.clientHello, timeline.serverHello);
+
+    if (res.ok) {
+        res.handshakeMs = msBetween(timeline.sawClientHello ? timeline.clientHello : handshakeStart, done);
+        res.resumed = SSL_session_reused(ssl) == 1;
+        res.protocol = SSL_get_version(ssl);
+        res.cipher = SSL_get_cipher_name(ssl);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        X509* cert = SSL_get1_peer_certificate(ssl);
+#else
+        X509* cert = SSL_get_peer_certificate(ssl);
+#endif
+        if (cert) {
+            int days = 0, secs = 0;
+            if (ASN1_TIME_diff(&days, &secs, nullptr, X509_get0_notAfter(cert))) {
+                res.certDaysLeft = days + secs / 86400.0;
+                res.hasCert = true;
+            }
+            X509_free(cert);
+        }
+
+        // TLS 1.3 tickets trail the server Finished; give them a brief chance to arrive so the
+        // next check can resume. The read itself returns WANT_READ once tickets are consumed.
+        // (TLS 1.2 sessions reach onNewSession during the handshake itself.)
+        if (opts_.reuseSession && SSL_version(ssl) >= TLS1_3_VERSION) {
+            int budget = remaining() < 50 ? remaining() : 50;
+            if (budget > 0 && waitSocket(s, false, budget)) {
+                char sink[256];
+                SSL_read(ssl, sink, sizeof(sink));
+            }
+        }
+
+        SSL_shutdown(ssl);
+    }
+
+    SSL_free(ssl);
+    closeSocket(s);
+    ERR_clear_error();
+    return finish();
+}
+
+#endif // PROBE_WITH_OPENSSL
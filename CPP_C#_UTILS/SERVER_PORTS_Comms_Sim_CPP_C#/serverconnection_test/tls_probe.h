@@ -0,0 +1,67 @@
+/*
+ * TLS Handshake Timing Probe
+ * Author: Alushi
+ * Description:
+ *   - Measures TCP connect, ClientHello -> ServerHello, and full handshake completion separately.
+ *   - Keeps the last session ticket so periodic checks exercise (and time) the resumption path.
+ *   - Reports the peer certificate's expiry as a by-product.
+ *   - Needs the system OpenSSL: build with PROBE_WITH_OPENSSL defined and link libssl/libcrypto.
+ *     Local stand-in: openssl s_server -accept 8443 -cert cert.pem -key key.pem -www
+ */
+
+#pragma once
+
+#include <string>
+
+#include "target_stats.h"
+
+struct TlsProbeOptions {
+    std::string serverName;         // SNI; empty sends none
+    int connectTimeoutMs = 500;
+    int handshakeTimeoutMs = 2000;  // Measured from the moment the TCP connect completes
+    bool reuseSession = true;       // Offer the previous session ticket on the next check
+};
+
+struct TlsProbeResult {
+    bool ok = false;                // Handshake completed
+    bool resumed = false;           // Server accepted the offered session
+    double connectMs = 0.0;         // TCP connect
+    double serverHelloMs = 0.0;     // ClientHello sent -> ServerHello received
+    double handshakeMs = 0.0;       // ClientHello sent -> handshake complete
+    std::string protocol;           // e.g. "TLSv1.3"
+    std::string cipher;
+    double certDaysLeft = 0.0;      // Peer certificate notAfter - now (negative once expired)
+    bool hasCert = false;
+    std::string error;
+};
+
+// Folds one probe result into a target's TLS statistics
+void recordTlsProbe(TargetStats& stats, const TlsProbeResult& res);
+
+#ifdef PROBE_WITH_OPENSSL
+
+typedef struct ssl_ctx_st SSL_CTX;
+typedef struct ssl_session_st SSL_SESSION;
+
+class TlsHandshakeProbe {
+public:
+    TlsHandshakeProbe(const std::string& ip, int port, TlsProbeOptions opts = {});
+    ~TlsHandshakeProbe();
+
+    TlsHandshakeProbe(const TlsHandshakeProbe&) = delete;
+    TlsHandshakeProbe& operator=(const TlsHandshakeProbe&) = delete;
+
+    TlsProbeResult probe(TargetStats* stats = nullptr);
+
+    // Called by OpenSSL when the server issues a ticket (possibly after the handshake)
+    void storeSession(SSL_SESSION* session);
+
+private:
+    std::string ip_;
+    int port_;
+    TlsProbeOptions opts_;
+    SSL_CTX* ctx_ = nullptr;
+    SSL_SESSION* session_ = nullptr;
+};
+
+#endif // PROBE_WITH_OPENSSL